@@ -16,12 +16,19 @@ struct Color;
 
 struct Mat4;
 
+struct VertexAttribute;
+
+struct Bounds;
+
 struct Texture;
 struct TextureT;
 
 struct Material;
 struct MaterialT;
 
+struct MeshLod;
+struct MeshLodT;
+
 struct Mesh;
 struct MeshT;
 
@@ -109,6 +116,78 @@ inline const char *EnumNameTextureMapMode(TextureMapMode e) {
   return EnumNamesTextureMapMode()[index];
 }
 
+enum VertexUsage {
+  VertexUsage_Position = 0,
+  VertexUsage_Normal = 1,
+  VertexUsage_TexCoord = 2,
+  VertexUsage_Tangent = 3,
+  VertexUsage_MIN = VertexUsage_Position,
+  VertexUsage_MAX = VertexUsage_Tangent
+};
+
+inline const VertexUsage (&EnumValuesVertexUsage())[4] {
+  static const VertexUsage values[] = {
+    VertexUsage_Position,
+    VertexUsage_Normal,
+    VertexUsage_TexCoord,
+    VertexUsage_Tangent
+  };
+  return values;
+}
+
+inline const char * const *EnumNamesVertexUsage() {
+  static const char * const names[] = {
+    "Position",
+    "Normal",
+    "TexCoord",
+    "Tangent",
+    nullptr
+  };
+  return names;
+}
+
+inline const char *EnumNameVertexUsage(VertexUsage e) {
+  if (e < VertexUsage_Position || e > VertexUsage_Tangent) return "";
+  const size_t index = static_cast<int>(e);
+  return EnumNamesVertexUsage()[index];
+}
+
+enum VertexFormat {
+  VertexFormat_Float = 0,
+  VertexFormat_Unorm16 = 1,
+  VertexFormat_Octahedral16 = 2,
+  VertexFormat_Octahedral8 = 3,
+  VertexFormat_MIN = VertexFormat_Float,
+  VertexFormat_MAX = VertexFormat_Octahedral8
+};
+
+inline const VertexFormat (&EnumValuesVertexFormat())[4] {
+  static const VertexFormat values[] = {
+    VertexFormat_Float,
+    VertexFormat_Unorm16,
+    VertexFormat_Octahedral16,
+    VertexFormat_Octahedral8
+  };
+  return values;
+}
+
+inline const char * const *EnumNamesVertexFormat() {
+  static const char * const names[] = {
+    "Float",
+    "Unorm16",
+    "Octahedral16",
+    "Octahedral8",
+    nullptr
+  };
+  return names;
+}
+
+inline const char *EnumNameVertexFormat(VertexFormat e) {
+  if (e < VertexFormat_Float || e > VertexFormat_Octahedral8) return "";
+  const size_t index = static_cast<int>(e);
+  return EnumNamesVertexFormat()[index];
+}
+
 FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) Vec3 FLATBUFFERS_FINAL_CLASS {
  private:
   float x_;
@@ -282,6 +361,75 @@ FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) Mat4 FLATBUFFERS_FINAL_CLASS {
 };
 FLATBUFFERS_STRUCT_END(Mat4, 64);
 
+FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) VertexAttribute FLATBUFFERS_FINAL_CLASS {
+ private:
+  uint16_t usage_;
+  uint16_t channel_;
+  uint16_t format_;
+  uint16_t components_;
+  uint32_t offset_;
+
+ public:
+  VertexAttribute() {
+    memset(this, 0, sizeof(VertexAttribute));
+  }
+  VertexAttribute(VertexUsage _usage, uint16_t _channel, VertexFormat _format, uint16_t _components, uint32_t _offset)
+      : usage_(flatbuffers::EndianScalar(static_cast<uint16_t>(_usage))),
+        channel_(flatbuffers::EndianScalar(_channel)),
+        format_(flatbuffers::EndianScalar(static_cast<uint16_t>(_format))),
+        components_(flatbuffers::EndianScalar(_components)),
+        offset_(flatbuffers::EndianScalar(_offset)) {
+  }
+  VertexUsage usage() const {
+    return static_cast<VertexUsage>(flatbuffers::EndianScalar(usage_));
+  }
+  uint16_t channel() const {
+    return flatbuffers::EndianScalar(channel_);
+  }
+  VertexFormat format() const {
+    return static_cast<VertexFormat>(flatbuffers::EndianScalar(format_));
+  }
+  uint16_t components() const {
+    return flatbuffers::EndianScalar(components_);
+  }
+  uint32_t offset() const {
+    return flatbuffers::EndianScalar(offset_);
+  }
+};
+FLATBUFFERS_STRUCT_END(VertexAttribute, 12);
+
+FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) Bounds FLATBUFFERS_FINAL_CLASS {
+ private:
+  Vec3 lower_;
+  Vec3 upper_;
+  Vec3 center_;
+  float radius_;
+
+ public:
+  Bounds() {
+    memset(this, 0, sizeof(Bounds));
+  }
+  Bounds(const Vec3 &_lower, const Vec3 &_upper, const Vec3 &_center, float _radius)
+      : lower_(_lower),
+        upper_(_upper),
+        center_(_center),
+        radius_(flatbuffers::EndianScalar(_radius)) {
+  }
+  const Vec3 &lower() const {
+    return lower_;
+  }
+  const Vec3 &upper() const {
+    return upper_;
+  }
+  const Vec3 &center() const {
+    return center_;
+  }
+  float radius() const {
+    return flatbuffers::EndianScalar(radius_);
+  }
+};
+FLATBUFFERS_STRUCT_END(Bounds, 40);
+
 struct TextureT : public flatbuffers::NativeTable {
   typedef Texture TableType;
   std::string path;
@@ -674,6 +822,98 @@ inline flatbuffers::Offset<Material> CreateMaterialDirect(
 
 flatbuffers::Offset<Material> CreateMaterial(flatbuffers::FlatBufferBuilder &_fbb, const MaterialT *_o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
 
+struct MeshLodT : public flatbuffers::NativeTable {
+  typedef MeshLod TableType;
+  std::vector<uint16_t> indices;
+  std::vector<uint32_t> indices32;
+  float error;
+  MeshLodT()
+      : error(0.0f) {
+  }
+};
+
+struct MeshLod FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  typedef MeshLodT NativeTableType;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_INDICES = 4,
+    VT_INDICES32 = 6,
+    VT_ERROR = 8
+  };
+  const flatbuffers::Vector<uint16_t> *indices() const {
+    return GetPointer<const flatbuffers::Vector<uint16_t> *>(VT_INDICES);
+  }
+  const flatbuffers::Vector<uint32_t> *indices32() const {
+    return GetPointer<const flatbuffers::Vector<uint32_t> *>(VT_INDICES32);
+  }
+  float error() const {
+    return GetField<float>(VT_ERROR, 0.0f);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyOffset(verifier, VT_INDICES) &&
+           verifier.VerifyVector(indices()) &&
+           VerifyOffset(verifier, VT_INDICES32) &&
+           verifier.VerifyVector(indices32()) &&
+           VerifyField<float>(verifier, VT_ERROR) &&
+           verifier.EndTable();
+  }
+  MeshLodT *UnPack(const flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  void UnPackTo(MeshLodT *_o, const flatbuffers::resolver_function_t *_resolver = nullptr) const;
+  static flatbuffers::Offset<MeshLod> Pack(flatbuffers::FlatBufferBuilder &_fbb, const MeshLodT* _o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
+};
+
+struct MeshLodBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_indices(flatbuffers::Offset<flatbuffers::Vector<uint16_t>> indices) {
+    fbb_.AddOffset(MeshLod::VT_INDICES, indices);
+  }
+  void add_indices32(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> indices32) {
+    fbb_.AddOffset(MeshLod::VT_INDICES32, indices32);
+  }
+  void add_error(float error) {
+    fbb_.AddElement<float>(MeshLod::VT_ERROR, error, 0.0f);
+  }
+  explicit MeshLodBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  MeshLodBuilder &operator=(const MeshLodBuilder &);
+  flatbuffers::Offset<MeshLod> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<MeshLod>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<MeshLod> CreateMeshLod(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    flatbuffers::Offset<flatbuffers::Vector<uint16_t>> indices = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint32_t>> indices32 = 0,
+    float error = 0.0f) {
+  MeshLodBuilder builder_(_fbb);
+  builder_.add_error(error);
+  builder_.add_indices32(indices32);
+  builder_.add_indices(indices);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<MeshLod> CreateMeshLodDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    const std::vector<uint16_t> *indices = nullptr,
+    const std::vector<uint32_t> *indices32 = nullptr,
+    float error = 0.0f) {
+  auto indices__ = indices ? _fbb.CreateVector<uint16_t>(*indices) : 0;
+  auto indices32__ = indices32 ? _fbb.CreateVector<uint32_t>(*indices32) : 0;
+  return ModelData::CreateMeshLod(
+      _fbb,
+      indices__,
+      indices32__,
+      error);
+}
+
+flatbuffers::Offset<MeshLod> CreateMeshLod(flatbuffers::FlatBufferBuilder &_fbb, const MeshLodT *_o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
+
 struct MeshT : public flatbuffers::NativeTable {
   typedef Mesh TableType;
   std::vector<Vec3> positions;
@@ -685,8 +925,15 @@ struct MeshT : public flatbuffers::NativeTable {
   uint32_t material;
   std::vector<Color> colors;
   std::unique_ptr<Mat4> transform;
+  std::vector<uint32_t> indices32;
+  std::vector<uint8_t> vertices;
+  std::vector<VertexAttribute> layout;
+  uint32_t vertexStride;
+  std::vector<std::unique_ptr<MeshLodT>> lods;
+  std::unique_ptr<Bounds> bounds;
   MeshT()
-      : material(0) {
+      : material(0),
+        vertexStride(0) {
   }
 };
 
@@ -701,7 +948,13 @@ struct Mesh FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
     VT_INDICES = 14,
     VT_MATERIAL = 16,
     VT_COLORS = 18,
-    VT_TRANSFORM = 20
+    VT_TRANSFORM = 20,
+    VT_INDICES32 = 22,
+    VT_VERTICES = 24,
+    VT_LAYOUT = 26,
+    VT_VERTEXSTRIDE = 28,
+    VT_LODS = 30,
+    VT_BOUNDS = 32
   };
   const flatbuffers::Vector<const Vec3 *> *positions() const {
     return GetPointer<const flatbuffers::Vector<const Vec3 *> *>(VT_POSITIONS);
@@ -730,6 +983,24 @@ struct Mesh FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   const Mat4 *transform() const {
     return GetStruct<const Mat4 *>(VT_TRANSFORM);
   }
+  const flatbuffers::Vector<uint32_t> *indices32() const {
+    return GetPointer<const flatbuffers::Vector<uint32_t> *>(VT_INDICES32);
+  }
+  const flatbuffers::Vector<uint8_t> *vertices() const {
+    return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_VERTICES);
+  }
+  const flatbuffers::Vector<const VertexAttribute *> *layout() const {
+    return GetPointer<const flatbuffers::Vector<const VertexAttribute *> *>(VT_LAYOUT);
+  }
+  uint32_t vertexStride() const {
+    return GetField<uint32_t>(VT_VERTEXSTRIDE, 0);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<MeshLod>> *lods() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<MeshLod>> *>(VT_LODS);
+  }
+  const Bounds *bounds() const {
+    return GetStruct<const Bounds *>(VT_BOUNDS);
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyOffset(verifier, VT_POSITIONS) &&
@@ -748,6 +1019,17 @@ struct Mesh FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            VerifyOffset(verifier, VT_COLORS) &&
            verifier.VerifyVector(colors()) &&
            VerifyField<Mat4>(verifier, VT_TRANSFORM) &&
+           VerifyOffset(verifier, VT_INDICES32) &&
+           verifier.VerifyVector(indices32()) &&
+           VerifyOffset(verifier, VT_VERTICES) &&
+           verifier.VerifyVector(vertices()) &&
+           VerifyOffset(verifier, VT_LAYOUT) &&
+           verifier.VerifyVector(layout()) &&
+           VerifyField<uint32_t>(verifier, VT_VERTEXSTRIDE) &&
+           VerifyOffset(verifier, VT_LODS) &&
+           verifier.VerifyVector(lods()) &&
+           verifier.VerifyVectorOfTables(lods()) &&
+           VerifyField<Bounds>(verifier, VT_BOUNDS) &&
            verifier.EndTable();
   }
   MeshT *UnPack(const flatbuffers::resolver_function_t *_resolver = nullptr) const;
@@ -785,6 +1067,24 @@ struct MeshBuilder {
   void add_transform(const Mat4 *transform) {
     fbb_.AddStruct(Mesh::VT_TRANSFORM, transform);
   }
+  void add_indices32(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> indices32) {
+    fbb_.AddOffset(Mesh::VT_INDICES32, indices32);
+  }
+  void add_vertices(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> vertices) {
+    fbb_.AddOffset(Mesh::VT_VERTICES, vertices);
+  }
+  void add_layout(flatbuffers::Offset<flatbuffers::Vector<const VertexAttribute *>> layout) {
+    fbb_.AddOffset(Mesh::VT_LAYOUT, layout);
+  }
+  void add_vertexStride(uint32_t vertexStride) {
+    fbb_.AddElement<uint32_t>(Mesh::VT_VERTEXSTRIDE, vertexStride, 0);
+  }
+  void add_lods(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<MeshLod>>> lods) {
+    fbb_.AddOffset(Mesh::VT_LODS, lods);
+  }
+  void add_bounds(const Bounds *bounds) {
+    fbb_.AddStruct(Mesh::VT_BOUNDS, bounds);
+  }
   explicit MeshBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -807,9 +1107,21 @@ inline flatbuffers::Offset<Mesh> CreateMesh(
     flatbuffers::Offset<flatbuffers::Vector<uint16_t>> indices = 0,
     uint32_t material = 0,
     flatbuffers::Offset<flatbuffers::Vector<const Color *>> colors = 0,
-    const Mat4 *transform = 0) {
+    const Mat4 *transform = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint32_t>> indices32 = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t>> vertices = 0,
+    flatbuffers::Offset<flatbuffers::Vector<const VertexAttribute *>> layout = 0,
+    uint32_t vertexStride = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<MeshLod>>> lods = 0,
+    const Bounds *bounds = 0) {
   MeshBuilder builder_(_fbb);
   builder_.add_transform(transform);
+  builder_.add_bounds(bounds);
+  builder_.add_lods(lods);
+  builder_.add_vertexStride(vertexStride);
+  builder_.add_layout(layout);
+  builder_.add_vertices(vertices);
+  builder_.add_indices32(indices32);
   builder_.add_colors(colors);
   builder_.add_material(material);
   builder_.add_indices(indices);
@@ -831,7 +1143,13 @@ inline flatbuffers::Offset<Mesh> CreateMeshDirect(
     const std::vector<uint16_t> *indices = nullptr,
     uint32_t material = 0,
     const std::vector<Color> *colors = nullptr,
-    const Mat4 *transform = 0) {
+    const Mat4 *transform = 0,
+    const std::vector<uint32_t> *indices32 = nullptr,
+    const std::vector<uint8_t> *vertices = nullptr,
+    const std::vector<VertexAttribute> *layout = nullptr,
+    uint32_t vertexStride = 0,
+    const std::vector<flatbuffers::Offset<MeshLod>> *lods = nullptr,
+    const Bounds *bounds = 0) {
   auto positions__ = positions ? _fbb.CreateVectorOfStructs<Vec3>(*positions) : 0;
   auto normals__ = normals ? _fbb.CreateVectorOfStructs<Vec3>(*normals) : 0;
   auto texCoords__ = texCoords ? _fbb.CreateVectorOfStructs<Vec2>(*texCoords) : 0;
@@ -839,6 +1157,10 @@ inline flatbuffers::Offset<Mesh> CreateMeshDirect(
   auto bitangents__ = bitangents ? _fbb.CreateVectorOfStructs<Vec3>(*bitangents) : 0;
   auto indices__ = indices ? _fbb.CreateVector<uint16_t>(*indices) : 0;
   auto colors__ = colors ? _fbb.CreateVectorOfStructs<Color>(*colors) : 0;
+  auto indices32__ = indices32 ? _fbb.CreateVector<uint32_t>(*indices32) : 0;
+  auto vertices__ = vertices ? _fbb.CreateVector<uint8_t>(*vertices) : 0;
+  auto layout__ = layout ? _fbb.CreateVectorOfStructs<VertexAttribute>(*layout) : 0;
+  auto lods__ = lods ? _fbb.CreateVector<flatbuffers::Offset<MeshLod>>(*lods) : 0;
   return ModelData::CreateMesh(
       _fbb,
       positions__,
@@ -849,7 +1171,13 @@ inline flatbuffers::Offset<Mesh> CreateMeshDirect(
       indices__,
       material,
       colors__,
-      transform);
+      transform,
+      indices32__,
+      vertices__,
+      layout__,
+      vertexStride,
+      lods__,
+      bounds);
 }
 
 flatbuffers::Offset<Mesh> CreateMesh(flatbuffers::FlatBufferBuilder &_fbb, const MeshT *_o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
@@ -859,6 +1187,7 @@ struct TreeT : public flatbuffers::NativeTable {
   std::unique_ptr<Mat4> transform;
   std::vector<std::unique_ptr<TreeT>> childs;
   std::vector<uint32_t> meshes;
+  std::unique_ptr<Bounds> bounds;
   TreeT() {
   }
 };
@@ -868,7 +1197,8 @@ struct Tree FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
     VT_TRANSFORM = 4,
     VT_CHILDS = 6,
-    VT_MESHES = 8
+    VT_MESHES = 8,
+    VT_BOUNDS = 10
   };
   const Mat4 *transform() const {
     return GetStruct<const Mat4 *>(VT_TRANSFORM);
@@ -879,6 +1209,9 @@ struct Tree FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   const flatbuffers::Vector<uint32_t> *meshes() const {
     return GetPointer<const flatbuffers::Vector<uint32_t> *>(VT_MESHES);
   }
+  const Bounds *bounds() const {
+    return GetStruct<const Bounds *>(VT_BOUNDS);
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<Mat4>(verifier, VT_TRANSFORM) &&
@@ -887,6 +1220,7 @@ struct Tree FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            verifier.VerifyVectorOfTables(childs()) &&
            VerifyOffset(verifier, VT_MESHES) &&
            verifier.VerifyVector(meshes()) &&
+           VerifyField<Bounds>(verifier, VT_BOUNDS) &&
            verifier.EndTable();
   }
   TreeT *UnPack(const flatbuffers::resolver_function_t *_resolver = nullptr) const;
@@ -906,6 +1240,9 @@ struct TreeBuilder {
   void add_meshes(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> meshes) {
     fbb_.AddOffset(Tree::VT_MESHES, meshes);
   }
+  void add_bounds(const Bounds *bounds) {
+    fbb_.AddStruct(Tree::VT_BOUNDS, bounds);
+  }
   explicit TreeBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -922,8 +1259,10 @@ inline flatbuffers::Offset<Tree> CreateTree(
     flatbuffers::FlatBufferBuilder &_fbb,
     const Mat4 *transform = 0,
     flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Tree>>> childs = 0,
-    flatbuffers::Offset<flatbuffers::Vector<uint32_t>> meshes = 0) {
+    flatbuffers::Offset<flatbuffers::Vector<uint32_t>> meshes = 0,
+    const Bounds *bounds = 0) {
   TreeBuilder builder_(_fbb);
+  builder_.add_bounds(bounds);
   builder_.add_meshes(meshes);
   builder_.add_childs(childs);
   builder_.add_transform(transform);
@@ -934,14 +1273,16 @@ inline flatbuffers::Offset<Tree> CreateTreeDirect(
     flatbuffers::FlatBufferBuilder &_fbb,
     const Mat4 *transform = 0,
     const std::vector<flatbuffers::Offset<Tree>> *childs = nullptr,
-    const std::vector<uint32_t> *meshes = nullptr) {
+    const std::vector<uint32_t> *meshes = nullptr,
+    const Bounds *bounds = 0) {
   auto childs__ = childs ? _fbb.CreateVector<flatbuffers::Offset<Tree>>(*childs) : 0;
   auto meshes__ = meshes ? _fbb.CreateVector<uint32_t>(*meshes) : 0;
   return ModelData::CreateTree(
       _fbb,
       transform,
       childs__,
-      meshes__);
+      meshes__,
+      bounds);
 }
 
 flatbuffers::Offset<Tree> CreateTree(flatbuffers::FlatBufferBuilder &_fbb, const TreeT *_o, const flatbuffers::rehasher_function_t *_rehasher = nullptr);
@@ -1146,6 +1487,38 @@ inline flatbuffers::Offset<Material> CreateMaterial(flatbuffers::FlatBufferBuild
       _textureLightmap);
 }
 
+inline MeshLodT *MeshLod::UnPack(const flatbuffers::resolver_function_t *_resolver) const {
+  auto _o = new MeshLodT();
+  UnPackTo(_o, _resolver);
+  return _o;
+}
+
+inline void MeshLod::UnPackTo(MeshLodT *_o, const flatbuffers::resolver_function_t *_resolver) const {
+  (void)_o;
+  (void)_resolver;
+  { auto _e = indices(); if (_e) { _o->indices.resize(_e->size()); for (flatbuffers::uoffset_t _i = 0; _i < _e->size(); _i++) { _o->indices[_i] = _e->Get(_i); } } };
+  { auto _e = indices32(); if (_e) { _o->indices32.resize(_e->size()); for (flatbuffers::uoffset_t _i = 0; _i < _e->size(); _i++) { _o->indices32[_i] = _e->Get(_i); } } };
+  { auto _e = error(); _o->error = _e; };
+}
+
+inline flatbuffers::Offset<MeshLod> MeshLod::Pack(flatbuffers::FlatBufferBuilder &_fbb, const MeshLodT* _o, const flatbuffers::rehasher_function_t *_rehasher) {
+  return CreateMeshLod(_fbb, _o, _rehasher);
+}
+
+inline flatbuffers::Offset<MeshLod> CreateMeshLod(flatbuffers::FlatBufferBuilder &_fbb, const MeshLodT *_o, const flatbuffers::rehasher_function_t *_rehasher) {
+  (void)_rehasher;
+  (void)_o;
+  struct _VectorArgs { flatbuffers::FlatBufferBuilder *__fbb; const MeshLodT* __o; const flatbuffers::rehasher_function_t *__rehasher; } _va = { &_fbb, _o, _rehasher}; (void)_va;
+  auto _indices = _o->indices.size() ? _fbb.CreateVector(_o->indices) : 0;
+  auto _indices32 = _o->indices32.size() ? _fbb.CreateVector(_o->indices32) : 0;
+  auto _error = _o->error;
+  return ModelData::CreateMeshLod(
+      _fbb,
+      _indices,
+      _indices32,
+      _error);
+}
+
 inline MeshT *Mesh::UnPack(const flatbuffers::resolver_function_t *_resolver) const {
   auto _o = new MeshT();
   UnPackTo(_o, _resolver);
@@ -1164,6 +1537,12 @@ inline void Mesh::UnPackTo(MeshT *_o, const flatbuffers::resolver_function_t *_r
   { auto _e = material(); _o->material = _e; };
   { auto _e = colors(); if (_e) { _o->colors.resize(_e->size()); for (flatbuffers::uoffset_t _i = 0; _i < _e->size(); _i++) { _o->colors[_i] = *_e->Get(_i); } } };
   { auto _e = transform(); if (_e) _o->transform = std::unique_ptr<Mat4>(new Mat4(*_e)); };
+  { auto _e = indices32(); if (_e) { _o->indices32.resize(_e->size()); for (flatbuffers::uoffset_t _i = 0; _i < _e->size(); _i++) { _o->indices32[_i] = _e->Get(_i); } } };
+  { auto _e = vertices(); if (_e) { _o->vertices.resize(_e->size()); for (flatbuffers::uoffset_t _i = 0; _i < _e->size(); _i++) { _o->vertices[_i] = _e->Get(_i); } } };
+  { auto _e = layout(); if (_e) { _o->layout.resize(_e->size()); for (flatbuffers::uoffset_t _i = 0; _i < _e->size(); _i++) { _o->layout[_i] = *_e->Get(_i); } } };
+  { auto _e = vertexStride(); _o->vertexStride = _e; };
+  { auto _e = lods(); if (_e) { _o->lods.resize(_e->size()); for (flatbuffers::uoffset_t _i = 0; _i < _e->size(); _i++) { _o->lods[_i] = std::unique_ptr<MeshLodT>(_e->Get(_i)->UnPack(_resolver)); } } };
+  { auto _e = bounds(); if (_e) _o->bounds = std::unique_ptr<Bounds>(new Bounds(*_e)); };
 }
 
 inline flatbuffers::Offset<Mesh> Mesh::Pack(flatbuffers::FlatBufferBuilder &_fbb, const MeshT* _o, const flatbuffers::rehasher_function_t *_rehasher) {
@@ -1183,6 +1562,12 @@ inline flatbuffers::Offset<Mesh> CreateMesh(flatbuffers::FlatBufferBuilder &_fbb
   auto _material = _o->material;
   auto _colors = _o->colors.size() ? _fbb.CreateVectorOfStructs(_o->colors) : 0;
   auto _transform = _o->transform ? _o->transform.get() : 0;
+  auto _indices32 = _o->indices32.size() ? _fbb.CreateVector(_o->indices32) : 0;
+  auto _vertices = _o->vertices.size() ? _fbb.CreateVector(_o->vertices) : 0;
+  auto _layout = _o->layout.size() ? _fbb.CreateVectorOfStructs(_o->layout) : 0;
+  auto _vertexStride = _o->vertexStride;
+  auto _lods = _o->lods.size() ? _fbb.CreateVector<flatbuffers::Offset<MeshLod>> (_o->lods.size(), [](size_t i, _VectorArgs *__va) { return CreateMeshLod(*__va->__fbb, __va->__o->lods[i].get(), __va->__rehasher); }, &_va ) : 0;
+  auto _bounds = _o->bounds ? _o->bounds.get() : 0;
   return ModelData::CreateMesh(
       _fbb,
       _positions,
@@ -1193,7 +1578,13 @@ inline flatbuffers::Offset<Mesh> CreateMesh(flatbuffers::FlatBufferBuilder &_fbb
       _indices,
       _material,
       _colors,
-      _transform);
+      _transform,
+      _indices32,
+      _vertices,
+      _layout,
+      _vertexStride,
+      _lods,
+      _bounds);
 }
 
 inline TreeT *Tree::UnPack(const flatbuffers::resolver_function_t *_resolver) const {
@@ -1208,6 +1599,7 @@ inline void Tree::UnPackTo(TreeT *_o, const flatbuffers::resolver_function_t *_r
   { auto _e = transform(); if (_e) _o->transform = std::unique_ptr<Mat4>(new Mat4(*_e)); };
   { auto _e = childs(); if (_e) { _o->childs.resize(_e->size()); for (flatbuffers::uoffset_t _i = 0; _i < _e->size(); _i++) { _o->childs[_i] = std::unique_ptr<TreeT>(_e->Get(_i)->UnPack(_resolver)); } } };
   { auto _e = meshes(); if (_e) { _o->meshes.resize(_e->size()); for (flatbuffers::uoffset_t _i = 0; _i < _e->size(); _i++) { _o->meshes[_i] = _e->Get(_i); } } };
+  { auto _e = bounds(); if (_e) _o->bounds = std::unique_ptr<Bounds>(new Bounds(*_e)); };
 }
 
 inline flatbuffers::Offset<Tree> Tree::Pack(flatbuffers::FlatBufferBuilder &_fbb, const TreeT* _o, const flatbuffers::rehasher_function_t *_rehasher) {
@@ -1221,11 +1613,13 @@ inline flatbuffers::Offset<Tree> CreateTree(flatbuffers::FlatBufferBuilder &_fbb
   auto _transform = _o->transform ? _o->transform.get() : 0;
   auto _childs = _o->childs.size() ? _fbb.CreateVector<flatbuffers::Offset<Tree>> (_o->childs.size(), [](size_t i, _VectorArgs *__va) { return CreateTree(*__va->__fbb, __va->__o->childs[i].get(), __va->__rehasher); }, &_va ) : 0;
   auto _meshes = _o->meshes.size() ? _fbb.CreateVector(_o->meshes) : 0;
+  auto _bounds = _o->bounds ? _o->bounds.get() : 0;
   return ModelData::CreateTree(
       _fbb,
       _transform,
       _childs,
-      _meshes);
+      _meshes,
+      _bounds);
 }
 
 inline ModelT *Model::UnPack(const flatbuffers::resolver_function_t *_resolver) const {
@@ -0,0 +1,230 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+
+// cache size the triangle order is optimized for
+static const int32_t OPTIMIZE_CACHE_SIZE = 32;
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+// cache size used for statistics
+static const size_t ANALYZE_CACHE_SIZE = 16;
+static const size_t FETCH_LINE_SIZE = 64;
+static const size_t FETCH_CACHE_LINES = 64;
+
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t> & indices, size_t verticesCount)
+{
+    // time when vertex entered cache, vertex is in cache if it's not older than cache size
+    std::vector<size_t> timestamps(verticesCount, 0);
+    size_t time = ANALYZE_CACHE_SIZE + 1;
+    size_t misses = 0;
+
+    for (uint32_t index : indices)
+    {
+        if (time - timestamps[index] > ANALYZE_CACHE_SIZE)
+        {
+            timestamps[index] = time++;
+            misses++;
+        }
+    }
+
+    size_t trianglesCount = indices.size() / 3;
+
+    return { trianglesCount ? (float)misses / trianglesCount : 0.0f,
+             verticesCount ? (float)misses / verticesCount : 0.0f };
+}
+
+float AnalyzeVertexFetch(const std::vector<uint32_t> & indices, size_t verticesCount, size_t vertexSize)
+{
+    std::vector<size_t> vertexTimestamps(verticesCount, 0);
+    size_t vertexTime = ANALYZE_CACHE_SIZE + 1;
+
+    // FIFO of cache lines
+    std::vector<size_t> lines;
+    size_t fetched = 0;
+
+    for (uint32_t index : indices)
+    {
+        // vertices in post-transform cache are not fetched
+        if (vertexTime - vertexTimestamps[index] <= ANALYZE_CACHE_SIZE)
+            continue;
+
+        vertexTimestamps[index] = vertexTime++;
+
+        size_t first = index * vertexSize / FETCH_LINE_SIZE;
+        size_t last = ((index + 1) * vertexSize - 1) / FETCH_LINE_SIZE;
+
+        for (size_t line = first; line <= last; ++line)
+        {
+            if (std::find(lines.begin(), lines.end(), line) != lines.end())
+                continue;
+
+            lines.push_back(line);
+            if (lines.size() > FETCH_CACHE_LINES)
+                lines.erase(lines.begin());
+
+            fetched += FETCH_LINE_SIZE;
+        }
+    }
+
+    return verticesCount ? (float)fetched / (verticesCount * vertexSize) : 0.0f;
+}
+
+float ScoreVertex(int32_t cachePosition, uint32_t remainingTriangles)
+{
+    // vertex without triangles is not interesting anymore
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+
+    if (cachePosition >= 0)
+    {
+        // vertices of last triangle have fixed score, so it doesn't matter
+        // in which order they were added
+        if (cachePosition < 3)
+            score = LAST_TRIANGLE_SCORE;
+        else
+            score = std::pow(1.0f - (cachePosition - 3) * (1.0f / (OPTIMIZE_CACHE_SIZE - 3)), CACHE_DECAY_POWER);
+    }
+
+    // prefer vertices with few remaining triangles, to get rid of lone triangles
+    score += VALENCE_BOOST_SCALE * std::pow((float)remainingTriangles, -VALENCE_BOOST_POWER);
+
+    return score;
+}
+
+std::vector<uint32_t> OptimizeVertexCache(const std::vector<uint32_t> & indices, size_t verticesCount)
+{
+    size_t trianglesCount = indices.size() / 3;
+
+    // triangles of each vertex, not yet emitted triangles are in front
+    std::vector<uint32_t> remaining(verticesCount, 0);
+    for (uint32_t index : indices)
+        remaining[index]++;
+
+    std::vector<uint32_t> offsets(verticesCount + 1, 0);
+    for (size_t i = 0; i < verticesCount; ++i)
+        offsets[i + 1] = offsets[i] + remaining[i];
+
+    std::vector<uint32_t> adjacency(trianglesCount * 3);
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < trianglesCount * 3; ++i)
+            adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+    }
+
+    std::vector<int32_t> cachePositions(verticesCount, -1);
+    std::vector<float> vertexScores(verticesCount);
+    for (size_t i = 0; i < verticesCount; ++i)
+        vertexScores[i] = ScoreVertex(-1, remaining[i]);
+
+    std::vector<float> triangleScores(trianglesCount);
+    for (size_t i = 0; i < trianglesCount; ++i)
+        triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+
+    std::vector<bool> emitted(trianglesCount, false);
+    std::vector<uint32_t> cache, newCache;
+    std::vector<uint32_t> result;
+    result.reserve(trianglesCount * 3);
+
+    // fallback when no triangle in cache is left
+    size_t nextCandidate = 0;
+    int64_t best = -1;
+
+    while (result.size() < trianglesCount * 3)
+    {
+        if (best < 0)
+        {
+            while (emitted[nextCandidate])
+                nextCandidate++;
+
+            best = (int64_t)nextCandidate;
+        }
+
+        const uint32_t * triangle = &indices[best * 3];
+
+        result.insert(result.end(), triangle, triangle + 3);
+        emitted[best] = true;
+
+        for (size_t i = 0; i < 3; ++i)
+        {
+            uint32_t vertex = triangle[i];
+            uint32_t * begin = &adjacency[offsets[vertex]];
+            uint32_t * end = begin + remaining[vertex];
+
+            // move emitted triangle behind remaining ones
+            std::swap(*std::find(begin, end, (uint32_t)best), *(end - 1));
+            remaining[vertex]--;
+        }
+
+        // vertices of emitted triangle go to front of the cache
+        newCache.assign(triangle, triangle + 3);
+        for (uint32_t vertex : cache)
+        {
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                newCache.push_back(vertex);
+        }
+        std::swap(cache, newCache);
+
+        // update scores of vertices in cache and of those which just left it
+        for (size_t i = 0; i < cache.size(); ++i)
+        {
+            uint32_t vertex = cache[i];
+            cachePositions[vertex] = i < (size_t)OPTIMIZE_CACHE_SIZE ? (int32_t)i : -1;
+
+            float score = ScoreVertex(cachePositions[vertex], remaining[vertex]);
+            float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+
+            for (uint32_t j = offsets[vertex]; j < offsets[vertex] + remaining[vertex]; ++j)
+                triangleScores[adjacency[j]] += delta;
+        }
+
+        if (cache.size() > OPTIMIZE_CACHE_SIZE)
+            cache.resize(OPTIMIZE_CACHE_SIZE);
+
+        // next triangle is the best one using vertices in cache
+        best = -1;
+        float bestScore = -1.0f;
+
+        for (uint32_t vertex : cache)
+        {
+            for (uint32_t j = offsets[vertex]; j < offsets[vertex] + remaining[vertex]; ++j)
+            {
+                uint32_t candidate = adjacency[j];
+                if (triangleScores[candidate] > bestScore)
+                {
+                    best = candidate;
+                    bestScore = triangleScores[candidate];
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t> & indices, size_t verticesCount)
+{
+    // old index -> new index
+    std::vector<uint32_t> remap(verticesCount, UINT32_MAX);
+    // new index -> old index
+    std::vector<uint32_t> order;
+    order.reserve(verticesCount);
+
+    for (uint32_t & index : indices)
+    {
+        if (remap[index] == UINT32_MAX)
+        {
+            remap[index] = (uint32_t)order.size();
+            order.push_back(index);
+        }
+
+        index = remap[index];
+    }
+
+    return order;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct VertexCacheStatistics
+{
+    // average cache miss ratio, transformed vertices per triangle (0.5 - 3.0)
+    float acmr;
+    // average transformed vertex ratio, transformed vertices per vertex (1.0 - 6.0)
+    float atvr;
+};
+
+// Simulates FIFO post-transform cache
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t> & indices, size_t verticesCount);
+
+// Ratio of bytes fetched from memory to size of vertex data, 1.0 means each vertex
+// is fetched exactly once. Simulates small cache of 64-byte lines.
+float AnalyzeVertexFetch(const std::vector<uint32_t> & indices, size_t verticesCount, size_t vertexSize);
+
+// Reorders triangles to improve post-transform cache hits (Tom Forsyth,
+// Linear-Speed Vertex Cache Optimisation)
+std::vector<uint32_t> OptimizeVertexCache(const std::vector<uint32_t> & indices, size_t verticesCount);
+
+// Renumbers vertices in order of first use, unused vertices are dropped.
+// Returns old vertex index for each new vertex.
+std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t> & indices, size_t verticesCount);
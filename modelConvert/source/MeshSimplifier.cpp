@@ -0,0 +1,407 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <cmath>
+
+// collapse is rejected if it rotates any triangle normal by more than ~75 degrees
+static const float FLIP_THRESHOLD = 0.25f;
+
+// Symmetric matrix A, vector b and scalar c, error of point v is v'Av + 2b'v + c
+struct Quadric
+{
+    double a00, a11, a22, a01, a02, a12;
+    double b0, b1, b2;
+    double c;
+};
+
+static void AddPlane(Quadric & q, const glm::dvec3 & n, double d)
+{
+    q.a00 += n.x * n.x;
+    q.a11 += n.y * n.y;
+    q.a22 += n.z * n.z;
+    q.a01 += n.x * n.y;
+    q.a02 += n.x * n.z;
+    q.a12 += n.y * n.z;
+    q.b0 += n.x * d;
+    q.b1 += n.y * d;
+    q.b2 += n.z * d;
+    q.c += d * d;
+}
+
+static void AddQuadric(Quadric & q, const Quadric & other)
+{
+    q.a00 += other.a00;
+    q.a11 += other.a11;
+    q.a22 += other.a22;
+    q.a01 += other.a01;
+    q.a02 += other.a02;
+    q.a12 += other.a12;
+    q.b0 += other.b0;
+    q.b1 += other.b1;
+    q.b2 += other.b2;
+    q.c += other.c;
+}
+
+static double Evaluate(const Quadric & q, const glm::vec3 & v)
+{
+    double x = v.x, y = v.y, z = v.z;
+
+    double result = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z
+        + 2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z)
+        + 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z)
+        + q.c;
+
+    return std::max(result, 0.0);
+}
+
+struct PositionHash
+{
+    size_t operator()(const glm::vec3 & v) const
+    {
+        uint32_t h[3];
+        memcpy(h, &v, sizeof(h));
+        return (h[0] * 73856093) ^ (h[1] * 19349663) ^ (h[2] * 83492791);
+    }
+};
+
+// for each vertex first vertex with the same position
+static std::vector<uint32_t> BuildPositionRemap(const glm::vec3 * positions, size_t verticesCount)
+{
+    std::vector<uint32_t> remap(verticesCount);
+    std::unordered_map<glm::vec3, uint32_t, PositionHash> unique;
+    unique.reserve(verticesCount);
+
+    for (size_t i = 0; i < verticesCount; ++i)
+        remap[i] = unique.emplace(positions[i], (uint32_t)i).first->second;
+
+    return remap;
+}
+
+static std::vector<bool> FindLockedVertices(const std::vector<uint32_t> & indices, const std::vector<uint32_t> & remap)
+{
+    size_t verticesCount = remap.size();
+    std::vector<bool> locked(verticesCount, false);
+
+    // seams, position is shared by vertices with different attributes
+    std::vector<uint32_t> shared(verticesCount, 0);
+    for (size_t i = 0; i < verticesCount; ++i)
+        shared[remap[i]]++;
+
+    for (size_t i = 0; i < verticesCount; ++i)
+        locked[i] = shared[remap[i]] > 1;
+
+    // borders, edge is used by one triangle only
+    std::unordered_map<uint64_t, uint32_t> edges;
+    edges.reserve(indices.size());
+
+    auto key = [](uint32_t a, uint32_t b) { return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a; };
+
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        for (size_t e = 0; e < 3; ++e)
+            edges[key(remap[indices[i + e]], remap[indices[i + (e + 1) % 3]])]++;
+    }
+
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        for (size_t e = 0; e < 3; ++e)
+        {
+            uint32_t a = indices[i + e];
+            uint32_t b = indices[i + (e + 1) % 3];
+
+            if (edges[key(remap[a], remap[b])] == 1)
+            {
+                locked[a] = true;
+                locked[b] = true;
+            }
+        }
+    }
+
+    return locked;
+}
+
+static std::vector<Quadric> ComputeQuadrics(const std::vector<uint32_t> & indices, const glm::vec3 * positions, const std::vector<uint32_t> & remap)
+{
+    std::vector<Quadric> quadrics(remap.size(), Quadric{});
+
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        glm::dvec3 p0 = positions[indices[i]];
+        glm::dvec3 p1 = positions[indices[i + 1]];
+        glm::dvec3 p2 = positions[indices[i + 2]];
+
+        glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        double length = glm::length(normal);
+        if (length == 0.0)
+            continue;
+
+        normal /= length;
+
+        Quadric q = {};
+        AddPlane(q, normal, -glm::dot(normal, p0));
+
+        // vertices with same position share one quadric
+        for (size_t j = 0; j < 3; ++j)
+            AddQuadric(quadrics[remap[indices[i + j]]], q);
+    }
+
+    return quadrics;
+}
+
+// triangles using each vertex, offsets into one array
+struct Adjacency
+{
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+};
+
+static void BuildAdjacency(Adjacency & adjacency, const std::vector<uint32_t> & indices, size_t verticesCount)
+{
+    adjacency.offsets.assign(verticesCount + 1, 0);
+    adjacency.triangles.resize(indices.size());
+
+    for (uint32_t index : indices)
+        adjacency.offsets[index + 1]++;
+
+    for (size_t i = 0; i < verticesCount; ++i)
+        adjacency.offsets[i + 1] += adjacency.offsets[i];
+
+    std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+
+    for (size_t i = 0; i < indices.size(); ++i)
+        adjacency.triangles[fill[indices[i]]++] = uint32_t(i / 3);
+}
+
+// checks if moving vertex 'from' to position of 'to' flips or degenerates triangles around it
+static bool IsCollapseFlipping(const std::vector<uint32_t> & indices, const glm::vec3 * positions, const Adjacency & adjacency, uint32_t from, uint32_t to)
+{
+    for (uint32_t i = adjacency.offsets[from]; i < adjacency.offsets[from + 1]; ++i)
+    {
+        const uint32_t * triangle = &indices[adjacency.triangles[i] * 3];
+
+        // triangles with collapsed edge are removed
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+            continue;
+
+        glm::vec3 p[3] = { positions[triangle[0]], positions[triangle[1]], positions[triangle[2]] };
+        glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+        for (size_t j = 0; j < 3; ++j)
+        {
+            if (triangle[j] == from)
+                p[j] = positions[to];
+        }
+
+        glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+        if (glm::dot(before, after) <= FLIP_THRESHOLD * glm::length(before) * glm::length(after))
+            return true;
+    }
+
+    return false;
+}
+
+// closest point of triangle abc to point p (Ericson, Real-Time Collision Detection 5.1.5)
+static glm::vec3 ClosestPointOnTriangle(const glm::vec3 & p, const glm::vec3 & a, const glm::vec3 & b, const glm::vec3 & c)
+{
+    glm::vec3 ab = b - a;
+    glm::vec3 ac = c - a;
+    glm::vec3 ap = p - a;
+
+    float d1 = glm::dot(ab, ap);
+    float d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp);
+    float d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return b;
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab * (d1 / (d1 - d3));
+
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp);
+    float d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return c;
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac * (d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    float denominator = va + vb + vc;
+    if (denominator <= 0.0f)
+        return a;
+
+    float v = vb / denominator;
+    float w = vc / denominator;
+    return a + ab * v + ac * w;
+}
+
+// Largest distance of removed vertices from the simplified triangles around the vertex they were collapsed to.
+// Nearest point of the simplified surface is at most that far, kept vertices lie on the original surface,
+// so it bounds how far the simplified surface is from vertices of the original one.
+static float MeasureError(const std::vector<uint32_t> & indices, const std::vector<uint32_t> & simplified, const glm::vec3 * positions,
+    size_t verticesCount, const std::vector<uint32_t> & collapsedTo)
+{
+    Adjacency adjacency;
+    BuildAdjacency(adjacency, simplified, verticesCount);
+
+    std::vector<bool> measured(verticesCount, false);
+    float error = 0.0f;
+
+    for (uint32_t index : indices)
+    {
+        uint32_t to = collapsedTo[index];
+        if (to == index || measured[index])
+            continue;
+
+        measured[index] = true;
+
+        const glm::vec3 & p = positions[index];
+
+        // vertex left without triangles, only its position is known to be on the surface
+        float distance = glm::distance(p, positions[to]);
+
+        for (uint32_t i = adjacency.offsets[to]; i < adjacency.offsets[to + 1]; ++i)
+        {
+            const uint32_t * triangle = &simplified[adjacency.triangles[i] * 3];
+            glm::vec3 closest = ClosestPointOnTriangle(p, positions[triangle[0]], positions[triangle[1]], positions[triangle[2]]);
+            distance = std::min(distance, glm::distance(p, closest));
+        }
+
+        error = std::max(error, distance);
+    }
+
+    return error;
+}
+
+std::vector<uint32_t> SimplifyMesh(const std::vector<uint32_t> & indices, const glm::vec3 * positions, size_t verticesCount,
+    size_t targetIndicesCount, float & error)
+{
+    std::vector<uint32_t> result = indices;
+    error = 0.0f;
+
+    std::vector<uint32_t> positionRemap = BuildPositionRemap(positions, verticesCount);
+    std::vector<bool> locked = FindLockedVertices(indices, positionRemap);
+    std::vector<Quadric> quadrics = ComputeQuadrics(indices, positions, positionRemap);
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(verticesCount);
+    std::vector<bool> touched(verticesCount);
+    Adjacency adjacency;
+
+    // vertex each original vertex ended up collapsed to
+    std::vector<uint32_t> collapsedTo(verticesCount);
+    for (size_t i = 0; i < verticesCount; ++i)
+        collapsedTo[i] = (uint32_t)i;
+
+    while (result.size() > targetIndicesCount)
+    {
+        BuildAdjacency(adjacency, result, verticesCount);
+
+        // candidates are edges going from unlocked vertex
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (size_t e = 0; e < 3; ++e)
+            {
+                uint32_t a = result[i + e];
+                uint32_t b = result[i + (e + 1) % 3];
+
+                if (!locked[a])
+                {
+                    Quadric q = quadrics[positionRemap[a]];
+                    AddQuadric(q, quadrics[positionRemap[b]]);
+                    collapses.push_back({ a, b, Evaluate(q, positions[b]) });
+                }
+                if (!locked[b])
+                {
+                    Quadric q = quadrics[positionRemap[a]];
+                    AddQuadric(q, quadrics[positionRemap[b]]);
+                    collapses.push_back({ b, a, Evaluate(q, positions[a]) });
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse & l, const Collapse & r) { return l.cost < r.cost; });
+
+        for (size_t i = 0; i < verticesCount; ++i)
+            remap[i] = (uint32_t)i;
+        std::fill(touched.begin(), touched.end(), false);
+
+        // each collapse removes about two triangles
+        size_t collapsesLimit = (result.size() - targetIndicesCount) / 6 + 1;
+        size_t collapsesCount = 0;
+
+        for (const Collapse & collapse : collapses)
+        {
+            if (collapsesCount >= collapsesLimit)
+                break;
+
+            // neighborhood of each collapse can change only once per pass
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            if (IsCollapseFlipping(result, positions, adjacency, collapse.from, collapse.to))
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            AddQuadric(quadrics[positionRemap[collapse.to]], quadrics[positionRemap[collapse.from]]);
+
+            for (uint32_t j = adjacency.offsets[collapse.from]; j < adjacency.offsets[collapse.from + 1]; ++j)
+            {
+                const uint32_t * triangle = &result[adjacency.triangles[j] * 3];
+                touched[triangle[0]] = true;
+                touched[triangle[1]] = true;
+                touched[triangle[2]] = true;
+            }
+
+            collapsesCount++;
+        }
+
+        if (collapsesCount == 0)
+            break;
+
+        // target of collapse is never collapsed in the same pass
+        for (size_t i = 0; i < verticesCount; ++i)
+            collapsedTo[i] = remap[collapsedTo[i]];
+
+        // apply collapses and remove degenerated triangles
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            uint32_t a = remap[result[i]];
+            uint32_t b = remap[result[i + 1]];
+            uint32_t c = remap[result[i + 2]];
+
+            if (a != b && a != c && b != c)
+            {
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+        }
+        result.resize(write);
+    }
+
+    error = MeasureError(indices, result, positions, verticesCount, collapsedTo);
+
+    return result;
+}
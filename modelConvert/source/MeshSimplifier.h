@@ -0,0 +1,13 @@
+#pragma once
+#include "glm/glm.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Reduces triangles count by collapsing edges with the smallest quadric error
+// (Garland & Heckbert, Surface Simplification Using Quadric Error Metrics).
+// Vertices are not moved, only removed. Vertices on attribute seams (same position
+// used by multiple vertices) and on borders are never collapsed so seams stay intact.
+// Error is the largest distance of vertices of the original mesh from the simplified surface around them.
+std::vector<uint32_t> SimplifyMesh(const std::vector<uint32_t> & indices, const glm::vec3 * positions, size_t verticesCount,
+    size_t targetIndicesCount, float & error);
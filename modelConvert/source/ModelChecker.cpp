@@ -1,15 +1,61 @@
 #include "ModelChecker.h"
 #include <iostream>
+#include <chrono>
 #include "TangentSpace.h"
 #include "VboIndexer.h"
+#include "VertexLayout.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "TaskPool.h"
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <tuple>
 
-void ValidateWindingOrders(glm::vec3 * positions, glm::vec3 * normals, std::vector<uint16_t> & indices)
+// Biggest mesh which can be drawn with 16-bit indices, 0xFFFF is left out
+// as some drivers treat it as primitive restart.
+static const size_t MAX_16BIT_VERTICES = UINT16_MAX;
+
+// each level has about half of triangles of the previous one
+static const size_t MAX_LODS = 4;
+// meshes and levels with less triangles are not simplified further
+static const size_t MIN_LOD_INDICES = 3 * 64;
+// level is dropped when simplification can't remove at least 20 % of triangles
+static const float MIN_LOD_REDUCTION = 0.8f;
+
+std::vector<uint32_t> GetIndices(const ModelData::MeshT & mesh)
+{
+    if (!mesh.indices32.empty())
+        return mesh.indices32;
+
+    return { mesh.indices.begin(), mesh.indices.end() };
+}
+
+// stores indices as 16-bit if possible, works for both MeshT and MeshLodT
+template<class T>
+void SetIndices(T & target, std::vector<uint32_t> indices, size_t verticesCount)
+{
+    target.indices.clear();
+    target.indices32.clear();
+
+    if (verticesCount <= MAX_16BIT_VERTICES)
+        target.indices.assign(indices.begin(), indices.end());
+    else
+        target.indices32 = std::move(indices);
+}
+
+void SetIndices(ModelData::MeshT & mesh, std::vector<uint32_t> indices)
+{
+    SetIndices(mesh, std::move(indices), mesh.positions.size());
+}
+
+void ValidateWindingOrders(glm::vec3 * positions, glm::vec3 * normals, std::vector<uint32_t> & indices)
 {
     for (size_t i = 0; i < indices.size(); i += 3)
     {
-        uint16_t a = indices[i];
-        uint16_t b = indices[i + 1];
-        uint16_t c = indices[i + 2];
+        uint32_t a = indices[i];
+        uint32_t b = indices[i + 1];
+        uint32_t c = indices[i + 2];
 
         glm::vec3 N = glm::cross(positions[b] - positions[a], positions[c] - positions[a]);
         float w = glm::dot(N, positions[a] - normals[a]);
@@ -24,7 +70,8 @@ void ValidateWindingOrders(glm::vec3 * positions, glm::vec3 * normals, std::vect
 
 void UnIndexMesh(ModelData::MeshT & mesh)
 {
-    size_t size = mesh.indices.size();
+    std::vector<uint32_t> indices = GetIndices(mesh);
+    size_t size = indices.size();
 
     if (size == 0)
         return;
@@ -37,16 +84,16 @@ void UnIndexMesh(ModelData::MeshT & mesh)
 
     for (size_t i = 0; i < size; ++i)
     {
-        positions[i] = mesh.positions[mesh.indices[i]];
-        normals[i] = mesh.normals[mesh.indices[i]];
+        positions[i] = mesh.positions[indices[i]];
+        normals[i] = mesh.normals[indices[i]];
 
         if (!mesh.texCoords.empty())
-            texCoords[i] = mesh.texCoords[mesh.indices[i]];
+            texCoords[i] = mesh.texCoords[indices[i]];
 
         if (!mesh.tangents.empty())
         {
-            tangents[i] = mesh.tangents[mesh.indices[i]];
-            bitangents[i] = mesh.bitangents[mesh.indices[i]];
+            tangents[i] = mesh.tangents[indices[i]];
+            bitangents[i] = mesh.bitangents[indices[i]];
         }
     }
 
@@ -62,6 +109,7 @@ void UnIndexMesh(ModelData::MeshT & mesh)
         mesh.bitangents = bitangents;
     }
     mesh.indices.clear();
+    mesh.indices32.clear();
 }
 
 void ComputeTangentSpace(ModelData::MeshT & mesh)
@@ -80,6 +128,8 @@ void ComputeTangentSpace(ModelData::MeshT & mesh)
 
 void ComputeIndices(ModelData::MeshT & mesh)
 {
+    auto begin = std::chrono::steady_clock::now();
+
     // just index it
     auto result = VboIndex((const glm::vec3*)mesh.positions.data(),
         (const glm::vec2*)mesh.texCoords.data(),
@@ -87,15 +137,17 @@ void ComputeIndices(ModelData::MeshT & mesh)
         (const glm::vec3*)mesh.tangents.data(),
         (const glm::vec3*)mesh.bitangents.data(), mesh.positions.size());
 
-    size_t newDataSize = result.vertices.size();
-    size_t newIndicesSize = result.indices.size();
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - begin;
+    Log() << "Indexed " << mesh.positions.size() << " vertices to " << result.vertices.size()
+              << " in " << duration.count() << " ms" << std::endl;
 
-    mesh.indices.resize(newIndicesSize);
-    memcpy(mesh.indices.data(), result.indices.data(), sizeof(uint16_t)*newIndicesSize);
+    size_t newDataSize = result.vertices.size();
 
     mesh.positions.resize(newDataSize);
     memcpy(mesh.positions.data(), result.vertices.data(), sizeof(glm::vec3)*newDataSize);
 
+    SetIndices(mesh, std::move(result.indices));
+
     mesh.texCoords.resize(newDataSize);
     memcpy(mesh.texCoords.data(), result.uvs.data(), sizeof(glm::vec2)*newDataSize);
 
@@ -109,38 +161,471 @@ void ComputeIndices(ModelData::MeshT & mesh)
     memcpy(mesh.bitangents.data(), result.bitangents.data(), sizeof(glm::vec3)*newDataSize);
 }
 
-bool CheckModel(ModelData::ModelT & model)
+// Splits mesh into parts which can be drawn with 16-bit indices, triangles are kept whole
+std::vector<std::unique_ptr<ModelData::MeshT>> SplitMesh(const ModelData::MeshT & mesh)
 {
-    auto it = model.meshes.begin();
+    struct Part
+    {
+        // vertex index in original mesh for each vertex of part
+        std::vector<uint32_t> vertices;
+        std::vector<uint32_t> indices;
+    };
 
-    while (it != model.meshes.end())
+    std::vector<uint32_t> indices = GetIndices(mesh);
+    std::vector<Part> parts(1);
+    // vertex index in original mesh -> vertex index in current part
+    std::unordered_map<uint32_t, uint32_t> remap;
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
     {
-        if (it->get()->positions.empty())
+        // start new part if the triangle might not fit
+        if (parts.back().vertices.size() + 3 > MAX_16BIT_VERTICES)
         {
-            std::cout << "No positions. Invalid mesh. Remove ..." << std::endl;
-            it = model.meshes.erase(it);
-            continue;
+            parts.emplace_back();
+            remap.clear();
+        }
+
+        for (size_t j = i; j < i + 3; ++j)
+        {
+            auto[it, inserted] = remap.try_emplace(indices[j], (uint32_t)parts.back().vertices.size());
+            if (inserted)
+                parts.back().vertices.push_back(indices[j]);
+
+            parts.back().indices.push_back(it->second);
         }
+    }
+
+    size_t verticesCount = mesh.positions.size();
+    size_t uvChannelsCount = mesh.texCoords.size() / verticesCount;
+    size_t colorsCount = mesh.colors.size() / verticesCount;
 
-        if (it->get()->tangents.empty())
+    std::vector<std::unique_ptr<ModelData::MeshT>> result;
+
+    for (auto & part : parts)
+    {
+        auto partMesh = std::make_unique<ModelData::MeshT>();
+
+        for (uint32_t vertex : part.vertices)
         {
-            if (!it->get()->texCoords.empty())
+            partMesh->positions.push_back(mesh.positions[vertex]);
+
+            if (!mesh.normals.empty())
+                partMesh->normals.push_back(mesh.normals[vertex]);
+
+            if (!mesh.tangents.empty())
             {
-                std::cout << "No tangent space. Recompute ..." << std::endl;
-                UnIndexMesh(*it->get());
-                ComputeTangentSpace(*it->get());
+                partMesh->tangents.push_back(mesh.tangents[vertex]);
+                partMesh->bitangents.push_back(mesh.bitangents[vertex]);
             }
         }
 
-        if (it->get()->indices.empty())
+        // UV channels and colors are stored as continuous arrays
+        for (size_t channel = 0; channel < uvChannelsCount; ++channel)
         {
-            ComputeIndices(*it->get());
+            for (uint32_t vertex : part.vertices)
+                partMesh->texCoords.push_back(mesh.texCoords[channel * verticesCount + vertex]);
         }
 
-        ValidateWindingOrders((glm::vec3*)it->get()->positions.data(), (glm::vec3*)it->get()->normals.data(), it->get()->indices);
+        for (size_t channel = 0; channel < colorsCount; ++channel)
+        {
+            for (uint32_t vertex : part.vertices)
+                partMesh->colors.push_back(mesh.colors[channel * verticesCount + vertex]);
+        }
+
+        partMesh->material = mesh.material;
+        if (mesh.transform)
+            partMesh->transform = std::make_unique<ModelData::Mat4>(*mesh.transform);
 
-        it++;
+        SetIndices(*partMesh, std::move(part.indices));
+        result.push_back(std::move(partMesh));
+    }
+
+    return result;
+}
+
+// meshes: old mesh index -> new mesh indices
+void RemapTreeMeshes(ModelData::TreeT & tree, const std::vector<std::vector<uint32_t>> & meshes)
+{
+    std::vector<uint32_t> result;
+
+    for (uint32_t mesh : tree.meshes)
+    {
+        if (mesh < meshes.size())
+            result.insert(result.end(), meshes[mesh].begin(), meshes[mesh].end());
+    }
+
+    tree.meshes = result;
+
+    for (auto & child : tree.childs)
+        RemapTreeMeshes(*child, meshes);
+}
+
+void SplitLargeMeshes(ModelData::ModelT & model)
+{
+    std::vector<std::unique_ptr<ModelData::MeshT>> meshes;
+    std::vector<std::vector<uint32_t>> remap;
+
+    for (auto & mesh : model.meshes)
+    {
+        remap.emplace_back();
+
+        if (mesh->positions.size() <= MAX_16BIT_VERTICES)
+        {
+            remap.back().push_back((uint32_t)meshes.size());
+            meshes.push_back(std::move(mesh));
+            continue;
+        }
+
+        auto parts = SplitMesh(*mesh);
+        Log() << "Mesh with " << mesh->positions.size() << " vertices split to " << parts.size() << " parts" << std::endl;
+
+        for (auto & part : parts)
+        {
+            remap.back().push_back((uint32_t)meshes.size());
+            meshes.push_back(std::move(part));
+        }
+    }
+
+    model.meshes = std::move(meshes);
+
+    if (model.tree)
+        RemapTreeMeshes(*model.tree, remap);
+}
+
+// reorders data with multiple channels stored as continuous array
+template<class T>
+void ReorderVertices(std::vector<T> & data, const std::vector<uint32_t> & order, size_t verticesCount)
+{
+    if (data.empty())
+        return;
+
+    size_t channelsCount = data.size() / verticesCount;
+    std::vector<T> result;
+    result.reserve(channelsCount * order.size());
+
+    for (size_t channel = 0; channel < channelsCount; ++channel)
+    {
+        for (uint32_t vertex : order)
+            result.push_back(data[channel * verticesCount + vertex]);
+    }
+
+    data = std::move(result);
+}
+
+void PrintStatistics(const char * name, const std::vector<uint32_t> & indices, size_t verticesCount, size_t vertexSize)
+{
+    VertexCacheStatistics cache = AnalyzeVertexCache(indices, verticesCount);
+    float overfetch = AnalyzeVertexFetch(indices, verticesCount, vertexSize);
+
+    Log() << name << " ACMR " << cache.acmr << " ATVR " << cache.atvr << " overfetch " << overfetch << std::endl;
+}
+
+void OptimizeMesh(ModelData::MeshT & mesh)
+{
+    std::vector<uint32_t> indices = GetIndices(mesh);
+    size_t verticesCount = mesh.positions.size();
+
+    if (indices.empty() || verticesCount == 0)
+        return;
+
+    // size of vertex in interleaved stream
+    size_t vertexSize = sizeof(ModelData::Vec3);
+    if (!mesh.normals.empty())
+        vertexSize += sizeof(ModelData::Vec3);
+    if (!mesh.tangents.empty())
+        vertexSize += sizeof(ModelData::Vec3);
+    vertexSize += mesh.texCoords.size() / verticesCount * sizeof(ModelData::Vec2);
+
+    PrintStatistics("Before:", indices, verticesCount, vertexSize);
+
+    indices = OptimizeVertexCache(indices, verticesCount);
+    std::vector<uint32_t> order = OptimizeVertexFetch(indices, verticesCount);
+
+    ReorderVertices(mesh.positions, order, verticesCount);
+    ReorderVertices(mesh.normals, order, verticesCount);
+    ReorderVertices(mesh.texCoords, order, verticesCount);
+    ReorderVertices(mesh.tangents, order, verticesCount);
+    ReorderVertices(mesh.bitangents, order, verticesCount);
+    ReorderVertices(mesh.colors, order, verticesCount);
+
+    PrintStatistics("After: ", indices, mesh.positions.size(), vertexSize);
+
+    SetIndices(mesh, std::move(indices));
+}
+
+void OptimizeModel(ModelData::ModelT & model)
+{
+    TaskPool::Instance().ParallelFor(model.meshes.size(), [&](size_t i) { OptimizeMesh(*model.meshes[i]); });
+}
+
+void GenerateLods(ModelData::MeshT & mesh)
+{
+    mesh.lods.clear();
+
+    std::vector<uint32_t> indices = GetIndices(mesh);
+    size_t verticesCount = mesh.positions.size();
+    size_t previousCount = indices.size();
+    float previousError = 0.0f;
+
+    // every level is simplified from the full mesh so error is measured against it
+    for (size_t lod = 1; lod <= MAX_LODS; ++lod)
+    {
+        size_t target = indices.size() / 3 >> lod;
+        if (target * 3 < MIN_LOD_INDICES)
+            break;
+
+        float error = 0.0f;
+        std::vector<uint32_t> simplified = SimplifyMesh(indices, (const glm::vec3*)mesh.positions.data(), verticesCount, target * 3, error);
+
+        if (simplified.size() > previousCount * MIN_LOD_REDUCTION)
+            break;
+
+        // runtime selects the coarsest level within error, so errors must grow with levels
+        if (error <= previousError)
+        {
+            Log() << "LOD " << lod << ": " << simplified.size() / 3 << " triangles, error " << error << " not above previous level, dropped" << std::endl;
+            continue;
+        }
+
+        previousCount = simplified.size();
+        previousError = error;
+
+        Log() << "LOD " << lod << ": " << simplified.size() / 3 << " triangles, error " << error << std::endl;
+
+        std::unique_ptr<ModelData::MeshLodT> result = std::make_unique<ModelData::MeshLodT>();
+        result->error = error;
+        SetIndices(*result, OptimizeVertexCache(simplified, verticesCount), verticesCount);
+
+        mesh.lods.push_back(std::move(result));
+    }
+}
+
+void GenerateLods(ModelData::ModelT & model)
+{
+    TaskPool::Instance().ParallelFor(model.meshes.size(), [&](size_t i) { GenerateLods(*model.meshes[i]); });
+}
+
+std::unique_ptr<ModelData::Bounds> CreateBounds(const glm::vec3 & lower, const glm::vec3 & upper, const glm::vec3 & center, float radius)
+{
+    return std::make_unique<ModelData::Bounds>(ModelData::Vec3(lower.x, lower.y, lower.z), ModelData::Vec3(upper.x, upper.y, upper.z),
+        ModelData::Vec3(center.x, center.y, center.z), radius);
+}
+
+glm::vec3 Convert(const ModelData::Vec3 & v)
+{
+    return { v.x(), v.y(), v.z() };
+}
+
+void ComputeMeshBounds(ModelData::MeshT & mesh)
+{
+    mesh.bounds.reset();
+
+    if (mesh.positions.empty())
+        return;
+
+    const glm::vec3 * positions = (const glm::vec3*)mesh.positions.data();
+
+    glm::vec3 lower = positions[0];
+    glm::vec3 upper = positions[0];
+    for (size_t i = 1; i < mesh.positions.size(); ++i)
+    {
+        lower = glm::min(lower, positions[i]);
+        upper = glm::max(upper, positions[i]);
+    }
+
+    glm::vec3 center = (lower + upper) * 0.5f;
+    float radius = 0.0f;
+    for (size_t i = 0; i < mesh.positions.size(); ++i)
+        radius = std::max(radius, glm::distance(center, positions[i]));
+
+    mesh.bounds = CreateBounds(lower, upper, center, radius);
+}
+
+// bounds of node are in space of its meshes, childs are transformed by their transform
+void ComputeTreeBounds(ModelData::TreeT & tree, const ModelData::ModelT & model)
+{
+    tree.bounds.reset();
+
+    // enclosed spheres, center and radius
+    std::vector<std::tuple<glm::vec3, float>> spheres;
+    glm::vec3 lower(std::numeric_limits<float>::max());
+    glm::vec3 upper(-std::numeric_limits<float>::max());
+
+    for (uint32_t index : tree.meshes)
+    {
+        if (index >= model.meshes.size() || !model.meshes[index]->bounds)
+            continue;
+
+        const ModelData::Bounds & bounds = *model.meshes[index]->bounds;
+        lower = glm::min(lower, Convert(bounds.lower()));
+        upper = glm::max(upper, Convert(bounds.upper()));
+        spheres.push_back({ Convert(bounds.center()), bounds.radius() });
+    }
+
+    for (auto & child : tree.childs)
+    {
+        ComputeTreeBounds(*child, model);
+        if (!child->bounds)
+            continue;
+
+        const ModelData::Bounds & bounds = *child->bounds;
+
+        // transform of child, identity if missing
+        glm::mat4 transform(1.0f);
+        if (child->transform)
+        {
+            const ModelData::Mat4 & m = *child->transform;
+            transform = glm::mat4{
+                { m.a1(), m.b1(), m.c1(), m.d1() },
+                { m.a2(), m.b2(), m.c2(), m.d2() },
+                { m.a3(), m.b3(), m.c3(), m.d3() },
+                { m.a4(), m.b4(), m.c4(), m.d4() }
+            };
+        }
+
+        // transformed box corners
+        for (uint32_t corner = 0; corner < 8; ++corner)
+        {
+            glm::vec3 point((corner & 1) ? bounds.upper().x() : bounds.lower().x(),
+                (corner & 2) ? bounds.upper().y() : bounds.lower().y(),
+                (corner & 4) ? bounds.upper().z() : bounds.lower().z());
+
+            point = glm::vec3(transform * glm::vec4(point, 1.0f));
+            lower = glm::min(lower, point);
+            upper = glm::max(upper, point);
+        }
+
+        float scale = std::sqrt(std::max({ glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+            glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])),
+            glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2])) }));
+
+        spheres.push_back({ glm::vec3(transform * glm::vec4(Convert(bounds.center()), 1.0f)), bounds.radius() * scale });
+    }
+
+    if (spheres.empty())
+        return;
+
+    // sphere enclosing all spheres, but never bigger than sphere around the box
+    glm::vec3 center = (lower + upper) * 0.5f;
+    float radius = 0.0f;
+    for (const auto & [sphereCenter, sphereRadius] : spheres)
+        radius = std::max(radius, glm::distance(center, sphereCenter) + sphereRadius);
+    radius = std::min(radius, glm::distance(lower, upper) * 0.5f);
+
+    tree.bounds = CreateBounds(lower, upper, center, radius);
+}
+
+void ComputeBounds(ModelData::ModelT & model)
+{
+    TaskPool::Instance().ParallelFor(model.meshes.size(), [&](size_t i) { ComputeMeshBounds(*model.meshes[i]); });
+
+    if (model.tree)
+        ComputeTreeBounds(*model.tree, model);
+}
+
+template<class F>
+float GetMaxError(const std::vector<ModelData::Vec3> & original, const std::vector<ModelData::Vec3> & decoded, F error)
+{
+    float result = 0.0f;
+    for (size_t i = 0; i < std::min(original.size(), decoded.size()); ++i)
+        result = std::max(result, error(Convert(original[i]), Convert(decoded[i])));
+    return result;
+}
+
+void InterleaveCompactVertices(ModelData::MeshT & mesh)
+{
+    std::vector<ModelData::Vec3> positions = mesh.positions;
+    std::vector<ModelData::Vec3> normals = mesh.normals;
+    std::vector<ModelData::Vec2> texCoords = mesh.texCoords;
+    std::vector<ModelData::Vec3> tangents = mesh.tangents;
+
+    size_t verticesCount = mesh.positions.size();
+    size_t vertexSize = (positions.size() + normals.size() + tangents.size()) * sizeof(ModelData::Vec3) + texCoords.size() * sizeof(ModelData::Vec2);
+    if (verticesCount)
+        vertexSize /= verticesCount;
+
+    InterleaveVertices(mesh, true);
+
+    // decode it back the same way the loader does
+    ModelData::MeshT decoded;
+    decoded.vertices = mesh.vertices;
+    decoded.layout = mesh.layout;
+    decoded.vertexStride = mesh.vertexStride;
+    if (mesh.bounds)
+        decoded.bounds = std::make_unique<ModelData::Bounds>(*mesh.bounds);
+    DeinterleaveVertices(decoded);
+
+    auto distance = [](const glm::vec3 & a, const glm::vec3 & b) { return glm::distance(a, b); };
+    auto angle = [](const glm::vec3 & a, const glm::vec3 & b)
+    {
+        float cosine = glm::dot(glm::normalize(a), glm::normalize(b));
+        return glm::degrees(std::acos(glm::clamp(cosine, -1.0f, 1.0f)));
+    };
+
+    float errorTexCoords = 0.0f;
+    for (size_t i = 0; i < std::min(texCoords.size(), decoded.texCoords.size()); ++i)
+    {
+        errorTexCoords = std::max(errorTexCoords, std::abs(texCoords[i].x() - decoded.texCoords[i].x()));
+        errorTexCoords = std::max(errorTexCoords, std::abs(texCoords[i].y() - decoded.texCoords[i].y()));
+    }
+
+    Log() << "Compact vertices: " << vertexSize << " -> " << mesh.vertexStride << " bytes"
+        << ", position error " << GetMaxError(positions, decoded.positions, distance)
+        << ", normal error " << GetMaxError(normals, decoded.normals, angle) << " deg"
+        << ", tangent error " << GetMaxError(tangents, decoded.tangents, angle) << " deg"
+        << ", UV error " << errorTexCoords << std::endl;
+}
+
+// returns false for invalid mesh which has to be removed
+bool CheckMesh(ModelData::MeshT & mesh)
+{
+    // checks work with separate arrays, these are interleaved again on save
+    DeinterleaveVertices(mesh);
+
+    // levels of detail are generated again after the mesh is optimized
+    mesh.lods.clear();
+
+    if (mesh.positions.empty())
+    {
+        Log() << "No positions. Invalid mesh. Remove ..." << std::endl;
+        return false;
+    }
+
+    if (mesh.tangents.empty())
+    {
+        if (!mesh.texCoords.empty())
+        {
+            Log() << "No tangent space. Recompute ..." << std::endl;
+            UnIndexMesh(mesh);
+            ComputeTangentSpace(mesh);
+        }
+    }
+
+    if (mesh.indices.empty() && mesh.indices32.empty())
+    {
+        ComputeIndices(mesh);
+    }
+
+    std::vector<uint32_t> indices = GetIndices(mesh);
+    ValidateWindingOrders((glm::vec3*)mesh.positions.data(), (glm::vec3*)mesh.normals.data(), indices);
+    SetIndices(mesh, std::move(indices));
+
+    return true;
+}
+
+bool CheckModel(ModelData::ModelT & model)
+{
+    // meshes are independent, invalid ones are removed afterwards to keep the order
+    std::vector<uint8_t> valid(model.meshes.size());
+    TaskPool::Instance().ParallelFor(model.meshes.size(), [&](size_t i) { valid[i] = CheckMesh(*model.meshes[i]); });
+
+    size_t write = 0;
+    for (size_t i = 0; i < model.meshes.size(); ++i)
+    {
+        if (valid[i])
+            model.meshes[write++] = std::move(model.meshes[i]);
     }
+    model.meshes.resize(write);
 
     return true;
 }
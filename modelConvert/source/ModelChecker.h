@@ -2,4 +2,22 @@
 #include "glm\glm.hpp"
 #include "model_generated.h"
 
+// Returns indices of mesh regardless of the width they are stored in
+std::vector<uint32_t> GetIndices(const ModelData::MeshT & mesh);
+// Stores indices as 16-bit when mesh is small enough, as 32-bit otherwise
+void SetIndices(ModelData::MeshT & mesh, std::vector<uint32_t> indices);
+
 bool CheckModel(ModelData::ModelT & model);
+// Reorders triangles and vertices of meshes for post-transform cache and vertex fetch
+void OptimizeModel(ModelData::ModelT & model);
+// Splits meshes which need 32-bit indices into smaller ones, for targets without
+// desktop GL or OES_element_index_uint
+void SplitLargeMeshes(ModelData::ModelT & model);
+// Generates simplified levels of detail sharing vertices of each mesh, must be the last step
+// as any change of vertices or indices invalidates them
+void GenerateLods(ModelData::ModelT & model);
+// Computes bounds of meshes and conservative bounds of tree nodes, needs deinterleaved vertices
+void ComputeBounds(ModelData::ModelT & model);
+// Interleaves vertices in compact layout (see InterleaveVertices) and prints the
+// largest error the quantization introduces, needs bounds
+void InterleaveCompactVertices(ModelData::MeshT & mesh);
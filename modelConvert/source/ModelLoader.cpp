@@ -1,13 +1,17 @@
 #include "ModelLoader.h"
+#include "ModelChecker.h"
+#include "TaskPool.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <assimp/DefaultLogger.hpp>
+#include <assimp/LogStream.hpp>
 
 #include <string>
 #include <iostream>
 #include <vector>
+#include <mutex>
 
 ModelData::TextureOperation MapOperation(aiTextureOp operation)
 {
@@ -63,7 +67,7 @@ std::vector<std::unique_ptr<ModelData::TextureT>> ProcessTexture(aiMaterial * ma
 
         if (material->GetTexture(textureType, i, &texturePath, nullptr, &uvIndex, &blendFactor, &operation, mapMode) != AI_SUCCESS)
         {
-            std::cout << "Error retrieving texture!!\n";
+            Log() << "Error retrieving texture!!\n";
             continue;
         }
 
@@ -183,13 +187,15 @@ std::unique_ptr<ModelData::MeshT> ProcessMesh(aiMesh * mesh)
     }
 
     // now walk through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+    std::vector<uint32_t> indices;
     for (uint32_t i = 0; i < mesh->mNumFaces; i++)
     {
         aiFace face = mesh->mFaces[i];
         // retrieve all indices of the face and store them in the indices vector
         for (uint32_t j = 0; j < face.mNumIndices; j++)
-            result->indices.push_back(face.mIndices[j]);
+            indices.push_back(face.mIndices[j]);
     }
+    SetIndices(*result, std::move(indices));
 
     result->material = mesh->mMaterialIndex;
 
@@ -220,15 +226,38 @@ std::unique_ptr<ModelData::TreeT> ProcessTree(aiNode * node)
     return result;
 }
 
+// assimp messages go to Log() of the thread doing the import
+class LoggerStream : public Assimp::LogStream
+{
+public:
+    void write(const char * message) override
+    {
+        Log() << message;
+    }
+};
+
+// logger is global, it lives while any thread imports
+static std::mutex s_loggerMutex;
+static uint32_t s_loggerUsers = 0;
+
 void CreateLogger()
 {
-    Assimp::DefaultLogger::create(nullptr, Assimp::Logger::NORMAL, aiDefaultLogStream_STDOUT);
+    std::lock_guard<std::mutex> lock(s_loggerMutex);
+
+    if (s_loggerUsers++ == 0)
+    {
+        Assimp::DefaultLogger::create(nullptr, Assimp::Logger::NORMAL, 0);
+        Assimp::DefaultLogger::get()->attachStream(new LoggerStream());
+    }
 }
 
 void DestroyLogger()
 {
+    std::lock_guard<std::mutex> lock(s_loggerMutex);
+
     // Kill it after the work is done
-    Assimp::DefaultLogger::kill();
+    if (--s_loggerUsers == 0)
+        Assimp::DefaultLogger::kill();
 }
 
 std::optional<ModelData::ModelT> LoadModel(const char * path)
@@ -248,7 +277,7 @@ std::optional<ModelData::ModelT> LoadModel(const char * path)
     // check for errors
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
-        std::cout << "Error assimp: " << importer.GetErrorString() << std::endl;
+        Log() << "Error assimp: " << importer.GetErrorString() << std::endl;
         return std::nullopt;
     }
 
@@ -261,10 +290,8 @@ std::optional<ModelData::ModelT> LoadModel(const char * path)
     }
 
     // process meshes
-    for (uint32_t i = 0; i < scene->mNumMeshes; i++)
-    {
-        data.meshes.push_back(ProcessMesh(scene->mMeshes[i]));
-    }
+    data.meshes.resize(scene->mNumMeshes);
+    TaskPool::Instance().ParallelFor(scene->mNumMeshes, [&](size_t i) { data.meshes[i] = ProcessMesh(scene->mMeshes[i]); });
 
     // recursively process tree structure
     data.tree = ProcessTree(scene->mRootNode);
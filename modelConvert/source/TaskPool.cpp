@@ -0,0 +1,173 @@
+#include "TaskPool.h"
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <exception>
+
+static thread_local std::ostream * s_log = nullptr;
+
+std::ostream & Log()
+{
+    return s_log ? *s_log : std::cout;
+}
+
+ScopedLog::ScopedLog(std::ostream & stream)
+    : m_previous(s_log)
+{
+    s_log = &stream;
+}
+
+ScopedLog::~ScopedLog()
+{
+    s_log = m_previous;
+}
+
+struct TaskPool::Group
+{
+    const std::function<void(size_t)> & task;
+    size_t count;
+    // next index to claim
+    size_t next;
+    size_t remaining;
+
+    // output of each index, written to parent once all previous indices are done
+    std::vector<std::ostringstream> logs;
+    std::vector<bool> done;
+    size_t flushed;
+    std::ostream & parent;
+
+    std::exception_ptr error;
+};
+
+TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+
+    for (auto & thread : m_threads)
+        thread.join();
+}
+
+TaskPool & TaskPool::Instance()
+{
+    static TaskPool pool;
+    return pool;
+}
+
+void TaskPool::Init(size_t threads)
+{
+    if (threads == 0)
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    // calling thread is one of them
+    for (size_t i = 1; i < threads; ++i)
+        m_threads.emplace_back(&TaskPool::Worker, this);
+}
+
+size_t TaskPool::GetThreadsCount() const
+{
+    return m_threads.size() + 1;
+}
+
+void TaskPool::Worker()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        m_condition.wait(lock, [this] { return m_stop || !m_groups.empty(); });
+        if (m_stop)
+            return;
+
+        // the newest group is usually nested in a running task, finishing it first
+        // keeps the number of files in progress low
+        Group & group = *m_groups.back();
+        size_t index = group.next++;
+        if (group.next == group.count)
+            m_groups.pop_back();
+
+        lock.unlock();
+        Run(group, index);
+        lock.lock();
+    }
+}
+
+void TaskPool::Run(Group & group, size_t index)
+{
+    {
+        ScopedLog log(group.logs[index]);
+        try
+        {
+            group.task(index);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!group.error)
+                group.error = std::current_exception();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        group.done[index] = true;
+        while (group.flushed < group.count && group.done[group.flushed])
+        {
+            group.parent << group.logs[group.flushed].str() << std::flush;
+            group.logs[group.flushed] = std::ostringstream();
+            group.flushed++;
+        }
+
+        group.remaining--;
+    }
+
+    // caller of ParallelFor waits for the last index
+    m_condition.notify_all();
+}
+
+void TaskPool::ParallelFor(size_t count, const std::function<void(size_t)> & task)
+{
+    if (count == 0)
+        return;
+
+    if (m_threads.empty() || count == 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+            task(i);
+        return;
+    }
+
+    Group group{ task, count, 0, count, std::vector<std::ostringstream>(count), std::vector<bool>(count, false), 0, Log(), nullptr };
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_groups.push_back(&group);
+    m_condition.notify_all();
+
+    // caller works only on its own group, tasks of other groups could block it for long
+    while (group.remaining)
+    {
+        if (group.next < group.count)
+        {
+            size_t index = group.next++;
+            if (group.next == group.count)
+                m_groups.erase(std::find(m_groups.begin(), m_groups.end(), &group));
+
+            lock.unlock();
+            Run(group, index);
+            lock.lock();
+        }
+        else
+        {
+            m_condition.wait(lock);
+        }
+    }
+
+    lock.unlock();
+
+    if (group.error)
+        std::rethrow_exception(group.error);
+}
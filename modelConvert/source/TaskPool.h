@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <ostream>
+#include <cstddef>
+
+// Stream converter messages are written to, std::cout unless a task of TaskPool
+// is running on the calling thread.
+std::ostream & Log();
+
+// Redirects Log() of the calling thread while alive
+class ScopedLog
+{
+public:
+    ScopedLog(std::ostream & stream);
+    ~ScopedLog();
+
+private:
+    std::ostream * m_previous;
+};
+
+class TaskPool
+{
+public:
+    ~TaskPool();
+    static TaskPool & Instance();
+
+    // Number of threads including the calling one, 0 means one per hardware thread.
+    // Must be called before the first ParallelFor.
+    void Init(size_t threads);
+    size_t GetThreadsCount() const;
+
+    // Runs task for each index in [0, count) and returns once all of them are done.
+    // The calling thread works on the indices as well, so it can be nested in other tasks.
+    // Log() of each task is buffered and written to Log() of the caller in index order,
+    // so the output doesn't depend on scheduling. First exception of tasks is rethrown.
+    void ParallelFor(size_t count, const std::function<void(size_t)> & task);
+
+private:
+    struct Group;
+
+    void Worker();
+    // runs claimed index of group, m_mutex must not be locked
+    void Run(Group & group, size_t index);
+
+    std::vector<std::thread> m_threads;
+    // groups with indices nobody works on yet, the newest are served first
+    std::deque<Group*> m_groups;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop = false;
+};
@@ -1,12 +1,29 @@
 #include "ModelLoader.h"
 #include "ModelChecker.h"
+#include "VertexLayout.h"
+#include "TaskPool.h"
 #include <iostream>
+#include <iomanip>
 #include <filesystem>
 #include <fstream>
 #include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
 
-bool SaveModel(const ModelData::ModelT * model, const std::string & path)
+bool SaveModel(ModelData::ModelT * model, const std::string & path, bool compact)
 {
+    ComputeBounds(*model);
+
+    // meshes are stored with one interleaved vertex stream
+    TaskPool::Instance().ParallelFor(model->meshes.size(), [&](size_t i)
+    {
+        if (compact)
+            InterleaveCompactVertices(*model->meshes[i]);
+        else
+            InterleaveVertices(*model->meshes[i]);
+    });
+
     flatbuffers::FlatBufferBuilder builder(1024);
 
     auto offset = ModelData::CreateModel(builder, model);
@@ -15,48 +32,146 @@ bool SaveModel(const ModelData::ModelT * model, const std::string & path)
     std::ofstream result(path.c_str(), std::ios_base::binary);
     if (!result)
     {
-        std::cout << "Error opening result file " << path.c_str() << "\n\n";
+        Log() << "Error opening result file " << path.c_str() << "\n\n";
         return false;
     }
 
     result.write((const char*)builder.GetBufferPointer(), builder.GetSize());
-    std::wcout << L"Success: " << path.c_str() << L"\n\n";
+    Log() << "Success: " << path.c_str() << "\n\n";
 
     return true;
 }
 
+struct Options
+{
+    // split meshes which need 32-bit indices, for targets without OES_element_index_uint
+    bool split = false;
+    // generate simplified levels of detail
+    bool lods = true;
+    // quantize vertex attributes, see InterleaveVertices
+    bool compact = false;
+    // files converted at once, 0 for one per hardware thread
+    size_t jobs = 1;
+};
+
+bool ConvertFile(const std::string & file, const Options & options)
+{
+    Log() << "Processing: " << file << std::endl;
+
+    std::filesystem::path path(file);
+
+    if (path.extension() == ".model")
+    {
+        std::ifstream stream(file, std::ios::binary | std::ios::ate);
+        size_t fileSize = (size_t)stream.tellg();
+        stream.seekg(std::ios::beg);
+
+        std::vector<char> fileData(fileSize);
+        stream.read(fileData.data(), fileSize);
+
+        auto data = ModelData::UnPackModel(fileData.data());
+        if (!CheckModel(*data))
+            return false;
+
+        OptimizeModel(*data);
+
+        if (options.split)
+            SplitLargeMeshes(*data);
+
+        if (options.lods)
+            GenerateLods(*data);
+
+        return SaveModel(&(*data), path.string(), options.compact);
+    }
+    else
+    {
+        auto data = LoadModel(file.c_str());
+        if (!data)
+        {
+            Log() << "Error loading!\n\n";
+            return false;
+        }
+
+        OptimizeModel(*data);
+
+        if (options.split)
+            SplitLargeMeshes(*data);
+
+        if (options.lods)
+            GenerateLods(*data);
+
+        path.replace_extension("model");
+        return SaveModel(&(*data), path.string(), options.compact);
+    }
+}
+
 int main(int32_t argc, char * argv[])
 {
+    Options options;
+    std::vector<std::string> files;
+
     for (int32_t i = 1; i < argc; ++i)
     {
-        std::cout << "Processing: " << argv[i] << std::endl;
+        std::string argument(argv[i]);
+
+        if (argument == "--split")
+            options.split = true;
+        else if (argument == "--no-lods")
+            options.lods = false;
+        else if (argument == "--compact")
+            options.compact = true;
+        else if (argument == "--jobs" && i + 1 < argc)
+            options.jobs = std::strtoul(argv[++i], nullptr, 10);
+        else
+            files.push_back(argument);
+    }
 
-        std::filesystem::path path(argv[i]);
+    // files and meshes inside of them share one pool of threads
+    TaskPool::Instance().Init(options.jobs);
 
-        if (path.extension() == ".model")
-        {
-            std::ifstream file(argv[i], std::ios::binary | std::ios::ate);
-            size_t fileSize = (size_t)file.tellg();
-            file.seekg(std::ios::beg);
+    struct Result
+    {
+        bool success = false;
+        double seconds = 0.0;
+    };
+    std::vector<Result> results(files.size());
+
+    auto start = std::chrono::steady_clock::now();
 
-            std::vector<char> fileData(fileSize);
-            file.read(fileData.data(), fileSize);
+    // output of each file is printed in order of arguments once the file is done
+    TaskPool::Instance().ParallelFor(files.size(), [&](size_t i)
+    {
+        auto fileStart = std::chrono::steady_clock::now();
 
-            auto data = ModelData::UnPackModel(fileData.data());
-            if (CheckModel(*data))
-                SaveModel(&(*data), path.string());
+        try
+        {
+            results[i].success = ConvertFile(files[i], options);
         }
-        else
+        catch (const std::exception & e)
         {
-            auto data = LoadModel(argv[i]);
-            if (!data)
-            {
-                std::cout << "Error loading!\n\n";
-                continue;
-            }
-
-            path.replace_extension("model");
-            SaveModel(&(*data), path.string());
+            Log() << "Error converting " << files[i] << ": " << e.what() << "\n\n";
         }
+
+        results[i].seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - fileStart).count();
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (files.size() > 1)
+    {
+        size_t failed = 0;
+
+        std::cout << "Summary (" << TaskPool::Instance().GetThreadsCount() << " threads):" << std::endl;
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            std::cout << std::fixed << std::setprecision(3) << std::setw(10) << results[i].seconds << " s  "
+                << (results[i].success ? "OK    " : "FAILED") << "  " << files[i] << std::endl;
+
+            if (!results[i].success)
+                failed++;
+        }
+        std::cout << std::setw(10) << seconds << " s  total, " << files.size() - failed << " converted, " << failed << " failed" << std::endl;
     }
+
+    return std::all_of(results.begin(), results.end(), [](const Result & result) { return result.success; }) ? 0 : 1;
 }
@@ -9,8 +9,13 @@
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_gles2.h"
 #include "OpenGL.h"
+#include "utils/GLState.h"
+#include "model/ModelShaderManager.h"
 
 static int g_done = 0;
+// time to first frame shows cost of initialization, e.g. shader compilation
+static double g_startTime = 0.0;
+static bool g_firstFrame = true;
 static SDL_GLContext g_context = nullptr;
 // window is not static because it's used in common
 SDL_Window* g_window = nullptr;
@@ -149,12 +154,26 @@ void Application::RenderFrame()
 {
     SDL_GL_MakeCurrent(g_window, g_context);
 
+    GLState::Instance().BeginFrame();
+
+    // swap in shaders whose background compilation finished
+    ModelShaderManager::Instance().Update();
+
     if (!MainLoop())
         g_done = true;
 
+    // gui renderer expects default bindings, it uses current vao
+    GLState::Instance().Reset();
+
     GuiRender();
 
     SDL_GL_SwapWindow(g_window);
+
+    if (g_firstFrame)
+    {
+        Common::Frame::SetStartupTime(float(Common::GetCurrentTimeInSeconds() - g_startTime));
+        g_firstFrame = false;
+    }
 }
 
 void Application::ProcessFrame()
@@ -178,13 +197,13 @@ void Application::ProcessFrame()
 
     RenderFrame();
 
-    SDL_Delay(5);
-
     Common::Frame::Signal();
 }
 
 bool Application::Execute()
 {
+    g_startTime = Common::GetCurrentTimeInSeconds();
+
     if (!AppInit())
     {
         printf("Initialization failed.\n");
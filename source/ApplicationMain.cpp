@@ -2,6 +2,7 @@
 #include "Common.h"
 #include "utils/Shader.h"
 #include "utils/Texture.h"
+#include "utils/GLState.h"
 #include "utils/Camera.h"
 #include "VboIndexer.h"
 #include "legacy/Text2D.h"
@@ -69,6 +70,9 @@ namespace
         g_scene = std::make_unique<Scene>(light);
 
         GenerateBoxes();
+
+        // stepping overlaps with drawing, falls back to stepping in DrawScene when not available
+        g_scene->StartPhysicsThread();
     }
 
     void DrawScene()
@@ -98,7 +102,7 @@ namespace
         //pointLight.quadratic = 0.032f;
         //light.lightPoint.push_back(pointLight);
 
-        g_scene->Step();
+        g_scene->Step(Common::Frame::GetTimeDelta());
 
         g_scene->Draw(g_camera.GetViewMatrix(), g_camera.GetProjectionMatrix(), g_camera.GetPosition(), g_userInterface->lightData);
 
@@ -154,11 +158,6 @@ namespace
 
         data.cameraWorldSpace = g_camera.GetPosition();
 
-        data.material.shininess = 10.0f;
-        data.material.ambient = glm::vec3(0.3f, 0.3f, 0.3f);
-        data.material.diffuse = glm::vec3(1.0f, 1.0f, 1.0f);
-        data.material.specular = glm::vec3(0.5f, 0.5f, 0.5f);
-
         data.light.lightDirectional.direction = glm::vec3(1.0f, -1.0f, 0.0f);
         data.light.lightDirectional.ambient = { 0.1f, 0.1f, 0.1f };
         data.light.lightDirectional.diffuse = { 0.5f, 0.5f, 0.5f };
@@ -250,12 +249,12 @@ bool ApplicationMain::Init()
 
     glClearColor(0, 0, 0, 0);
     // Enable depth test
-    glEnable(GL_DEPTH_TEST);
+    GLState::Instance().SetEnabled(GL_DEPTH_TEST, true);
     // Accept fragment if it closer to the camera than the former one
-    glDepthFunc(GL_LESS);
+    GLState::Instance().DepthFunc(GL_LESS);
     // Enable backface culling.
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+    GLState::Instance().SetEnabled(GL_CULL_FACE, true);
+    GLState::Instance().CullFace(GL_BACK);
     glFrontFace(GL_CCW);
 
     // Multisampling are configured in main before window creation.
@@ -295,6 +294,8 @@ bool ApplicationMain::Init()
     //g_postprocess.reset(new Postprocess(Postprocess::Type::KernelSharpen));
 
     g_shadowScene.reset(new ShadowScene());
+    // legacy code binds objects directly
+    GLState::Instance().Invalidate();
 
     g_userInterface.reset(new UserInterface(g_camera));
 
@@ -10,6 +10,14 @@
 #include "LinearMath/btMatrix3x3.h"
 #include "glm/gtc/matrix_transform.hpp"
 
+#if defined(__linux__) && !defined(ANDROID) && !defined(EMSCRIPTEN)
+#define USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 extern SDL_Window* g_window;
 
 namespace Common
@@ -67,6 +75,85 @@ namespace Common
         return WriteFileInternal(name, data, "ab");
     }
 
+    MappedFile::~MappedFile()
+    {
+        Release();
+    }
+
+    MappedFile::MappedFile(MappedFile && other)
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile & MappedFile::operator=(MappedFile && other)
+    {
+        if (this == &other)
+            return *this;
+
+        Release();
+
+        m_mapped = other.m_mapped;
+        m_buffer = std::move(other.m_buffer);
+        m_data = m_mapped ? other.m_data : m_buffer.data();
+        m_size = other.m_size;
+
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_mapped = false;
+
+        return *this;
+    }
+
+    void MappedFile::Release()
+    {
+#ifdef USE_MMAP
+        if (m_mapped)
+            munmap((void*)m_data, m_size);
+#endif
+        m_buffer.clear();
+        m_data = nullptr;
+        m_size = 0;
+        m_mapped = false;
+    }
+
+    MappedFile MapFile(const char * name)
+    {
+        MappedFile result;
+
+#ifdef USE_MMAP
+        int file = open(name, O_RDONLY);
+        if (file != -1)
+        {
+            struct stat info;
+            if (fstat(file, &info) == 0 && info.st_size > 0)
+            {
+                void * data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+                if (data != MAP_FAILED)
+                {
+                    result.m_data = (const uint8_t*)data;
+                    result.m_size = (size_t)info.st_size;
+                    result.m_mapped = true;
+                }
+            }
+
+            close(file);
+
+            if (result.m_mapped)
+            {
+                printf("Mapping file %s length %zu\n", name, result.m_size);
+                return result;
+            }
+        }
+#endif
+
+        // not mapped, read it using SDL
+        result.m_buffer = ReadFile(name);
+        result.m_data = result.m_buffer.data();
+        result.m_size = result.m_buffer.size();
+
+        return result;
+    }
+
     std::string ReadFileToString(const char * name)
     {
         auto data = ReadFile(name);
@@ -342,6 +429,26 @@ namespace Common
             end = timer.now();
         }
 
+        float GetTimeDelta()
+        {
+            if (begin.time_since_epoch().count() == 0)
+                return 0.0f;
+
+            return std::chrono::duration<float>(end - begin).count();
+        }
+
+        float startupTime = 0.0f;
+
+        void SetStartupTime(float seconds)
+        {
+            startupTime = seconds;
+        }
+
+        float GetStartupTime()
+        {
+            return startupTime;
+        }
+
         float GetFPS()
         {
             using ms = std::chrono::duration<float, std::milli>;
@@ -19,6 +19,40 @@ namespace Common
 {
     std::vector<uint8_t> ReadFile(const char * name);
     std::string ReadFileToString(const char * name);
+
+    // read-only view of whole file, memory mapped where possible (Linux),
+    // elsewhere the file is read to memory owned by the view
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(MappedFile && other);
+        MappedFile & operator=(MappedFile && other);
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile & operator=(const MappedFile &) = delete;
+
+        const uint8_t * data() const { return m_data; }
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        const uint8_t & operator[](size_t index) const { return m_data[index]; }
+
+    private:
+        friend MappedFile MapFile(const char * name);
+
+        void Release();
+
+        const uint8_t * m_data = nullptr;
+        size_t m_size = 0;
+        // m_data points to mapped memory, otherwise to m_buffer
+        bool m_mapped = false;
+        std::vector<uint8_t> m_buffer;
+    };
+
+    // empty view on error
+    MappedFile MapFile(const char * name);
     
     bool WriteFile(const char* name, const std::vector<uint8_t>& data);
     bool AppendFile(const char* name, const std::vector<uint8_t>& data);
@@ -49,6 +83,12 @@ namespace Common
     {
         void Signal();
         float GetFPS();
+        // seconds between the last two signals, zero until signaled twice
+        float GetTimeDelta();
+        // seconds from start of application to its first frame shown, e.g. to compare cold and warm
+        // shader caches, zero until then
+        void SetStartupTime(float seconds);
+        float GetStartupTime();
     }
 
     // from depth value [0, 1] make distance [nearPlane, farPlane]
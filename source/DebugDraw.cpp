@@ -1,4 +1,7 @@
 #include "DebugDraw.h"
+#include "utils/GLState.h"
+#include <algorithm>
+#include <cstddef>
 
 static const char LINE_VERTEX_SHADER[] = \
 "#version 100\n"
@@ -27,38 +30,45 @@ static const char LINE_FRAGMENT_SHADER[] = \
 "    gl_FragColor = acolor;\n"
 "}\n";
 
+// size of stream buffer when first used, grows when frame does not fit
+static const size_t BUFFER_CAPACITY = 1 << 20;
+
 DebugDraw::DebugDraw()
     : m_shader(LINE_VERTEX_SHADER, LINE_FRAGMENT_SHADER)
 {
     m_locationVP = m_shader.GetLocation("VP", Shader::LocationType::Uniform);
     m_locationPosition = m_shader.GetLocation("positionWorldSpace", Shader::LocationType::Attrib);
     m_locationColor = m_shader.GetLocation("color", Shader::LocationType::Attrib);
+
+    glGenBuffers(1, &m_buffer);
+}
+
+DebugDraw::~DebugDraw()
+{
+    GLState::Instance().DeleteBuffer(m_buffer);
+}
+
+DebugDraw::Vertex DebugDraw::MakeVertex(const glm::vec3& position, const glm::vec4& color)
+{
+    return { position, glm::u8vec4(glm::round(glm::clamp(color, 0.0f, 1.0f) * 255.0f)) };
 }
 
 void DebugDraw::DrawPoint(const glm::vec3& center, const glm::vec4& color)
 {
-    m_pointData.push_back(center);
-    m_pointColor.push_back(color);
+    m_points.push_back(MakeVertex(center, color));
 }
 
 void DebugDraw::DrawLine(const glm::vec3& from, const glm::vec3& to, const glm::vec4& color)
 {
-    m_lineData.push_back(from);
-    m_lineData.push_back(to);
-
-    m_lineColor.push_back(color);
-    m_lineColor.push_back(color);
+    m_lines.push_back(MakeVertex(from, color));
+    m_lines.push_back(MakeVertex(to, color));
 }
 
 void DebugDraw::DrawTriangle(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const glm::vec4& color)
 {
-    m_triangleData.push_back(p1);
-    m_triangleData.push_back(p2);
-    m_triangleData.push_back(p3);
-
-    m_triangleColor.push_back(color);
-    m_triangleColor.push_back(color);
-    m_triangleColor.push_back(color);
+    m_triangles.push_back(MakeVertex(p1, color));
+    m_triangles.push_back(MakeVertex(p2, color));
+    m_triangles.push_back(MakeVertex(p3, color));
 }
 
 void DebugDraw::DrawRectangle(const glm::vec3& center, const glm::vec2& halfExtents, const glm::vec3& planeNormal, const glm::vec4& color)
@@ -91,21 +101,8 @@ void DebugDraw::DrawRectangle(const glm::vec3& center, const glm::vec2& halfExte
 
     DrawLine(center, center + rightVectorPlane, { 1.0f, 1.0f, 1.0f, 1.0f });
 
-    m_triangleData.push_back(center - upVectorPlane - rightVectorPlane);
-    m_triangleData.push_back(center - upVectorPlane + rightVectorPlane);
-    m_triangleData.push_back(center + upVectorPlane + rightVectorPlane);
-
-    m_triangleData.push_back(center - upVectorPlane - rightVectorPlane);
-    m_triangleData.push_back(center + upVectorPlane + rightVectorPlane);
-    m_triangleData.push_back(center + upVectorPlane - rightVectorPlane);
-
-    m_triangleColor.push_back(color);
-    m_triangleColor.push_back(color);
-    m_triangleColor.push_back(color);
-
-    m_triangleColor.push_back(color);
-    m_triangleColor.push_back(color);
-    m_triangleColor.push_back(color);
+    DrawTriangle(center - upVectorPlane - rightVectorPlane, center - upVectorPlane + rightVectorPlane, center + upVectorPlane + rightVectorPlane, color);
+    DrawTriangle(center - upVectorPlane - rightVectorPlane, center + upVectorPlane + rightVectorPlane, center + upVectorPlane - rightVectorPlane, color);
 }
 
 void DebugDraw::DrawCircle(const glm::vec3& center, float radius, const Common::Math::Plane& plane, const glm::vec4& color)
@@ -141,80 +138,94 @@ void DebugDraw::DrawPlane(const Common::Math::Plane& plane, const glm::vec2& hal
 
 void DebugDraw::Draw(const glm::mat4& view, const glm::mat4& projection)
 {
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE);
+    if (m_points.empty() && m_lines.empty() && m_triangles.empty())
+        return;
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLint first = Upload();
 
-    DrawPoints(view, projection);
-    DrawLines(view, projection);
-    DrawTriangles(view, projection);
+    GLState::Instance().SetEnabled(GL_DEPTH_TEST, false);
+    GLState::Instance().SetEnabled(GL_CULL_FACE, false);
 
-    glDisable(GL_BLEND);
+    GLState::Instance().SetEnabled(GL_BLEND, true);
+    GLState::Instance().BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_DEPTH_TEST);
-}
+    m_shader.BeginRender();
+
+    // attributes point to start of buffer, primitives are addressed by first vertex
+    m_shader.BindBuffer(m_buffer, m_locationPosition, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, position), sizeof(Vertex));
+    m_shader.BindBuffer(m_buffer, m_locationColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Vertex, color), sizeof(Vertex));
+
+    m_shader.SetUniform(projection * view, m_locationVP);
 
-void DebugDraw::DrawPoints(const glm::mat4& view, const glm::mat4& projection)
-{
 #if !defined(ANDROID)
-    glEnable(GL_PROGRAM_POINT_SIZE);
+    GLState::Instance().SetEnabled(GL_PROGRAM_POINT_SIZE, true);
 #endif
 
-    DrawCommon(view, projection, GL_POINTS, m_pointData, m_pointColor);
+    DrawCommon(GL_POINTS, first, m_points.size());
 
 #if !defined(ANDROID)
-    glDisable(GL_PROGRAM_POINT_SIZE);
+    GLState::Instance().SetEnabled(GL_PROGRAM_POINT_SIZE, false);
 #endif
-}
 
-void DebugDraw::DrawLines(const glm::mat4& view, const glm::mat4& projection)
-{
-    DrawCommon(view, projection, GL_LINES, m_lineData, m_lineColor);
-}
+    first += (GLint)m_points.size();
+    DrawCommon(GL_LINES, first, m_lines.size());
 
-void DebugDraw::DrawTriangles(const glm::mat4& view, const glm::mat4& projection)
-{
-    DrawCommon(view, projection, GL_TRIANGLES, m_triangleData, m_triangleColor);
+    first += (GLint)m_lines.size();
+    DrawCommon(GL_TRIANGLES, first, m_triangles.size());
+
+    m_shader.EndRender();
+
+    GLState::Instance().SetEnabled(GL_BLEND, false);
+
+    GLState::Instance().SetEnabled(GL_CULL_FACE, true);
+    GLState::Instance().SetEnabled(GL_DEPTH_TEST, true);
 }
 
-void DebugDraw::DrawCommon(const glm::mat4& view, const glm::mat4& projection,
-    GLenum primitives, const std::vector<glm::vec3>& data, const std::vector<glm::vec4>& colors)
+GLint DebugDraw::Upload()
 {
-    GLuint vbo[2];
+    m_upload.clear();
+    m_upload.reserve(m_points.size() + m_lines.size() + m_triangles.size());
+    m_upload.insert(m_upload.end(), m_points.begin(), m_points.end());
+    m_upload.insert(m_upload.end(), m_lines.begin(), m_lines.end());
+    m_upload.insert(m_upload.end(), m_triangles.begin(), m_triangles.end());
 
-    glGenBuffers(2, vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo[0]);
-    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(glm::vec3), data.data(), GL_STATIC_DRAW);
+    size_t size = m_upload.size() * sizeof(Vertex);
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo[1]);
-    glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(glm::vec4), colors.data(), GL_STATIC_DRAW);
-
-    m_shader.BeginRender();
+    GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_buffer);
 
-    m_shader.BindBuffer<glm::vec3>(vbo[0], m_locationPosition);
-    m_shader.BindBuffer<glm::vec4>(vbo[1], m_locationColor);
+    // new storage is allocated instead of waiting for draws still reading the old one
+    if (m_bufferOffset + size > m_bufferCapacity)
+    {
+        m_bufferCapacity = std::max(m_bufferCapacity, BUFFER_CAPACITY);
+        while (m_bufferCapacity < size)
+            m_bufferCapacity *= 2;
 
-    m_shader.SetUniform(projection * view, m_locationVP);
+        glBufferData(GL_ARRAY_BUFFER, m_bufferCapacity, nullptr, GL_STREAM_DRAW);
+        m_bufferOffset = 0;
+    }
 
-    glDrawArrays(primitives, 0, data.size());
-    CheckGlError("glDrawArrays");
+    glBufferSubData(GL_ARRAY_BUFFER, m_bufferOffset, size, m_upload.data());
+    CheckGlError("glBufferSubData");
 
-    m_shader.EndRender();
+    // offsets stay multiple of vertex size
+    GLint first = (GLint)(m_bufferOffset / sizeof(Vertex));
+    m_bufferOffset += size;
 
-    glDeleteBuffers(2, vbo);
+    return first;
 }
 
-void DebugDraw::Clear()
+void DebugDraw::DrawCommon(GLenum primitives, GLint first, size_t count)
 {
-    m_pointData.clear();
-    m_pointColor.clear();
+    if (!count)
+        return;
 
-    m_lineData.clear();
-    m_lineColor.clear();
+    glDrawArrays(primitives, first, (GLsizei)count);
+    CheckGlError("glDrawArrays");
+}
 
-    m_triangleData.clear();
-    m_triangleColor.clear();
+void DebugDraw::Clear()
+{
+    m_points.clear();
+    m_lines.clear();
+    m_triangles.clear();
 }
@@ -8,6 +8,7 @@ class DebugDraw
 {
 public:
     DebugDraw();
+    ~DebugDraw();
 
     void DrawPoint(const glm::vec3& center, const glm::vec4& color);
     void DrawLine(const glm::vec3& from, const glm::vec3& to, const glm::vec4& color);
@@ -23,23 +24,32 @@ public:
     void Clear();
 
 private:
-    void DrawPoints(const glm::mat4& view, const glm::mat4& projection);
-    void DrawLines(const glm::mat4& view, const glm::mat4& projection);
-    void DrawTriangles(const glm::mat4& view, const glm::mat4& projection);
-    void DrawCommon(const glm::mat4& view, const glm::mat4& projection,
-        GLenum primitives, const std::vector<glm::vec3> & data, const std::vector<glm::vec4> & colors);
+    // interleaved, color packed to 8 bits per channel
+    struct Vertex
+    {
+        glm::vec3 position;
+        glm::u8vec4 color;
+    };
+
+    static Vertex MakeVertex(const glm::vec3& position, const glm::vec4& color);
+
+    // copies all primitives to stream buffer at once, returns index of first vertex
+    GLint Upload();
+    void DrawCommon(GLenum primitives, GLint first, size_t count);
 
     Shader m_shader;
     GLuint m_locationVP;
     GLuint m_locationPosition;
     GLuint m_locationColor;
 
-    std::vector<glm::vec3> m_pointData;
-    std::vector<glm::vec4> m_pointColor;
+    // stream buffer is filled as ring, storage is orphaned when end is reached
+    GLuint m_buffer;
+    size_t m_bufferCapacity = 0;
+    size_t m_bufferOffset = 0;
 
-    std::vector<glm::vec3> m_lineData;
-    std::vector<glm::vec4> m_lineColor;
+    std::vector<Vertex> m_points;
+    std::vector<Vertex> m_lines;
+    std::vector<Vertex> m_triangles;
 
-    std::vector<glm::vec3> m_triangleData;
-    std::vector<glm::vec4> m_triangleColor;
+    std::vector<Vertex> m_upload;
 };
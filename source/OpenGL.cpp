@@ -6,6 +6,64 @@
 #include <string>
 #include <sstream>
 
+#if defined(ANDROID)
+PFNGLDRAWELEMENTSINSTANCEDEXTPROC glDrawElementsInstanced;
+PFNGLVERTEXATTRIBDIVISOREXTPROC glVertexAttribDivisor;
+#else
+PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced;
+PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor;
+#endif
+
+#if defined(ANDROID)
+PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinary;
+PFNGLPROGRAMBINARYOESPROC glProgramBinary;
+#else
+PFNGLGETPROGRAMBINARYPROC glGetProgramBinary;
+PFNGLPROGRAMBINARYPROC glProgramBinary;
+PFNGLPROGRAMPARAMETERIPROC glProgramParameteri;
+#endif
+
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreads;
+
+// first of core, ARB, EXT, OES, KHR and ANGLE names which is available
+static void * GetProcAddressAny(const char * name)
+{
+    for (const char * suffix : { "", "ARB", "EXT", "OES", "KHR", "ANGLE" })
+    {
+        if (void * result = SDL_GL_GetProcAddress((std::string(name) + suffix).c_str()))
+            return result;
+    }
+
+    return nullptr;
+}
+
+// optional, does not make initialization fail
+static void InitInstancing()
+{
+    glDrawElementsInstanced = (decltype(glDrawElementsInstanced))GetProcAddressAny("glDrawElementsInstanced");
+    glVertexAttribDivisor = (decltype(glVertexAttribDivisor))GetProcAddressAny("glVertexAttribDivisor");
+}
+
+// optional, does not make initialization fail
+static void InitProgramBinary()
+{
+    glGetProgramBinary = (decltype(glGetProgramBinary))GetProcAddressAny("glGetProgramBinary");
+    glProgramBinary = (decltype(glProgramBinary))GetProcAddressAny("glProgramBinary");
+#if !defined(ANDROID)
+    glProgramParameteri = (decltype(glProgramParameteri))GetProcAddressAny("glProgramParameteri");
+#endif
+}
+
+// optional, does not make initialization fail
+static void InitParallelShaderCompile()
+{
+    glMaxShaderCompilerThreads = (decltype(glMaxShaderCompilerThreads))GetProcAddressAny("glMaxShaderCompilerThreads");
+
+    // driver chooses number of threads
+    if (IsParallelShaderCompileSupported())
+        glMaxShaderCompilerThreads(0xFFFFFFFF);
+}
+
 #ifndef ANDROID
 PFNGLCREATESHADERPROC glCreateShader;
 PFNGLSHADERSOURCEPROC glShaderSource;
@@ -137,6 +195,10 @@ bool InitOpenGL()
     glBlendEquation = (PFNGLBLENDEQUATIONEXTPROC)SDL_GL_GetProcAddress("glBlendEquation");
 
 #endif
+    InitInstancing();
+    InitProgramBinary();
+    InitParallelShaderCompile();
+
     return glCreateShader && glShaderSource && glCompileShader && glGetShaderiv &&
         glGetShaderInfoLog && glDeleteShader && glAttachShader && glCreateProgram &&
         glLinkProgram && glValidateProgram && glGetProgramiv && glGetProgramInfoLog &&
@@ -162,6 +224,10 @@ bool InitOpenGL()
 #else
 bool InitOpenGL()
 {
+    InitInstancing();
+    InitProgramBinary();
+    InitParallelShaderCompile();
+
     return true;
 }
 #endif
@@ -219,7 +285,93 @@ bool IsVAOSupported()
     static bool value = false;
 
     if (!init)
+    {
         value = IsOpenGlExtensionSupported(VAO_EXTENSION_NAME);
+        init = true;
+    }
+
+    return value;
+}
+
+bool IsElementIndexUintSupported()
+{
+#if defined(ANDROID) || defined(EMSCRIPTEN)
+    static bool init = false;
+    static bool value = false;
+
+    if (!init)
+    {
+        value = IsOpenGlExtensionSupported("GL_OES_element_index_uint");
+        init = true;
+    }
+
+    return value;
+#else
+    // core in desktop OpenGL
+    return true;
+#endif
+}
+
+// position, normal and 8 locations of per instance data, see Instances::Data
+static const GLint INSTANCING_VERTEX_ATTRIBS = 10;
+
+bool IsInstancingSupported()
+{
+    static bool init = false;
+    static bool value = false;
+
+    if (!init)
+    {
+        value = glDrawElementsInstanced && glVertexAttribDivisor;
+#if defined(ANDROID) || defined(EMSCRIPTEN)
+        // entry points may be returned even when extension is missing
+        value = value && (IsOpenGlExtensionSupported("GL_EXT_instanced_arrays") || IsOpenGlExtensionSupported("GL_ANGLE_instanced_arrays"));
+#endif
+
+        // instanced shader needs more attributes than GLES2 guarantees
+        GLint attributes = 0;
+        glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &attributes);
+        value = value && attributes >= INSTANCING_VERTEX_ATTRIBS;
+        init = true;
+    }
+
+    return value;
+}
+
+bool IsProgramBinarySupported()
+{
+#if defined(EMSCRIPTEN)
+    // WebGL doesn't expose program binaries
+    return false;
+#else
+    static bool init = false;
+    static bool value = false;
+
+    if (!init)
+    {
+        // drivers may support no binary format at all
+        GLint formats = 0;
+        if (glGetProgramBinary && glProgramBinary)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        value = formats > 0;
+        init = true;
+    }
+
+    return value;
+#endif
+}
+
+bool IsParallelShaderCompileSupported()
+{
+    static bool init = false;
+    static bool value = false;
+
+    if (!init)
+    {
+        value = glMaxShaderCompilerThreads &&
+            (IsOpenGlExtensionSupported("GL_KHR_parallel_shader_compile") || IsOpenGlExtensionSupported("GL_ARB_parallel_shader_compile"));
+        init = true;
+    }
 
     return value;
 }
@@ -22,6 +22,14 @@
 #define GL_DRAW_FRAMEBUFFER_BINDING GL_FRAMEBUFFER_BINDING
 #endif
 
+// program binaries from OES_get_program_binary
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS GL_NUM_PROGRAM_BINARY_FORMATS_OES
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH_OES
+#endif
+
 #else // ANDROID not defined
 //#ifdef EMSCRIPTEN
 //#include <gl\glew.h>
@@ -103,6 +111,38 @@ extern PFNGLBLENDEQUATIONEXTPROC glBlendEquation;
 
 #endif// ANDROID
 
+// instancing is core since OpenGL 3.3, extension on OpenGL ES 2, null when not available
+#if defined(ANDROID)
+extern PFNGLDRAWELEMENTSINSTANCEDEXTPROC glDrawElementsInstanced;
+extern PFNGLVERTEXATTRIBDIVISOREXTPROC glVertexAttribDivisor;
+#else
+extern PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced;
+extern PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor;
+#endif
+
+// program binaries are core since OpenGL 4.1, extension on OpenGL ES 2, null when not available
+#if defined(ANDROID)
+extern PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinary;
+extern PFNGLPROGRAMBINARYOESPROC glProgramBinary;
+#else
+extern PFNGLGETPROGRAMBINARYPROC glGetProgramBinary;
+extern PFNGLPROGRAMBINARYPROC glProgramBinary;
+extern PFNGLPROGRAMPARAMETERIPROC glProgramParameteri;
+#endif
+
+// parallel shader compilation, declared here for headers without it,
+// pointer has no suffix as OpenGL ES headers declare prototype with it, null when not available
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#if defined(ANDROID)
+typedef void (GL_APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) (GLuint count);
+#else
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) (GLuint count);
+#endif
+#endif
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreads;
+
 #ifndef GL_CLAMP_TO_BORDER
 #ifdef GL_NV_texture_border_clamp
 #define GL_CLAMP_TO_BORDER GL_NV_texture_border_clamp
@@ -129,5 +169,10 @@ void CheckGlError(const char * function, const char * file = __FILE__, const int
 
 bool IsOpenGlExtensionSupported(const char * extension);
 bool IsVAOSupported();
+bool IsElementIndexUintSupported();
+bool IsInstancingSupported();
+bool IsProgramBinarySupported();
+// program link status can be polled with GL_COMPLETION_STATUS_KHR without blocking
+bool IsParallelShaderCompileSupported();
 
 void PrintAllExtensions();
@@ -1,6 +1,7 @@
 #include "Shapes.h"
 #include "Common.h"
 #include "utils/Shader.h"
+#include "utils/GLState.h"
 
 namespace Shapes
 {
@@ -12,9 +13,10 @@ namespace Shapes
 
     Shape::~Shape()
     {
-        glDeleteBuffers(1, &vboData);
-        glDeleteBuffers(1, &vboIndices);
-        glDeleteVertexArrays(1, &vao);
+        GLState::Instance().DeleteBuffer(vboData);
+        GLState::Instance().DeleteBuffer(vboIndices);
+        if (IsVAOSupported())
+            GLState::Instance().DeleteVertexArray(vao);
     }
 
     void EnableAttributes(Shader* shader, GLuint position, GLuint normal, GLuint uvCoord)
@@ -57,11 +59,11 @@ namespace Shapes
         if (IsVAOSupported())
         {
             glGenVertexArrays(1, &vao);
-            glBindVertexArray(vao);
+            GLState::Instance().BindVertexArray(vao);
         }
 
         glGenBuffers(1, &vboData);
-        glBindBuffer(GL_ARRAY_BUFFER, vboData);
+        GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, vboData);
         glBufferData(GL_ARRAY_BUFFER, dataSize, data, GL_STATIC_DRAW);
         CheckGlError("glBufferData");
 
@@ -73,15 +75,15 @@ namespace Shapes
         }
 
         glGenBuffers(1, &vboIndices);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboIndices);
+        GLState::Instance().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboIndices);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesSize, indices, GL_STATIC_DRAW);
         CheckGlError("glBufferData");
 
         if (IsVAOSupported())
-            glBindVertexArray(0);
+            GLState::Instance().BindVertexArray(0);
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, 0);
+        GLState::Instance().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 
     void Shape::Bind()
@@ -102,12 +104,12 @@ namespace Shapes
         {
             // TODO this should be bound using shader
 
-            glBindBuffer(GL_ARRAY_BUFFER, vboData);
+            GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, vboData);
 
             std::visit(EnableAttributesVisitor(), shader);
         }
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboIndices);
+        GLState::Instance().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboIndices);
     }
 
     void Shape::Draw()
@@ -117,6 +119,12 @@ namespace Shapes
         CheckGlError("glDrawArrays");
     }
 
+    void Shape::DrawInstanced(GLsizei instances)
+    {
+        glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)count, GL_UNSIGNED_SHORT, (void*)0, instances);
+        CheckGlError("glDrawElementsInstanced");
+    }
+
     ///////////////////////////////////////////////////////////////////////////
 
     static const float VERTICES_CUBE[] =
@@ -61,6 +61,8 @@ namespace Shapes
 
         void Bind();
         void Draw();
+        // instanced attributes must be bound by shader, see IsInstancingSupported
+        void DrawInstanced(GLsizei instances);
 
         GLuint vao;
         GLuint vboData;
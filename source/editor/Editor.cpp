@@ -8,8 +8,8 @@ Editor::Editor(Scene & scene, UserInterface & userInterface, Camera & camera)
     {
         // remove whole body
         if (m_editShape)
-            m_scene.RemoveBody(m_editShape->GetBody());
-        m_editShape = nullptr;
+            m_scene.RemoveBody(m_editShape.GetBody());
+        m_editShape = {};
         UpdateGizmo();
 
         if (m_gui.shapeEditType != UserInterface::ShapeEditType::None)
@@ -35,8 +35,8 @@ Editor::Editor(Scene & scene, UserInterface & userInterface, Camera & camera)
 
     m_gui.shapeAcceptClicked = [this]()
     {
-        m_scene.RemoveBody(m_editShape->GetBody());
-        m_editShape = nullptr;
+        m_scene.RemoveBody(m_editShape.GetBody());
+        m_editShape = {};
         UpdateGizmo();
 
         AddBodyToScene(m_gui.isStatic);
@@ -59,7 +59,7 @@ Editor::Editor(Scene & scene, UserInterface & userInterface, Camera & camera)
     m_gui.shapeMaterialChanged = [this]()
     {
         if (m_editShape)
-            m_editShape->GetMaterial() = m_gui.materialData;
+            m_editShape.GetMaterial() = m_gui.materialData;
     };
 }
 
@@ -130,7 +130,7 @@ void Editor::Clicked(const glm::vec2 & position)
     {
         // pick the closest
         float minDistance = FLT_MAX;
-        Scene::Shape closestShape = nullptr;
+        Scene::Shape closestShape;
 
         for (auto[shape, position] : rayCastResult)
         {
@@ -226,8 +226,8 @@ void Editor::ScaleShape(const glm::vec2 & position)
     m_gui.shapeScale.y = m_gui.shapeScale.y < MINIMUM_SCALE ? MINIMUM_SCALE : m_gui.shapeScale.y;
     m_gui.shapeScale.z = m_gui.shapeScale.z < MINIMUM_SCALE ? MINIMUM_SCALE : m_gui.shapeScale.z;
 
-    //m_debug.EditPlane(plane, m_editShape->GetBody()->GetPosition());
-    //m_debug.CurrentAxis(editVector, m_editShape->GetBody()->GetPosition());
+    //m_debug.EditPlane(plane, m_editShape.GetBody().GetPosition());
+    //m_debug.CurrentAxis(editVector, m_editShape.GetBody().GetPosition());
 }
 
 void Editor::ModifyScaleValue(float scaleValue)
@@ -273,7 +273,7 @@ void Editor::RotateShape(const glm::vec2 & position)
 {
     Common::Math::Plane plane = GetRotatePlane();
 
-    auto bodyPosition = m_editShape->GetBody()->GetPosition();
+    auto bodyPosition = m_editShape.GetBody().GetPosition();
 
     plane.Translate(m_gui.shapePosition);
     plane.Rotate(m_gui.shapeRotation);
@@ -352,7 +352,7 @@ glm::vec3 Editor::GetEditLineUnit()
 
 Scene::Body Editor::AddBodyToScene(bool isStatic)
 {
-    Scene::Body newBody = nullptr;
+    Scene::Body newBody;
 
     if (m_gui.shapeEditType == UserInterface::ShapeEditType::Cube)
         newBody = m_scene.AddCube({ m_gui.shapePosition, m_gui.shapeRotation, m_gui.shapeScale }, m_gui.materialData, isStatic);
@@ -371,9 +371,9 @@ void Editor::AddEditShape()
     Scene::Body body = AddBodyToScene(true);
 
     // just pick first shape
-    m_editShape = body->GetShapes()[0];
+    m_editShape = body.GetShapes()[0];
 
-    m_gui.materialData = m_editShape->GetMaterial();
+    m_gui.materialData = m_editShape.GetMaterial();
 
     UpdateGizmo();
 }
@@ -382,14 +382,14 @@ void Editor::SetEditShape(Scene::Shape shape)
 {
     if (m_editShape)
     {
-        m_scene.RemoveBody(m_editShape->GetBody());
+        m_scene.RemoveBody(m_editShape.GetBody());
         AddBodyToScene(m_gui.isStatic);
     }
 
     // un-select
     if (m_editShape == shape)
     {
-        m_editShape = nullptr;
+        m_editShape = {};
         UpdateGizmo();
         m_gui.shapeEditType = UserInterface::ShapeEditType::None;
 
@@ -398,19 +398,19 @@ void Editor::SetEditShape(Scene::Shape shape)
 
     m_editShape = shape;
 
-    m_gui.shapePosition = shape->GetBody()->GetPosition();
-    m_gui.shapeRotation = shape->GetBody()->GetRotation();
-    m_gui.shapeScale = shape->GetScale();
-    m_gui.materialData = shape->GetMaterial();
+    m_gui.shapePosition = shape.GetBody().GetPosition();
+    m_gui.shapeRotation = shape.GetBody().GetRotation();
+    m_gui.shapeScale = shape.GetScale();
+    m_gui.materialData = shape.GetMaterial();
     // TODO check this scaling
-    if (shape->GetType() != Shapes::Type::Cube)
+    if (shape.GetType() != Shapes::Type::Cube)
     {
         m_gui.shapeScale.x *= 2.0f;
         //m_gui.shapeScale.y *= 2.0f;
     }
-    m_gui.isStatic = shape->GetBody()->IsStatic();
+    m_gui.isStatic = shape.GetBody().IsStatic();
 
-    switch (shape->GetType())
+    switch (shape.GetType())
     {
     case Shapes::Type::Cone: m_gui.shapeEditType = UserInterface::ShapeEditType::Cone; break;
     case Shapes::Type::Cube: m_gui.shapeEditType = UserInterface::ShapeEditType::Cube; break;
@@ -424,8 +424,8 @@ void Editor::SetEditShape(Scene::Shape shape)
 
 void Editor::ResetEditShape()
 {
-    m_scene.RemoveBody(m_editShape->GetBody());
-    m_editShape = nullptr;
+    m_scene.RemoveBody(m_editShape.GetBody());
+    m_editShape = {};
 
     AddEditShape();
 }
@@ -452,7 +452,7 @@ void Editor::UpdateGizmo()
     }
 
     // currently expect only single shape bodies
-    m_gizmo.UpdateBody(m_editShape->GetBody());
+    m_gizmo.UpdateBody(m_editShape.GetBody());
 }
 
 void Editor::ComputeGizmoOffset(const glm::vec2& position)
@@ -464,7 +464,7 @@ void Editor::ComputeGizmoOffset(const glm::vec2& position)
 
     glm::vec3 planeIntersection = Common::Math::GetIntersection(plane, ray);
 
-    m_gizmoOffset = planeIntersection - m_editShape->GetBody()->GetPosition();
+    m_gizmoOffset = planeIntersection - m_editShape.GetBody().GetPosition();
 }
 
 void Editor::Draw(const glm::mat4& view, const glm::mat4& projection)
@@ -48,7 +48,7 @@ private:
 
     EditorDebug m_debug;
 
-    Scene::Shape m_editShape = nullptr;
+    Scene::Shape m_editShape;
 
     glm::vec2 m_cursorPosition;
     glm::vec2 m_pressPosition;
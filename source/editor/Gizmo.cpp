@@ -15,7 +15,7 @@ static const glm::vec3 GREEN_ROTATION = Common::Math::GetRotation(glm::radians(9
 static const glm::vec3 BLUE_ROTATION = Common::Math::GetRotation(-glm::radians(90.0f), { 0.0f, 0.0f, 1.0f });
 
 Gizmo::Gizmo(Scene& scene)
-    : m_scene(scene), m_body(nullptr)
+    : m_scene(scene)
 {
 
 }
@@ -180,10 +180,10 @@ void Gizmo::UpdateBody(Scene::Body body)
 {
     if (m_body)
     {
-        m_body->SetPosition(body->GetPosition());
+        m_body.SetPosition(body.GetPosition());
 
         if (m_mode == Mode::Scale || m_mode == Mode::Rotate)
-            m_body->SetRotation(body->GetRotation());
+            m_body.SetRotation(body.GetRotation());
     }
 }
 
@@ -192,8 +192,8 @@ void Gizmo::ClearBody()
     m_draw.ClearShapes();
     if (m_body)
         m_scene.RemoveBody(m_body);
-    m_body = nullptr;
-    m_centralSphere = nullptr;
+    m_body = {};
+    m_centralSphere = {};
     m_redShapes.clear();
     m_greenShapes.clear();
     m_blueShapes.clear();
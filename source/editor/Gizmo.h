@@ -48,9 +48,9 @@ private:
 
     void ClearBody();
 
-    Scene::Body m_body = nullptr;
+    Scene::Body m_body;
 
-    Scene::Shape m_centralSphere = nullptr;
+    Scene::Shape m_centralSphere;
     std::set<Scene::Shape> m_redShapes;
     std::set<Scene::Shape> m_greenShapes;
     std::set<Scene::Shape> m_blueShapes;
@@ -1,4 +1,5 @@
 #include "GizmoDraw.h"
+#include "utils/GLState.h"
 
 static const char VERTEX_SHADER[] = \
 "#version 100\n"
@@ -43,7 +44,7 @@ void GizmoDraw::AddShape(Scene::Shape shape, const glm::vec4& color)
 {
     auto GetShape = [this](Scene::Shape shape)
     {
-        switch (shape->GetType())
+        switch (shape.GetType())
         {
         case Shapes::Type::Cone:
             return (Shapes::Shape*)m_cone.get();
@@ -68,9 +69,9 @@ void GizmoDraw::DrawShapes(const glm::mat4& view, const glm::mat4& projection)
     //glDisable(GL_DEPTH_TEST);
 
     // enable blending
-    glEnable(GL_BLEND);
+    GLState::Instance().SetEnabled(GL_BLEND, true);
     //glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    GLState::Instance().BlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
     m_postprocess->BeginRender();
 
@@ -95,7 +96,7 @@ void GizmoDraw::DrawShapes(const glm::mat4& view, const glm::mat4& projection)
         {
             auto&[sceneShape, color] = it->second;
 
-            glm::mat4 mvp = projection * view * sceneShape->GetTransform();
+            glm::mat4 mvp = projection * view * sceneShape.GetTransform();
             m_shader->SetUniform(mvp, "MVP");
             m_shader->SetUniform(color, "color");
 
@@ -109,7 +110,7 @@ void GizmoDraw::DrawShapes(const glm::mat4& view, const glm::mat4& projection)
 
     m_postprocess->EndRender();
 
-    glDisable(GL_BLEND);
+    GLState::Instance().SetEnabled(GL_BLEND, false);
 
     //glEnable(GL_DEPTH_TEST);
 }
@@ -2,6 +2,7 @@
 #include "utils/Shader.h"
 #include "Shapes.h"
 #include <set>
+#include <map>
 #include "scene/Scene.h"
 #include "utils/Postprocess.h"
 
@@ -2,6 +2,7 @@
 #include "Common.h"
 #include <SDL.h>
 #include "utils/Camera.h"
+#include "utils/GLState.h"
 
 UserInterface::UserInterface(CameraRotate& camera)
     : shapeScale(1.0f, 1.0f, 1.0f), cameraPlanes(0.1f, 1000.0f), m_camera(camera)
@@ -54,6 +55,10 @@ void UserInterface::Generate()
     ImGui::Begin("test", nullptr, windowFlags);
 
     ImGui::Text("Frame: %06.2fms", Common::Frame::GetFPS());
+    ImGui::Text("Startup: %.3fs", Common::Frame::GetStartupTime());
+    const GLState::Statistics & glStatistics = GLState::Instance().GetStatistics();
+    ImGui::Text("GL state: %u set, %u skipped", glStatistics.issued, glStatistics.elided);
+    ImGui::Text("Uniforms: %u set, %u skipped", glStatistics.uniformsIssued, glStatistics.uniformsElided);
     
     int32_t mouseX, mouseY;
     SDL_GetMouseState(&mouseX, &mouseY);
@@ -34,7 +34,7 @@ public:
 
         glDrawElements(GL_TRIANGLES,      // mode
                        m_verticesCount,   // count
-                       GL_UNSIGNED_SHORT, // type
+                       m_indexType,       // type
                        (void*)0);         // element array buffer offset
 
         m_shader.EndRender();
@@ -62,7 +62,25 @@ private:
 
         glGenBuffers(1, &m_bufferIndex);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bufferIndex);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexed.indices.size() * sizeof(uint16_t), &indexed.indices[0], GL_STATIC_DRAW);
+
+        // 16-bit indices when vertices fit, larger objects need 32-bit ones
+        if (indexed.vertices.size() <= UINT16_MAX)
+        {
+            std::vector<uint16_t> indices(indexed.indices.begin(), indexed.indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), &indices[0], GL_STATIC_DRAW);
+            m_indexType = GL_UNSIGNED_SHORT;
+        }
+        else
+        {
+            if (!IsElementIndexUintSupported())
+            {
+                printf("Error loading obj file, %zu vertices need 32-bit indices and these are not supported.\n", indexed.vertices.size());
+                return 0;
+            }
+
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexed.indices.size() * sizeof(uint32_t), &indexed.indices[0], GL_STATIC_DRAW);
+            m_indexType = GL_UNSIGNED_INT;
+        }
 
         return indexed.indices.size();
     }
@@ -72,4 +90,5 @@ private:
     GLuint m_bufferVertex;
     GLuint m_bufferIndex;
     GLuint m_verticesCount;
+    GLenum m_indexType = GL_UNSIGNED_SHORT;
 };
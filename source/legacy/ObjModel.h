@@ -24,7 +24,7 @@ class ObjModel
         shader.BindBuffer<glm::vec3>(m_bufferNormal, "normalModelSpace");
         shader.BindElementBuffer(m_bufferIndex);
 
-        glDrawElements(GL_TRIANGLES, m_verticesCount, GL_UNSIGNED_SHORT, (void*)0);
+        glDrawElements(GL_TRIANGLES, m_verticesCount, m_indexType, (void*)0);
 
         shader.EndRender();
     }
@@ -97,7 +97,7 @@ public:
 
         m_shader.BindElementBuffer(m_bufferIndex);
 
-        glDrawElements(GL_TRIANGLES, m_verticesCount, GL_UNSIGNED_SHORT, (void*)0);
+        glDrawElements(GL_TRIANGLES, m_verticesCount, m_indexType, (void*)0);
 
         m_shader.EndRender();
     }
@@ -145,7 +145,25 @@ private:
 
         glGenBuffers(1, &m_bufferIndex);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bufferIndex);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexed.indices.size() * sizeof(uint16_t), &indexed.indices[0], GL_STATIC_DRAW);
+
+        // 16-bit indices when vertices fit, larger objects need 32-bit ones
+        if (indexed.vertices.size() <= UINT16_MAX)
+        {
+            std::vector<uint16_t> indices(indexed.indices.begin(), indexed.indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), &indices[0], GL_STATIC_DRAW);
+            m_indexType = GL_UNSIGNED_SHORT;
+        }
+        else
+        {
+            if (!IsElementIndexUintSupported())
+            {
+                printf("Error loading obj file, %zu vertices need 32-bit indices and these are not supported.\n", indexed.vertices.size());
+                return 0;
+            }
+
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexed.indices.size() * sizeof(uint32_t), &indexed.indices[0], GL_STATIC_DRAW);
+            m_indexType = GL_UNSIGNED_INT;
+        }
 
         return indexed.indices.size();
     }
@@ -196,5 +214,6 @@ private:
     GLuint m_textureSpecular;
 
     GLuint m_verticesCount;
+    GLenum m_indexType = GL_UNSIGNED_SHORT;
 
 };
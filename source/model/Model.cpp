@@ -5,9 +5,17 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include "utils/Texture.h"
 #include "utils/Shader.h"
+#include "utils/GLState.h"
 #include "Common.h"
 #include "CommonProject.h"
+#include "VertexLayout.h"
 #include "TextureManager.h"
+#include "ModelShaderManager.h"
+#include <type_traits>
+#include <algorithm>
+
+// maximal error of used level of detail in pixels
+static const float LOD_PIXEL_ERROR = 1.0f;
 
 glm::mat4 Convert(const ModelData::Mat4 & m)
 {
@@ -19,9 +27,59 @@ glm::mat4 Convert(const ModelData::Mat4 & m)
     };
 }
 
-Mesh::Mesh(const ModelData::MeshT & mesh, std::vector<std::unique_ptr<ModelMaterial>> & materials)
+glm::vec3 Convert(const ModelData::Vec3 & v)
+{
+    return { v.x(), v.y(), v.z() };
+}
+
+ModelBounds Convert(const ModelData::Bounds & bounds)
+{
+    return { Convert(bounds.lower()), Convert(bounds.upper()), Convert(bounds.center()), bounds.radius() };
+}
+
+// GL type of attribute, integer formats are always normalized
+GLenum GetAttributeType(ModelData::VertexFormat format)
+{
+    switch (format)
+    {
+    case ModelData::VertexFormat_Unorm16:
+        return GL_UNSIGNED_SHORT;
+    case ModelData::VertexFormat_Octahedral16:
+        return GL_SHORT;
+    case ModelData::VertexFormat_Octahedral8:
+        return GL_BYTE;
+    default:
+        return GL_FLOAT;
+    }
+}
+
+// ModelShader::Config::Flags needed to decode vertices of mesh
+uint32_t GetVertexFlags(const ModelData::Mesh & mesh)
+{
+    uint32_t result = 0;
+
+    if (!mesh.layout())
+        return result;
+
+    for (const ModelData::VertexAttribute * attribute : *mesh.layout())
+    {
+        if (attribute->usage() == ModelData::VertexUsage_Position && attribute->format() == ModelData::VertexFormat_Unorm16)
+            result |= (uint32_t)ModelShader::Config::Flags::QuantizedPositions;
+        if (attribute->usage() == ModelData::VertexUsage_Normal && attribute->format() == ModelData::VertexFormat_Octahedral16)
+            result |= (uint32_t)ModelShader::Config::Flags::OctahedralNormals;
+    }
+
+    return result;
+}
+
+bool ModelBounds::IsVisible(const Frustum & frustum, const glm::mat4 & model) const
 {
-    uint32_t materialIndex = mesh.material;
+    return frustum.IsSphereVisible(center, radius, model) && frustum.IsBoxVisible(lower, upper, model);
+}
+
+Mesh::Mesh(const ModelData::Mesh & mesh, std::vector<std::unique_ptr<ModelMaterial>> & materials)
+{
+    uint32_t materialIndex = mesh.material();
     if (materialIndex >= materials.size())
     {
         printf("Error loading model, mesh has invalid material index (%d)", materialIndex);
@@ -29,34 +87,69 @@ Mesh::Mesh(const ModelData::MeshT & mesh, std::vector<std::unique_ptr<ModelMater
     }
     m_material = materials[materialIndex].get();
 
-    InitBuffers(mesh.positions, mesh.normals, mesh.texCoords, mesh.tangents, mesh.bitangents, mesh.indices);
-}
+    if (mesh.vertices() && mesh.layout())
+    {
+        // upload straight from the file data
+        InitBuffers(mesh.vertices()->data(), mesh.vertices()->size(), mesh.layout()->data(), mesh.layout()->size(), mesh.vertexStride());
 
-Mesh::~Mesh()
-{
-    glDeleteBuffers(1, &m_positions);
-    glDeleteBuffers(1, &m_vboIndices);
-    glDeleteBuffers(1, &m_normals);
+        if (!mesh.bounds())
+            InitBounds(mesh.vertices()->data(), mesh.vertices()->size(), mesh.layout()->data(), mesh.layout()->size(), mesh.vertexStride());
+    }
+    else
+    {
+        // older models have separate vertex arrays, these have to be interleaved first
+        std::unique_ptr<ModelData::MeshT> unpacked(mesh.UnPack());
+        InterleaveVertices(*unpacked);
 
-    if (m_material->shader->GetConfig().GetUVChannelsCount())
-        glDeleteBuffers(m_texCoords.size(), m_texCoords.data());
+        InitBuffers(unpacked->vertices.data(), unpacked->vertices.size(), unpacked->layout.data(), unpacked->layout.size(), unpacked->vertexStride);
 
-    if (m_material->shader->GetConfig().textures.normal.size())
+        if (!mesh.bounds())
+            InitBounds(unpacked->vertices.data(), unpacked->vertices.size(), unpacked->layout.data(), unpacked->layout.size(), unpacked->vertexStride);
+    }
+
+    if (mesh.bounds())
     {
-        glDeleteBuffers(1, &m_tangents);
-        glDeleteBuffers(1, &m_bitangents);
+        m_bounds = Convert(*mesh.bounds());
+    }
+    else if (GetVertexFlags(mesh) & (uint32_t)ModelShader::Config::Flags::QuantizedPositions)
+    {
+        printf("Error loading model, mesh has quantized positions without bounds");
+        throw std::runtime_error("Error loading model.");
     }
 
+    if (mesh.indices32())
+    {
+        if (!IsElementIndexUintSupported())
+        {
+            printf("Error loading model, mesh needs 32-bit indices and these are not supported (convert it with --split)");
+            throw std::runtime_error("Error loading model.");
+        }
+
+        InitIndices<uint32_t>(mesh, GL_UNSIGNED_INT);
+    }
+    else if (mesh.indices())
+    {
+        InitIndices<uint16_t>(mesh, GL_UNSIGNED_SHORT);
+    }
+    else
+    {
+        printf("Error loading model, mesh has no indices");
+        throw std::runtime_error("Error loading model.");
+    }
+}
+
+Mesh::~Mesh()
+{
+    GLState::Instance().DeleteBuffer(m_vbo);
+    GLState::Instance().DeleteBuffer(m_vboIndices);
+
     if (IsVAOSupported())
-        glDeleteVertexArrays(1, &m_vao);
+        GLState::Instance().DeleteVertexArray(m_vao);
 }
 
 void Mesh::BindUniforms(const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection)
 {
-    glm::mat4 MVP = projection * view * model;
-
-    m_material->shader->GetShader().SetUniform(MVP, "MVP");
-    m_material->shader->GetShader().SetUniform(model, "M");
+    m_material->shader->BindTransform(model, view, projection);
 }
 
 void Mesh::BindBuffers()
@@ -67,17 +160,8 @@ void Mesh::BindBuffers()
     }
     else
     {
-        m_material->shader->GetShader().BindBuffer<glm::vec3>(m_positions, m_material->shader->GetLocations().buffers.positions);
-        m_material->shader->GetShader().BindBuffer<glm::vec3>(m_normals, m_material->shader->GetLocations().buffers.normals);
-
-        for (uint32_t i = 0; i < m_material->shader->GetConfig().GetUVChannelsCount(); ++i)
-            m_material->shader->GetShader().BindBuffer<glm::vec2>(m_texCoords[i], m_material->shader->GetLocations().buffers.texCoords[i]);
-
-        if (m_material->shader->GetConfig().textures.normal.size())
-        {
-            m_material->shader->GetShader().BindBuffer<glm::vec3>(m_tangents, m_material->shader->GetLocations().buffers.tangents);
-            //m_material->shader->GetShader().BindBuffer<glm::vec3>(m_bitangents, m_shader->GetLocations().buffers.bitangents);
-        }
+        for (const auto & attribute : m_attributes)
+            m_material->shader->GetShader().BindBuffer(m_vbo, attribute.location, attribute.components, attribute.type, attribute.normalized, attribute.offset, m_vertexStride);
     }
 
     // TODO can be bound to VAO ???
@@ -90,90 +174,210 @@ void Mesh::Draw(const glm::mat4 & model, const glm::mat4 & view, const glm::mat4
     m_material->shader->BeginRender();
 
     m_material->shader->BindTransform(model, view, projection);
+    m_material->shader->BindPositionBounds(m_bounds.lower, m_bounds.upper);
+    m_material->shader->BindMaterial(m_material->material);
     m_material->shader->BindTextures(m_material->textures);
 
     BindBuffers();
 
-    glDrawElements(GL_TRIANGLES, m_verticesCount, GL_UNSIGNED_SHORT, (void*)0);
+    const Lod & lod = SelectLod(model, view, projection);
+
+    glDrawElements(GL_TRIANGLES, lod.count, m_indicesType, (void*)lod.offset);
     CheckGlError("glDrawElements");
 
     m_material->shader->EndRender();
 }
 
-template<class T, uint32_t N>
-GLuint CreateFloatVBO(GLuint index, const T * data, size_t size, bool isVaoBinded)
+void Mesh::InitBuffers(const uint8_t * vertices, size_t size, const ModelData::VertexAttribute * layout, size_t layoutSize, uint32_t stride)
 {
-    GLuint vbo;
+    // locations are known before program is linked
+    const ModelShader::Buffers::Locations & locations = m_material->shader->GetLocations().buffers;
+
+    m_vertexStride = stride;
+
+    // attributes not used by shader are skipped
+    for (size_t i = 0; i < layoutSize; ++i)
+    {
+        const ModelData::VertexAttribute & attribute = layout[i];
+
+        GLuint location = GLuint(-1);
+
+        switch (attribute.usage())
+        {
+        case ModelData::VertexUsage_Position:
+            location = locations.positions;
+            break;
+        case ModelData::VertexUsage_Normal:
+            location = locations.normals;
+            break;
+        case ModelData::VertexUsage_TexCoord:
+            if (attribute.channel() < locations.texCoords.size())
+                location = locations.texCoords[attribute.channel()];
+            break;
+        case ModelData::VertexUsage_Tangent:
+            location = locations.tangents;
+            break;
+        }
+
+        GLenum type = GetAttributeType(attribute.format());
+
+        if (location != GLuint(-1))
+            m_attributes.push_back({ location, attribute.components(), type, type != GL_FLOAT, attribute.offset() });
+    }
+
+    bool bindVAO = IsVAOSupported();
 
-    glGenBuffers(1, &vbo);
+    // prepare and bind VAO if possible
+    if (bindVAO)
+    {
+        glGenVertexArrays(1, &m_vao);
+        CheckGlError("glGenVertexArrays");
+
+        GLState::Instance().BindVertexArray(m_vao);
+    }
+
+    glGenBuffers(1, &m_vbo);
     CheckGlError("glGenBuffers");
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    CheckGlError("glBindBuffer");
+    GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_vbo);
 
-    glBufferData(GL_ARRAY_BUFFER, size*sizeof(T), data, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
     CheckGlError("glBufferData");
 
-    if (isVaoBinded)
+    if (bindVAO)
     {
-        glEnableVertexAttribArray(index);
-        CheckGlError("glEnableVertexAttribArray");
+        for (const auto & attribute : m_attributes)
+        {
+            glEnableVertexAttribArray(attribute.location);
+            CheckGlError("glEnableVertexAttribArray");
 
-        glVertexAttribPointer(index, N, GL_FLOAT, GL_FALSE, 0, nullptr);
-        CheckGlError("glVertexAttribPointer");
+            glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized, m_vertexStride, (void*)(uintptr_t)attribute.offset);
+            CheckGlError("glVertexAttribPointer");
+        }
+
+        GLState::Instance().BindVertexArray(0);
     }
 
-    return vbo;
+    GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-template<class T, uint32_t N>
-GLuint CreateFloatVBO(GLuint index, const std::vector<T> & data, bool isVaoBinded)
+// indices of given width, works for both Mesh and MeshLod
+template<class T, class M>
+const flatbuffers::Vector<T> * GetIndices(const M & mesh)
 {
-    return CreateFloatVBO<T, N>(index, &data[0], data.size(), isVaoBinded);
+    if constexpr (std::is_same_v<T, uint32_t>)
+        return mesh.indices32();
+    else
+        return mesh.indices();
 }
 
-void Mesh::InitBuffers(const std::vector<ModelData::Vec3> & positions,
-                        const std::vector<ModelData::Vec3> & normals,
-                        const std::vector<ModelData::Vec2> & texCoords,
-                        const std::vector<ModelData::Vec3> & tangents,
-                        const std::vector<ModelData::Vec3> & bitangents,
-                        const std::vector<uint16_t> & indices)
+template<class T>
+void Mesh::InitIndices(const ModelData::Mesh & mesh, GLenum type)
 {
-    bool bindVAO = IsVAOSupported();
+    const flatbuffers::Vector<T> * indices = GetIndices<T>(mesh);
 
-    // prepare and bind VAO if possible
-    if (bindVAO)
+    m_lods.push_back({ 0, indices->size(), 0.0f });
+    size_t size = indices->size();
+
+    // levels are ordered from the most detailed one
+    if (mesh.lods())
     {
-        glGenVertexArrays(1, &m_vao);
-        CheckGlError("glGenVertexArrays");
+        for (const ModelData::MeshLod * lod : *mesh.lods())
+        {
+            const flatbuffers::Vector<T> * lodIndices = GetIndices<T>(*lod);
+            if (!lodIndices)
+                break;
 
-        glBindVertexArray(m_vao);
-        CheckGlError("glBindVertexArray");
+            m_lods.push_back({ size * sizeof(T), lodIndices->size(), lod->error() });
+            size += lodIndices->size();
+        }
     }
 
-    m_positions = CreateFloatVBO<ModelData::Vec3, 3>(m_material->shader->GetShader().GetLocation("positionModelSpace", Shader::LocationType::Attrib), positions, bindVAO);
-    m_normals = CreateFloatVBO<ModelData::Vec3, 3>(m_material->shader->GetShader().GetLocation("normalModelSpace", Shader::LocationType::Attrib), normals, bindVAO);
+    // TODO can be element buffer binded to vao ???
+    // element buffer binding belongs to vao, the one of last draw may be still bound
+    if (IsVAOSupported())
+        GLState::Instance().BindVertexArray(0);
+
+    glGenBuffers(1, &m_vboIndices);
+    GLState::Instance().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_vboIndices);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, size * sizeof(T), nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices->size() * sizeof(T), indices->data());
+
+    for (size_t i = 1; i < m_lods.size(); ++i)
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, m_lods[i].offset, m_lods[i].count * sizeof(T), GetIndices<T>(*mesh.lods()->Get(i - 1))->data());
+
+    m_indicesType = type;
+}
+
+void Mesh::InitBounds(const uint8_t * vertices, size_t size, const ModelData::VertexAttribute * layout, size_t layoutSize, uint32_t stride)
+{
+    auto position = std::find_if(layout, layout + layoutSize, [](const ModelData::VertexAttribute & attribute) { return attribute.usage() == ModelData::VertexUsage_Position; });
+
+    if (position == layout + layoutSize || position->format() != ModelData::VertexFormat_Float || position->components() < 3 || stride == 0)
+        return;
 
-    if (m_material->shader->GetConfig().textures.normal.size())
+    size_t count = size / stride;
+    if (count == 0)
+        return;
+
+    auto read = [&](size_t i)
     {
-        m_tangents = CreateFloatVBO<ModelData::Vec3, 3>(m_material->shader->GetShader().GetLocation("tangentModelSpace", Shader::LocationType::Attrib), tangents, bindVAO);
-        //m_bitangents = CreateFloatVBO<ModelData::Vec3, 3>(m_shader->GetShader().GetLocation("bitangentModelSpace", Shader::LocationType::Attrib), bitangents, bindVAO);
-    }
+        glm::vec3 result;
+        memcpy(&result, vertices + i * stride + position->offset(), sizeof(result));
+        return result;
+    };
 
-    for (uint32_t i = 0; i < m_material->shader->GetConfig().GetUVChannelsCount(); ++i)
+    glm::vec3 min = read(0);
+    glm::vec3 max = min;
+    for (size_t i = 1; i < count; ++i)
     {
-        m_texCoords.push_back(CreateFloatVBO<ModelData::Vec2, 2>(m_material->shader->GetShader().GetLocation("vertexUV" + std::to_string(i), Shader::LocationType::Attrib),
-            &texCoords[i * positions.size()], positions.size(), bindVAO));
+        glm::vec3 point = read(i);
+        min = glm::min(min, point);
+        max = glm::max(max, point);
     }
 
-    glBindVertexArray(0);
+    m_bounds.lower = min;
+    m_bounds.upper = max;
+    m_bounds.center = (min + max) * 0.5f;
+    m_bounds.radius = 0.0f;
+    for (size_t i = 0; i < count; ++i)
+        m_bounds.radius = std::max(m_bounds.radius, glm::distance(m_bounds.center, read(i)));
+}
 
-    // TODO can be element buffer binded to vao ???
-    glGenBuffers(1, &m_vboIndices);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_vboIndices);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), &indices[0], GL_STATIC_DRAW);
+const ModelBounds & Mesh::GetBounds() const
+{
+    return m_bounds;
+}
+
+const Mesh::Lod & Mesh::SelectLod(const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection) const
+{
+    if (m_lods.size() == 1)
+        return m_lods[0];
 
-    m_verticesCount = indices.size();
+    // error is in model space, scale it to world space
+    float scale = GetMaxScale(model);
+
+    // pixels per world unit, for perspective at the nearest point of bounding sphere
+    float pixels = projection[1][1] * 0.5f * (float)Common::GetWindowHeight();
+    if (projection[2][3] != 0.0f)
+    {
+        glm::vec3 centerViewSpace = glm::vec3(view * model * glm::vec4(m_bounds.center, 1.0f));
+        float distance = glm::length(centerViewSpace) - m_bounds.radius * scale;
+
+        // camera is inside of bounding sphere
+        if (distance <= 0.0f)
+            return m_lods[0];
+
+        pixels /= distance;
+    }
+
+    for (size_t i = m_lods.size() - 1; i > 0; --i)
+    {
+        if (m_lods[i].error * scale * pixels <= LOD_PIXEL_ERROR)
+            return m_lods[i];
+    }
+
+    return m_lods[0];
 }
 
 ModelShader::TextureStackEntry::Operation Convert(ModelData::TextureOperation operation)
@@ -196,82 +400,95 @@ ModelShader::TextureStackEntry::Operation Convert(ModelData::TextureOperation op
     return ModelShader::TextureStackEntry::Operation::Add;
 }
 
-bool ProcessTextures(const std::string & root, std::vector<std::unique_ptr<ModelData::TextureT>> & data, std::vector<ModelShader::TextureStackEntry> & stack, std::vector<GLuint> & textures)
+bool ProcessTextures(const std::string & root, const flatbuffers::Vector<flatbuffers::Offset<ModelData::Texture>> * data, std::vector<ModelShader::TextureStackEntry> & stack, std::vector<GLuint> & textures)
 {
-    for (size_t i = 0; i < data.size(); ++i)
+    if (!data)
+        return true;
+
+    for (const ModelData::Texture * texture : *data)
     {
         ModelShader::TextureStackEntry entry;
-        entry.factor = data[i]->blendFactor;
-        entry.operation = Convert(data[i]->operation);
-        entry.uvIndex = data[i]->uvIndex;
+        entry.factor = texture->blendFactor();
+        entry.operation = Convert(texture->operation());
+        entry.uvIndex = texture->uvIndex();
 
-        auto texture = TextureManager::Instance().GetTexture((root + data[i]->path).c_str());
-        if (!texture)
+        std::string path = root + (texture->path() ? texture->path()->str() : std::string());
+
+        auto textureId = TextureManager::Instance().GetTexture(path.c_str());
+        if (!textureId)
         {
-            printf("Error loading texture %s", (root + data[i]->path).c_str());
+            printf("Error loading texture %s", path.c_str());
             return false;
         }
 
-        textures.push_back(*texture);
+        textures.push_back(*textureId);
         stack.push_back(entry);
     }
 
     return true;
 }
 
-std::unique_ptr<ModelMaterial> Model::CreateMaterial(const std::string & root, ModelData::MaterialT & material)
+std::unique_ptr<ModelMaterial> Model::CreateMaterial(const std::string & root, const ModelData::Material & material, uint32_t flags, ModelShader::Config & config)
 {
-    ModelShader::Config config;
     std::unique_ptr<ModelMaterial> result = std::make_unique<ModelMaterial>();
 
     config.light = m_configLight;
-
-    memset(&config.material, 0, sizeof(config.material));
-
-    if (material.ambient)
-        config.material.ambient = Convert(*material.ambient);
-    if (material.diffuse)
-        config.material.diffuse = Convert(*material.diffuse);
-    if (material.specular)
-        config.material.specular = Convert(*material.specular);
-    config.material.shininess = material.shininess;
-    config.material.shininessStrength = material.shininessStrength;
-
-    if (!ProcessTextures(root, material.textureAmbient, config.textures.ambient, result->textures.ambient))
+    // materials differing only in values share program
+    config.flags = flags | (uint32_t)ModelShader::Config::Flags::UseRuntimeMaterial;
+
+    memset(&result->material, 0, sizeof(result->material));
+
+    if (material.ambient())
+        result->material.ambient = Convert(*material.ambient());
+    if (material.diffuse())
+        result->material.diffuse = Convert(*material.diffuse());
+    if (material.specular())
+        result->material.specular = Convert(*material.specular());
+    result->material.shininess = material.shininess();
+    result->material.shininessStrength = material.shininessStrength();
+    config.material = result->material;
+
+    if (!ProcessTextures(root, material.textureAmbient(), config.textures.ambient, result->textures.ambient))
         return nullptr;
-    if (!ProcessTextures(root, material.textureDiffuse, config.textures.diffuse, result->textures.diffuse))
+    if (!ProcessTextures(root, material.textureDiffuse(), config.textures.diffuse, result->textures.diffuse))
         return nullptr;
-    if (!ProcessTextures(root, material.textureSpecular, config.textures.specular, result->textures.specular))
+    if (!ProcessTextures(root, material.textureSpecular(), config.textures.specular, result->textures.specular))
         return nullptr;
-    if (!ProcessTextures(root, material.textureNormal, config.textures.normal, result->textures.normal))
+    if (!ProcessTextures(root, material.textureNormal(), config.textures.normal, result->textures.normal))
         return nullptr;
-    if (!ProcessTextures(root, material.textureLightmap, config.textures.lightmap, result->textures.lightmap))
+    if (!ProcessTextures(root, material.textureLightmap(), config.textures.lightmap, result->textures.lightmap))
         return nullptr;
 
     config.shading = ModelShader::ShadingModel::BlinnPhong;
 
-    result->shader = std::make_unique<ModelShader>(config);
-    if (!result->shader.get())
-        return nullptr;
-
     return result;
 }
 
 Model::Model(const char * path, Light::Config light)
     : m_configLight(light)
 {
-    auto data = Common::ReadFile(path);
-    auto model = ModelData::UnPackModel(data.data());
+    auto data = Common::MapFile(path);
+
+    // data are verified once and then used in place without unpacking
+    flatbuffers::Verifier verifier(data.data(), data.size());
+    if (!ModelData::VerifyModelBuffer(verifier))
+    {
+        printf("Error loading model %s, invalid file", path);
+        throw std::runtime_error("Error loading model.");
+    }
+
+    const ModelData::Model * model = ModelData::GetModel(data.data());
     auto root = Common::GetDirectoryFromFilePath(path);
 
     // process materials
-    ProcessMaterials(model.get(), root);
+    ProcessMaterials(*model, root);
 
     // process meshes
-    ProcessMeshes(model.get());
+    ProcessMeshes(*model);
 
     // recursively process tree
-    m_tree = ProcessTree(*model->tree);
+    if (model->tree())
+        m_tree = ProcessTree(*model->tree());
 }
 
 Model::~Model()
@@ -280,11 +497,36 @@ Model::~Model()
     m_meshes.clear();
 }
 
-void Model::ProcessMaterials(ModelData::ModelT * model, const std::string & root)
+void Model::ProcessMaterials(const ModelData::Model & model, const std::string & root)
 {
-    for (size_t i = 0; i < model->materials.size(); ++i)
+    if (!model.materials())
+        return;
+
+    // shader of material decodes vertices, so all its meshes need the same vertex formats
+    std::vector<std::optional<uint32_t>> flags(model.materials()->size());
+    if (model.meshes())
+    {
+        for (const ModelData::Mesh * mesh : *model.meshes())
+        {
+            if (mesh->material() >= flags.size())
+                continue;
+
+            uint32_t meshFlags = GetVertexFlags(*mesh);
+            if (flags[mesh->material()] && *flags[mesh->material()] != meshFlags)
+            {
+                printf("Error loading model, meshes of material %d have different vertex formats", mesh->material());
+                throw std::runtime_error("Error loading model.");
+            }
+
+            flags[mesh->material()] = meshFlags;
+        }
+    }
+
+    std::vector<ModelShader::Config> configs(model.materials()->size());
+    for (size_t i = 0; i < model.materials()->size(); ++i)
     {
-        auto material = CreateMaterial(root, *model->materials[i].get());
+        const ModelData::Material * data = model.materials()->Get(i);
+        auto material = CreateMaterial(root, *data, flags[i].value_or(0), configs[i]);
         if (!material)
         {
             printf("Error creating material.");
@@ -293,26 +535,42 @@ void Model::ProcessMaterials(ModelData::ModelT * model, const std::string & root
 
         m_materials.push_back(std::move(material));
     }
+
+    // shaders of all materials are compiled together, textured ones in background
+    std::vector<ModelShaderPtr> shaders = ModelShaderManager::Instance().GetShaders(configs);
+    for (size_t i = 0; i < m_materials.size(); ++i)
+        m_materials[i]->shader = shaders[i];
 }
 
-void Model::ProcessMeshes(ModelData::ModelT * model)
+void Model::ProcessMeshes(const ModelData::Model & model)
 {
-    for (size_t i = 0; i < model->meshes.size(); ++i)
+    if (!model.meshes())
+        return;
+
+    for (const ModelData::Mesh * mesh : *model.meshes())
     {
         // TODO check is mesh constructed successfully
-        m_meshes.push_back(std::make_unique<Mesh>(*model->meshes[i].get(), m_materials));
+        m_meshes.push_back(std::make_unique<Mesh>(*mesh, m_materials));
     }
 }
 
-Model::Tree Model::ProcessTree(ModelData::TreeT & node)
+Model::Tree Model::ProcessTree(const ModelData::Tree & node)
 {
     Model::Tree result;
 
-    result.transform = Convert(*node.transform);
-    result.meshes = node.meshes;
+    result.transform = node.transform() ? Convert(*node.transform()) : glm::mat4(1.0f);
+
+    if (node.bounds())
+        result.bounds = Convert(*node.bounds());
+
+    if (node.meshes())
+        result.meshes.assign(node.meshes()->begin(), node.meshes()->end());
 
-    for (auto & child : node.childs)
-        result.childs.push_back(ProcessTree(*child));
+    if (node.childs())
+    {
+        for (const ModelData::Tree * child : *node.childs())
+            result.childs.push_back(ProcessTree(*child));
+    }
 
     return result;
 }
@@ -325,7 +583,6 @@ void Model::Bind(const Data & data)
 
         material->shader->BindCamera(data.cameraWorldSpace);
         material->shader->BindLight(data.light);
-        material->shader->BindMaterial(data.material);
 
         material->shader->EndRender();
     }
@@ -333,17 +590,47 @@ void Model::Bind(const Data & data)
 
 void Model::Draw(const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection)
 {
-    DrawInternal(m_tree, model, view, projection);
+    m_statistics = {};
+
+    // bounds are tested in world space
+    Frustum frustum(projection * view);
+
+    DrawInternal(m_tree, model, view, projection, frustum);
+}
+
+const Model::Statistics & Model::GetStatistics() const
+{
+    return m_statistics;
 }
 
-void Model::DrawInternal(Tree & tree, const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection)
+void Model::DrawInternal(Tree & tree, const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection, const Frustum & frustum)
 {
     glm::mat4 nodeModel = model * tree.transform;
     //glm::mat4 nodeModel = model;
 
+    // whole subtree is skipped when the node is not visible
+    if (tree.bounds)
+    {
+        m_statistics.nodes.tested++;
+        if (!tree.bounds->IsVisible(frustum, nodeModel))
+        {
+            m_statistics.nodes.culled++;
+            return;
+        }
+    }
+
     for (uint32_t i : tree.meshes)
+    {
+        m_statistics.meshes.tested++;
+        if (!m_meshes[i]->GetBounds().IsVisible(frustum, nodeModel))
+        {
+            m_statistics.meshes.culled++;
+            continue;
+        }
+
         m_meshes[i]->Draw(nodeModel, view, projection);
+    }
 
     for (Tree & child : tree.childs)
-        DrawInternal(child, nodeModel, view, projection);
+        DrawInternal(child, nodeModel, view, projection, frustum);
 }
@@ -2,49 +2,97 @@
 #include "OpenGL.h"
 #include "model_generated.h"
 #include "ModelShader.h"
+#include "utils/Frustum.h"
 #include <vector>
 #include <memory>
 #include <string>
+#include <optional>
 
 struct ModelMaterial
 {
+    Material::Data material;
     Textures::Data textures;
-    std::unique_ptr<ModelShader> shader;
+    // shared with other materials of the same variant
+    ModelShaderPtr shader;
+};
+
+// bounding volumes in model space
+struct ModelBounds
+{
+    glm::vec3 lower = glm::vec3(0.0f);
+    glm::vec3 upper = glm::vec3(0.0f);
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    // cheap sphere test first, then box
+    bool IsVisible(const Frustum & frustum, const glm::mat4 & model) const;
 };
 
 class Mesh
 {
 public:
 
-    Mesh(const ModelData::MeshT & mesh, std::vector<std::unique_ptr<ModelMaterial>> & materials);
+    Mesh(const ModelData::Mesh & mesh, std::vector<std::unique_ptr<ModelMaterial>> & materials);
     ~Mesh();
 
     void Draw(const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection);
 
+    const ModelBounds & GetBounds() const;
+
 private:
-    void InitBuffers(const std::vector<ModelData::Vec3> & positions,
-                        const std::vector<ModelData::Vec3> & normals,
-                        const std::vector<ModelData::Vec2> & texCoords,
-                        const std::vector<ModelData::Vec3> & tangents,
-                        const std::vector<ModelData::Vec3> & bitangents,
-                        const std::vector<uint16_t> & indices);
+    void InitBuffers(const uint8_t * vertices, size_t size, const ModelData::VertexAttribute * layout, size_t layoutSize, uint32_t stride);
+
+    // full mesh and its levels of detail share one element buffer
+    template<class T>
+    void InitIndices(const ModelData::Mesh & mesh, GLenum type);
+
+    // computes bounds for models converted without them
+    void InitBounds(const uint8_t * vertices, size_t size, const ModelData::VertexAttribute * layout, size_t layoutSize, uint32_t stride);
+
+    // range of element buffer drawn for given level of detail
+    struct Lod
+    {
+        // offset in bytes
+        uintptr_t offset;
+        GLuint count;
+        // maximal distance from full mesh, in model space
+        float error;
+    };
+
+    // coarsest level with projected error below one pixel
+    const Lod & SelectLod(const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection) const;
 
     // bind mesh specific uniforms
     void BindUniforms(const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection);
 
     void BindBuffers();
 
+    // vertex attribute used by shader
+    struct Attribute
+    {
+        GLuint location;
+        GLint components;
+        // GL_FLOAT or normalized integer type of compact layout
+        GLenum type;
+        GLboolean normalized;
+        uint32_t offset;
+    };
+
     GLuint m_vao;
 
-    GLuint m_positions;
-    GLuint m_normals;
-    std::vector<GLuint> m_texCoords;
-    GLuint m_tangents;
-    GLuint m_bitangents;
+    // interleaved vertex data
+    GLuint m_vbo;
+    GLuint m_vertexStride;
+    std::vector<Attribute> m_attributes;
 
     GLuint m_vboIndices;
+    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLenum m_indicesType;
+
+    // first level is the full mesh
+    std::vector<Lod> m_lods;
 
-    GLuint m_verticesCount;
+    ModelBounds m_bounds;
 
     ModelMaterial * m_material;
 };
@@ -55,9 +103,9 @@ public:
     Model(const char * path, Light::Config light);
     ~Model();
 
+    // materials of meshes are given by model file
     struct Data
     {
-        Material::Data material;
         Light::Data light;
         glm::vec3 cameraWorldSpace;
     };
@@ -66,29 +114,44 @@ public:
     // camera and light positions should be in world space
     void Bind(const Data & data);
     
+    // nodes and meshes outside of view frustum are skipped
     void Draw(const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection);
 
+    // culling counters of last Draw
+    struct Statistics
+    {
+        Frustum::Statistics nodes;
+        Frustum::Statistics meshes;
+    };
+    const Statistics & GetStatistics() const;
+
 private:
     struct Tree
     {
-        glm::mat4 transform;
+        glm::mat4 transform = glm::mat4(1.0f);
         std::vector<uint32_t> meshes;
         std::vector<Tree> childs;
+        // missing in models converted without bounds, such node is never culled
+        std::optional<ModelBounds> bounds;
     };
 
-    void ProcessMaterials(ModelData::ModelT * model, const std::string & root);
-    void ProcessMeshes(ModelData::ModelT * model);
-    Tree ProcessTree(ModelData::TreeT & node);
+    void ProcessMaterials(const ModelData::Model & model, const std::string & root);
+    void ProcessMeshes(const ModelData::Model & model);
+    Tree ProcessTree(const ModelData::Tree & node);
 
-    void DrawInternal(Tree & tree, const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection);
+    void DrawInternal(Tree & tree, const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection, const Frustum & frustum);
 
     const Light::Config m_configLight;
 
-    std::unique_ptr<ModelMaterial> CreateMaterial(const std::string & root, ModelData::MaterialT & material);
+    // flags are ModelShader::Config::Flags given by vertex formats of meshes using the material,
+    // shader is created for config of all materials at once
+    std::unique_ptr<ModelMaterial> CreateMaterial(const std::string & root, const ModelData::Material & material, uint32_t flags, ModelShader::Config & config);
     std::vector<std::unique_ptr<ModelMaterial>> m_materials;
 
     std::vector<std::unique_ptr<Mesh>> m_meshes;
 
 
     Tree m_tree;
+
+    Statistics m_statistics;
 };
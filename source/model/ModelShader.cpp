@@ -1,6 +1,8 @@
 #include "ModelShader.h"
 #include "ShaderGenerator.h"
+#include "ModelShaderManager.h"
 #include <algorithm>
+#include <cstddef>
 
 template<class T>
 void ModelShader::InitLocation(const std::string & path, T & location)
@@ -59,23 +61,87 @@ void ModelShader::InitLocation<Material::Locations>(const std::string & path, Ma
 }
 
 ModelShader::ModelShader(Config config)
-    : m_config(config)
+    : ModelShader(config, ShaderGenerator::Generate(config), nullptr)
 {
-    auto shaders = ShaderGenerator::Generate(config);
+}
+
+ModelShader::ModelShader(Config config, const ShaderGenerator::Result & shaders, ModelShaderPtr fallback)
+    : m_config(config), m_fallback(fallback)
+{
+    AttributeLocations attributes = InitAttributeLocations();
+
+    m_shader = std::make_unique<Shader>(shaders.vertex.c_str(), shaders.fragment.c_str(), attributes, (bool)m_fallback);
+
+    InitShadows();
+    ResetShadowState();
+
+    if (!m_fallback)
+        InitProgram();
+}
+
+void ModelShader::InitProgram()
+{
+    if (!*m_shader)
+        return;
 
-    m_shader = std::make_unique<Shader>(shaders.vertex.c_str(), shaders.fragment.c_str());
+    m_shader->PrintUniforms();
+    m_shader->PrintAttributes();
 
+    InitModelLocations();
+    InitMeshLocations();
+}
+
+bool ModelShader::Update()
+{
+    if (!m_fallback)
+        return true;
+
+    if (!m_shader->IsReady())
+        return false;
+
+    // fallback stays when program failed, errors are reported already
     if (*m_shader)
     {
-        m_shader->PrintUniforms();
-        m_shader->PrintAttributes();
+        InitProgram();
+        m_fallback.reset();
+    }
+
+    return true;
+}
+
+AttributeLocations ModelShader::InitAttributeLocations()
+{
+    // assigned in order of presence, textures come last so variant without them has the same locations
+    AttributeLocations result;
+    GLuint next = 0;
+    auto Add = [&result, &next](const std::string & name, GLuint count)
+    {
+        result.push_back({ name, next });
+        next += count;
+        return next - count;
+    };
 
-        InitModelLocations();
-        InitMeshLocations();
+    m_locations.buffers = {};
+    m_locations.buffers.normals = m_locations.buffers.tangents = m_locations.buffers.bitangents = GLuint(-1);
 
-        InitShadows();
-        ResetShadowState();
+    m_locations.buffers.positions = Add("positionModelSpace", 1);
+    if (m_config.light.directional || m_config.light.pointCount || m_config.light.spotCount)
+        m_locations.buffers.normals = Add("normalModelSpace", 1);
+    if (m_config.flags & (uint32_t)Config::Flags::Instanced)
+    {
+        // mat4 takes 4 locations
+        m_locations.instances.model = Add("instanceModel", 4);
+        m_locations.instances.ambient = Add("instanceAmbient", 1);
+        m_locations.instances.diffuse = Add("instanceDiffuse", 1);
+        m_locations.instances.specular = Add("instanceSpecular", 1);
+        m_locations.instances.shininess = Add("instanceShininess", 1);
     }
+    if (m_config.textures.normal.size())
+        m_locations.buffers.tangents = Add("tangentModelSpace", 1);
+    for (uint32_t i = 0; i < m_config.GetUVChannelsCount(); ++i)
+        m_locations.buffers.texCoords.push_back(Add("vertexUV" + std::to_string(i), 1));
+
+    return result;
 }
 
 const ModelShader::Config & ModelShader::GetConfig()
@@ -90,6 +156,9 @@ const ModelShader::Locations & ModelShader::GetLocations()
 
 Shader & ModelShader::GetShader()
 {
+    if (m_fallback)
+        return m_fallback->GetShader();
+
     return *m_shader;
 }
 
@@ -121,16 +190,20 @@ void ModelShader::InitTextureLocations(const std::string & path, uint32_t count,
 
 void ModelShader::InitMeshLocations()
 {
-    // VBOs
-    m_locations.buffers.positions = m_shader->GetLocation("positionModelSpace", Shader::LocationType::Attrib);
-    if (m_config.light.directional || m_config.light.pointCount || m_config.light.spotCount)
-        m_locations.buffers.normals = m_shader->GetLocation("normalModelSpace", Shader::LocationType::Attrib);
-    for (uint32_t i = 0; i < m_config.GetUVChannelsCount(); ++i)
-        m_locations.buffers.texCoords.push_back(m_shader->GetLocation("vertexUV" + std::to_string(i), Shader::LocationType::Attrib));
-    if (m_config.textures.normal.size())
+    // transform
+    m_locations.MVP = m_locations.M = m_locations.VP = GLuint(-1);
+    if (m_config.flags & (uint32_t)Config::Flags::Instanced)
+        m_locations.VP = m_shader->GetLocation("VP", Shader::LocationType::Uniform);
+    else
+    {
+        m_locations.MVP = m_shader->GetLocation("MVP", Shader::LocationType::Uniform);
+        m_locations.M = m_shader->GetLocation("M", Shader::LocationType::Uniform);
+    }
+
+    if (m_config.flags & (uint32_t)Config::Flags::QuantizedPositions)
     {
-        m_locations.buffers.tangents = m_shader->GetLocation("tangentModelSpace", Shader::LocationType::Attrib);
-        //m_locations.buffers.bitangents = m_shader->GetLocation("bitangentModelSpace", Shader::LocationType::Attrib);
+        m_locations.positionOffset = m_shader->GetLocation("positionOffset", Shader::LocationType::Uniform);
+        m_locations.positionScale = m_shader->GetLocation("positionScale", Shader::LocationType::Uniform);
     }
 
     // textures
@@ -226,26 +299,38 @@ void ModelShader::Bind<Material::Data, Material::Locations>(const Material::Data
 
 void ModelShader::BeginRender()
 {
+    if (m_fallback)
+        return m_fallback->BeginRender();
+
     m_shader->BeginRender();
 }
 
 void ModelShader::EndRender()
 {
+    if (m_fallback)
+        return m_fallback->EndRender();
+
     m_shader->EndRender();
 
     ResetShadowState();
 
-    //m_shadows.directional->DrawDebug();
+    //m_shadows.maps->directional->DrawDebug();
 }
 
 void ModelShader::BindMaterial(const Material::Data & data)
 {
+    if (m_fallback)
+        return m_fallback->BindMaterial(data);
+
     if (m_config.flags & (uint32_t)Config::Flags::UseRuntimeMaterial)
         Bind(data, m_locations.material);
 }
 
 void ModelShader::BindLight(const Light::Data & data)
 {
+    if (m_fallback)
+        return m_fallback->BindLight(data);
+
     if (m_config.light.directional)
         Bind(data.lightDirectional, m_locations.light.lightDirectional);
 
@@ -274,41 +359,105 @@ void ModelShader::BindShadows()
     };
 
     if (m_config.light.directional)
-        BindData(m_shadows.directional->GetLightSpaceMatrix(),
-                 m_shadows.directional->GetTexture(),
-                 m_shadows.directional->GetTextureSize(),
-                 m_shadows.directional->GetPlanes().y,
+        BindData(m_shadows.maps->directional->GetLightSpaceMatrix(),
+                 m_shadows.maps->directional->GetTexture(),
+                 m_shadows.maps->directional->GetTextureSize(),
+                 m_shadows.maps->directional->GetPlanes().y,
                  m_locations.light.lightDirectional);
 
     for (size_t i = 0; i < m_config.light.pointCount; ++i)
-        BindCubeData(m_shadows.point[i]->GetTexture(),
-                     m_shadows.point[i]->GetTextureSize(),
-                     m_shadows.point[i]->GetPlanes().y,
+        BindCubeData(m_shadows.maps->point[i]->GetTexture(),
+                     m_shadows.maps->point[i]->GetTextureSize(),
+                     m_shadows.maps->point[i]->GetPlanes().y,
                      (const Light::Locations::Light&)m_locations.light.lightPoint[i]);
 
     for (size_t i = 0; i < m_config.light.spotCount; ++i)
-        BindData(m_shadows.spot[i]->GetLightSpaceMatrix(),
-                 m_shadows.spot[i]->GetTexture(),
-                 m_shadows.spot[i]->GetTextureSize(),
-                 m_shadows.spot[i]->GetPlanes().y,
+        BindData(m_shadows.maps->spot[i]->GetLightSpaceMatrix(),
+                 m_shadows.maps->spot[i]->GetTexture(),
+                 m_shadows.maps->spot[i]->GetTextureSize(),
+                 m_shadows.maps->spot[i]->GetPlanes().y,
                 (const Light::Locations::Light&)m_locations.light.lightSpot[i]);
 }
 
 void ModelShader::BindCamera(const glm::vec3 & cameraWorldSpace)
 {
+    if (m_fallback)
+        return m_fallback->BindCamera(cameraWorldSpace);
+
     m_shader->SetUniform(cameraWorldSpace, m_locations.cameraWorldSpace);
 }
 
 void ModelShader::BindTransform(const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection)
 {
+    if (m_fallback)
+        return m_fallback->BindTransform(model, view, projection);
+
     glm::mat4 MVP = projection * view * model;
 
-    m_shader->SetUniform(MVP, "MVP");
-    m_shader->SetUniform(model, "M");
+    m_shader->SetUniform(MVP, m_locations.MVP);
+    m_shader->SetUniform(model, m_locations.M);
+}
+
+void ModelShader::BindViewProjection(const glm::mat4 & view, const glm::mat4 & projection)
+{
+    if (m_fallback)
+        return m_fallback->BindViewProjection(view, projection);
+
+    m_shader->SetUniform(projection * view, m_locations.VP);
+}
+
+void ModelShader::BindInstances(GLuint buffer, uint32_t offset)
+{
+    if (m_fallback)
+        return m_fallback->BindInstances(buffer, offset);
+
+    const Instances::Locations & locations = m_locations.instances;
+    const uint32_t stride = sizeof(Instances::Data);
+
+    for (GLuint column = 0; column < 4; ++column)
+        m_shader->BindBuffer(buffer, locations.model + column, 4, GL_FLOAT, GL_FALSE, offset + offsetof(Instances::Data, model) + column * sizeof(glm::vec4), stride);
+    m_shader->BindBuffer(buffer, locations.ambient, 3, GL_FLOAT, GL_FALSE, offset + offsetof(Instances::Data, ambient), stride);
+    m_shader->BindBuffer(buffer, locations.diffuse, 3, GL_FLOAT, GL_FALSE, offset + offsetof(Instances::Data, diffuse), stride);
+    m_shader->BindBuffer(buffer, locations.specular, 3, GL_FLOAT, GL_FALSE, offset + offsetof(Instances::Data, specular), stride);
+    m_shader->BindBuffer(buffer, locations.shininess, 2, GL_FLOAT, GL_FALSE, offset + offsetof(Instances::Data, shininess), stride);
+
+    for (GLuint location : { locations.model, locations.model + 1, locations.model + 2, locations.model + 3, locations.ambient, locations.diffuse, locations.specular, locations.shininess })
+        glVertexAttribDivisor(location, 1);
+    CheckGlError("glVertexAttribDivisor");
+}
+
+void ModelShader::UnbindInstances()
+{
+    if (m_fallback)
+        return m_fallback->UnbindInstances();
+
+    const Instances::Locations & locations = m_locations.instances;
+
+    for (GLuint location : { locations.model, locations.model + 1, locations.model + 2, locations.model + 3, locations.ambient, locations.diffuse, locations.specular, locations.shininess })
+    {
+        glVertexAttribDivisor(location, 0);
+        glDisableVertexAttribArray(location);
+    }
+    CheckGlError("glDisableVertexAttribArray");
+}
+
+void ModelShader::BindPositionBounds(const glm::vec3 & lower, const glm::vec3 & upper)
+{
+    if (m_fallback)
+        return m_fallback->BindPositionBounds(lower, upper);
+
+    if (!(m_config.flags & (uint32_t)Config::Flags::QuantizedPositions))
+        return;
+
+    m_shader->SetUniform(lower, m_locations.positionOffset);
+    m_shader->SetUniform(upper - lower, m_locations.positionScale);
 }
 
 void ModelShader::BindTextures(const Textures::Data & data)
 {
+    if (m_fallback)
+        return m_fallback->BindTextures(data);
+
     for (size_t i = 0; i < m_config.textures.ambient.size(); ++i)
         m_shader->BindTexture(data.ambient[i], m_locations.textures.textureAmbient[i]);
 
@@ -327,12 +476,7 @@ void ModelShader::BindTextures(const Textures::Data & data)
 
 void ModelShader::InitShadows()
 {
-    if (m_config.light.directional)
-        m_shadows.directional = std::make_unique<ShadowDirectionalLight>();
-    for (uint32_t i = 0; i < m_config.light.pointCount; ++i)
-        m_shadows.point.emplace_back(std::make_unique<ShadowPointLight>());
-    for (uint32_t i = 0; i < m_config.light.spotCount; ++i)
-        m_shadows.spot.emplace_back(std::make_unique<ShadowSpotLight>());
+    m_shadows.maps = ModelShaderManager::Instance().GetShadowMaps(m_config.light);
 }
 
 void ModelShader::ResetShadowState()
@@ -342,28 +486,44 @@ void ModelShader::ResetShadowState()
     m_shadows.spotCounter = 0;
 }
 
-bool ModelShader::BeginRenderShadow(const Light::Data & light)
+bool ModelShader::BeginRenderShadow(const Light::Data & light, const std::optional<uint64_t> & casters)
 {
+    if (m_fallback)
+        return m_fallback->BeginRenderShadow(light, casters);
+
+    m_shadows.casters = casters;
+
+    // cached maps are skipped, their textures are bound as they are
     if (m_config.light.directional && m_shadows.directionalState)
     {
-        m_shadows.directional->SetLightData(light.lightDirectional.direction);
-        m_shadows.directional->BeginRender();
-        return true;
+        m_shadows.maps->directional->SetLightData(light.lightDirectional.direction);
+        if (!m_shadows.maps->directional->IsCached(casters))
+        {
+            m_shadows.maps->directional->BeginRender();
+            return true;
+        }
+        m_shadows.directionalState = false;
     }
 
-    if (m_shadows.pointCounter < m_config.light.pointCount)
+    for (; m_shadows.pointCounter < m_config.light.pointCount; m_shadows.pointCounter++)
     {
-        m_shadows.point[m_shadows.pointCounter]->SetLightData(light.lightPoint[m_shadows.pointCounter].position);
-        m_shadows.point[m_shadows.pointCounter]->BeginRender();
-        return true;
+        m_shadows.maps->point[m_shadows.pointCounter]->SetLightData(light.lightPoint[m_shadows.pointCounter].position);
+        if (!m_shadows.maps->point[m_shadows.pointCounter]->IsCached(casters))
+        {
+            m_shadows.maps->point[m_shadows.pointCounter]->BeginRender();
+            return true;
+        }
     }
 
-    if (m_shadows.spotCounter < m_config.light.spotCount)
+    for (; m_shadows.spotCounter < m_config.light.spotCount; m_shadows.spotCounter++)
     {
-        m_shadows.spot[m_shadows.spotCounter]->SetLightData(light.lightSpot[m_shadows.spotCounter].position, light.lightSpot[m_shadows.spotCounter].direction,
+        m_shadows.maps->spot[m_shadows.spotCounter]->SetLightData(light.lightSpot[m_shadows.spotCounter].position, light.lightSpot[m_shadows.spotCounter].direction,
                                                             light.lightSpot[m_shadows.spotCounter].cutOff, light.lightSpot[m_shadows.spotCounter].outerCutOff);
-        m_shadows.spot[m_shadows.spotCounter]->BeginRender();
-        return true;
+        if (!m_shadows.maps->spot[m_shadows.spotCounter]->IsCached(casters))
+        {
+            m_shadows.maps->spot[m_shadows.spotCounter]->BeginRender();
+            return true;
+        }
     }
 
     // At this point all shadows has been rendered and main shader is bound (see EndRenderShadow()).
@@ -375,19 +535,25 @@ bool ModelShader::BeginRenderShadow(const Light::Data & light)
 
 void ModelShader::EndRenderShadow()
 {
+    if (m_fallback)
+        return m_fallback->EndRenderShadow();
+
     if (m_config.light.directional && m_shadows.directionalState)
     {
-        m_shadows.directional->EndRender();
+        m_shadows.maps->directional->EndRender();
+        m_shadows.maps->directional->SetCached(m_shadows.casters);
         m_shadows.directionalState = false;
     }
     else if (m_shadows.pointCounter < m_config.light.pointCount)
     {
-        m_shadows.point[m_shadows.pointCounter]->EndRender();
+        m_shadows.maps->point[m_shadows.pointCounter]->EndRender();
+        m_shadows.maps->point[m_shadows.pointCounter]->SetCached(m_shadows.casters);
         m_shadows.pointCounter++;
     }
     else if (m_shadows.spotCounter < m_config.light.spotCount)
     {
-        m_shadows.spot[m_shadows.spotCounter]->EndRender();
+        m_shadows.maps->spot[m_shadows.spotCounter]->EndRender();
+        m_shadows.maps->spot[m_shadows.spotCounter]->SetCached(m_shadows.casters);
         m_shadows.spotCounter++;
     }
 
@@ -396,23 +562,43 @@ void ModelShader::EndRenderShadow()
     BeginRender();
 }
 
+std::optional<glm::mat4> ModelShader::GetShadowLightSpaceMatrix()
+{
+    if (m_fallback)
+        return m_fallback->GetShadowLightSpaceMatrix();
+
+    if (m_config.light.directional && m_shadows.directionalState)
+        return m_shadows.maps->directional->GetLightSpaceMatrix();
+
+    if (m_shadows.pointCounter < m_config.light.pointCount)
+        return std::nullopt;
+
+    if (m_shadows.spotCounter < m_config.light.spotCount)
+        return m_shadows.maps->spot[m_shadows.spotCounter]->GetLightSpaceMatrix();
+
+    return std::nullopt;
+}
+
 void ModelShader::BindTransformShadow(const glm::mat4 & model)
 {
+    if (m_fallback)
+        return m_fallback->BindTransformShadow(model);
+
     if (m_config.light.directional && m_shadows.directionalState)
     {
-        m_shadows.directional->GetShader().SetUniform(model, "model");
+        m_shadows.maps->directional->BindModel(model);
         return;
     }
 
     if (m_shadows.pointCounter < m_config.light.pointCount)
     {
-        m_shadows.point[m_shadows.pointCounter]->GetShader().SetUniform(model, "model");
+        m_shadows.maps->point[m_shadows.pointCounter]->BindModel(model);
         return;
     }
 
     if (m_shadows.spotCounter < m_config.light.spotCount)
     {
-        m_shadows.spot[m_shadows.spotCounter]->GetShader().SetUniform(model, "model");
+        m_shadows.maps->spot[m_shadows.spotCounter]->BindModel(model);
         return;
     }
 }
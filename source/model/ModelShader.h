@@ -130,6 +130,30 @@ namespace Textures
     };
 }
 
+namespace Instances
+{
+    // per instance attributes of instanced shader, tightly packed in vertex buffer
+    struct Data
+    {
+        glm::mat4 model;
+        glm::vec3 ambient;
+        glm::vec3 diffuse;
+        glm::vec3 specular;
+        // shininess and shininess strength
+        glm::vec2 shininess;
+    };
+
+    struct Locations
+    {
+        // mat4 takes 4 consecutive locations
+        GLuint model;
+        GLuint ambient;
+        GLuint diffuse;
+        GLuint specular;
+        GLuint shininess;
+    };
+}
+
 namespace Buffers
 {
     struct Locations
@@ -142,6 +166,14 @@ namespace Buffers
     };
 }
 
+namespace ShaderGenerator
+{
+    struct Result;
+}
+
+class ModelShader;
+using ModelShaderPtr = std::shared_ptr<ModelShader>;
+
 class ModelShader
 {
 public:
@@ -188,7 +220,14 @@ public:
         enum class Flags : uint32_t
         {
             // material will be binded at runtime from data
-            UseRuntimeMaterial = 0x0001
+            UseRuntimeMaterial = 0x0001,
+            // positions are unorm16 relative to mesh bounds, see BindPositionBounds
+            QuantizedPositions = 0x0002,
+            // normals are octahedral vec2, tangents octahedral vec2 with sign of bitangent as third component
+            OctahedralNormals = 0x0004,
+            // model matrix and material are per instance attributes, see Instances::Data,
+            // transform is bound by BindViewProjection, replaces UseRuntimeMaterial
+            Instanced = 0x0008
         };
 
         Material::Data material;
@@ -216,14 +255,41 @@ public:
 
         GLuint cameraWorldSpace;
 
+        // MVP and M when drawn one by one, VP when instanced
+        GLuint MVP;
+        GLuint M;
+        GLuint VP;
+
+        // decoding of quantized positions
+        GLuint positionOffset;
+        GLuint positionScale;
+
         Material::Locations material;
+        Instances::Locations instances;
         Light::Locations light;
         Textures::Locations textures;
     };
 
+    // shadow maps of lights, shared by all shaders with the same light config
+    struct ShadowMaps
+    {
+        std::unique_ptr<ShadowDirectionalLight> directional;
+        std::vector<std::unique_ptr<ShadowPointLight>> point;
+        std::vector<std::unique_ptr<ShadowSpotLight>> spot;
+    };
+
+    // shaders should be obtained from ModelShaderManager, which shares them between equal configs
     ModelShader(Config config);
+    // with fallback program is linked in background and rendering goes to fallback until it's ready,
+    // both must have the same vertex attributes (see InitAttributeLocations)
+    ModelShader(Config config, const ShaderGenerator::Result & shaders, ModelShaderPtr fallback);
+
+    // checks background link, returns true once it's finished
+    // called by ModelShaderManager between frames so one program is used within frame
+    bool Update();
 
     const Config & GetConfig();
+    // vertex attribute locations are valid before program is ready
     const Locations & GetLocations();
     Shader & GetShader();
 
@@ -240,7 +306,9 @@ public:
     // }
     // After that bind data and draw scene.
     // Begin render shadow must be called after BeginRender()
-    bool BeginRenderShadow(const Light::Data & data);
+    // Passes of maps rendered with the same light data and revision of casters are skipped,
+    // owner of casters changes revision when they move. None renders all maps.
+    bool BeginRenderShadow(const Light::Data & data, const std::optional<uint64_t> & casters = std::nullopt);
     void EndRenderShadow();
 
     // Also buffers must be bound like this (vao or vbo):
@@ -249,6 +317,16 @@ public:
     // See Buffers::Locations structure.
     void BindTransform(const glm::mat4 & model, const glm::mat4 & view, const glm::mat4 & projection);
     void BindTransformShadow(const glm::mat4 & model);
+    // bounds positions of drawn mesh were quantized to, used with QuantizedPositions only
+    void BindPositionBounds(const glm::vec3 & lower, const glm::vec3 & upper);
+    // used with Instanced only, instead of BindTransform
+    void BindViewProjection(const glm::mat4 & view, const glm::mat4 & projection);
+    // attributes of Instances::Data stored from offset of buffer, must be unbound before other draws
+    // as divisors are kept in vao
+    void BindInstances(GLuint buffer, uint32_t offset);
+    void UnbindInstances();
+    // light space matrix of current shadow pass, none for point lights rendered to cube map
+    std::optional<glm::mat4> GetShadowLightSpaceMatrix();
     void BindMaterial(const Material::Data & data);
     void BindLight(const Light::Data & data);
     void BindTextures(const Textures::Data & data);
@@ -263,27 +341,31 @@ private:
 
     void InitTextureLocations(const std::string & path, uint32_t count, std::vector<GLuint> & locations);
 
+    // locations of vertex attributes are given by config, they are bound before linking
+    AttributeLocations InitAttributeLocations();
+    // uniform locations of linked program
+    void InitProgram();
     void InitModelLocations();
     void InitMeshLocations();
 
     Config m_config;
     Locations m_locations;
     std::unique_ptr<Shader> m_shader;
+    // used while program is not ready
+    ModelShaderPtr m_fallback;
 
     struct ShadowState
     {
         bool directionalState;
         uint32_t pointCounter;
         uint32_t spotCounter;
+        // revision of casters of current passes
+        std::optional<uint64_t> casters;
 
-        std::unique_ptr<ShadowDirectionalLight> directional;
-        std::vector<std::unique_ptr<ShadowPointLight>> point;
-        std::vector<std::unique_ptr<ShadowSpotLight>> spot;
+        std::shared_ptr<ShadowMaps> maps;
 
     } m_shadows;
     void ResetShadowState();
     void InitShadows();
     void BindShadows();
 };
-
-using ModelShaderPtr = std::shared_ptr<ModelShader>;
@@ -0,0 +1,172 @@
+#include "ModelShaderManager.h"
+#include "ShaderGenerator.h"
+#include <type_traits>
+#include <future>
+#include <algorithm>
+
+template<class T>
+static void Append(std::string & key, const T & value)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be part of key");
+    key.append((const char *)&value, sizeof(T));
+}
+
+static void Append(std::string & key, const std::vector<ModelShader::TextureStackEntry> & stack)
+{
+    Append(key, (uint32_t)stack.size());
+    for (const auto & entry : stack)
+    {
+        Append(key, entry.factor);
+        Append(key, entry.operation);
+        Append(key, entry.uvIndex);
+    }
+}
+
+static bool HasRuntimeMaterial(const ModelShader::Config & config)
+{
+    return config.flags & ((uint32_t)ModelShader::Config::Flags::UseRuntimeMaterial | (uint32_t)ModelShader::Config::Flags::Instanced);
+}
+
+ModelShaderManager & ModelShaderManager::Instance()
+{
+    static ModelShaderManager instance;
+
+    return instance;
+}
+
+std::string ModelShaderManager::GetVariantKey(const ModelShader::Config & config)
+{
+    std::string result;
+
+    Append(result, config.flags);
+    Append(result, config.shading);
+
+    Append(result, config.light.directional);
+    Append(result, config.light.pointCount);
+    Append(result, config.light.spotCount);
+
+    Append(result, config.textures.ambient);
+    Append(result, config.textures.diffuse);
+    Append(result, config.textures.specular);
+    Append(result, config.textures.normal);
+    Append(result, config.textures.lightmap);
+
+    // otherwise material is compiled into program as constants
+    if (!HasRuntimeMaterial(config))
+    {
+        Append(result, config.material.ambient);
+        Append(result, config.material.diffuse);
+        Append(result, config.material.specular);
+        Append(result, config.material.shininess);
+        Append(result, config.material.shininessStrength);
+    }
+
+    return result;
+}
+
+std::optional<ModelShader::Config> ModelShaderManager::GetFallbackConfig(const ModelShader::Config & config)
+{
+    const ModelShader::TextureMaps & textures = config.textures;
+    if (textures.ambient.empty() && textures.diffuse.empty() && textures.specular.empty() && textures.normal.empty() && textures.lightmap.empty())
+        return std::nullopt;
+
+    // material compiled into program would have to be in fallback as well
+    if (!HasRuntimeMaterial(config))
+        return std::nullopt;
+
+    ModelShader::Config result = config;
+    result.textures = {};
+
+    return result;
+}
+
+ModelShaderPtr ModelShaderManager::GetShader(const ModelShader::Config & config)
+{
+    return GetShaders({ config }).front();
+}
+
+std::vector<ModelShaderPtr> ModelShaderManager::GetShaders(const std::vector<ModelShader::Config> & configs)
+{
+    std::vector<ModelShaderPtr> result(configs.size());
+    std::vector<std::string> keys(configs.size());
+
+    // first config of each variant which doesn't exist yet
+    std::map<std::string, size_t> created;
+    for (size_t i = 0; i < configs.size(); ++i)
+    {
+        keys[i] = GetVariantKey(configs[i]);
+
+        auto it = m_shaders.find(keys[i]);
+        if (it != std::end(m_shaders))
+            result[i] = it->second.lock();
+        if (!result[i])
+            created.emplace(keys[i], i);
+    }
+
+    // generator doesn't use OpenGL
+#if defined(EMSCRIPTEN)
+    const std::launch policy = std::launch::deferred;
+#else
+    const std::launch policy = std::launch::async;
+#endif
+    std::vector<std::tuple<size_t, std::future<ShaderGenerator::Result>>> sources;
+    for (const auto & [key, index] : created)
+        sources.emplace_back(index, std::async(policy, ShaderGenerator::Generate, configs[index]));
+
+    for (auto & [index, source] : sources)
+    {
+        // variant may be created meanwhile as fallback of other one
+        if ((result[index] = m_shaders[keys[index]].lock()))
+            continue;
+
+        // fallback is small and shared by many variants, it's linked right away
+        ModelShaderPtr fallback;
+        if (auto fallbackConfig = GetFallbackConfig(configs[index]))
+            fallback = GetShader(*fallbackConfig);
+
+        ModelShaderPtr shader = std::make_shared<ModelShader>(configs[index], source.get(), fallback);
+        if (fallback)
+            m_pending.push_back(shader);
+
+        m_shaders[keys[index]] = shader;
+        result[index] = shader;
+    }
+
+    // other configs of created variants
+    for (size_t i = 0; i < configs.size(); ++i)
+    {
+        if (!result[i])
+            result[i] = m_shaders[keys[i]].lock();
+    }
+
+    return result;
+}
+
+void ModelShaderManager::Update()
+{
+    auto finished = [](const std::weak_ptr<ModelShader> & pending)
+    {
+        ModelShaderPtr shader = pending.lock();
+        return !shader || shader->Update();
+    };
+
+    m_pending.erase(std::remove_if(std::begin(m_pending), std::end(m_pending), finished), std::end(m_pending));
+}
+
+std::shared_ptr<ModelShader::ShadowMaps> ModelShaderManager::GetShadowMaps(const Light::Config & light)
+{
+    std::weak_ptr<ModelShader::ShadowMaps> & entry = m_shadowMaps[{ light.directional, light.pointCount, light.spotCount }];
+    if (auto maps = entry.lock())
+        return maps;
+
+    auto maps = std::make_shared<ModelShader::ShadowMaps>();
+    if (light.directional)
+        maps->directional = std::make_unique<ShadowDirectionalLight>();
+    for (uint32_t i = 0; i < light.pointCount; ++i)
+        maps->point.emplace_back(std::make_unique<ShadowPointLight>());
+    for (uint32_t i = 0; i < light.spotCount; ++i)
+        maps->spot.emplace_back(std::make_unique<ShadowSpotLight>());
+    entry = maps;
+
+    return maps;
+}
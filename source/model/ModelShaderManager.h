@@ -0,0 +1,38 @@
+#pragma once
+#include "ModelShader.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <optional>
+
+// Shaders with equal variant of config share one program, shaders with equal light config share shadow maps.
+// Only weak references are kept, resources are released with their last user.
+class ModelShaderManager
+{
+public:
+    static ModelShaderManager & Instance();
+
+    // values of runtime material are not part of the variant, they are bound by BindMaterial
+    ModelShaderPtr GetShader(const ModelShader::Config & config);
+    // sources of new variants are generated on worker threads, then all programs are submitted
+    // before any of them is waited for, textured variants are linked in background meanwhile
+    // their fallback without textures is drawn
+    std::vector<ModelShaderPtr> GetShaders(const std::vector<ModelShader::Config> & configs);
+    std::shared_ptr<ModelShader::ShadowMaps> GetShadowMaps(const Light::Config & light);
+
+    // switches shaders linked in background once they are ready, must be called between frames
+    void Update();
+
+private:
+    // canonical bytes of everything the generated program depends on
+    static std::string GetVariantKey(const ModelShader::Config & config);
+    // none when config has no textures or fallback couldn't be drawn with the same data
+    static std::optional<ModelShader::Config> GetFallbackConfig(const ModelShader::Config & config);
+
+    std::map<std::string, std::weak_ptr<ModelShader>> m_shaders;
+    std::map<std::tuple<bool, uint32_t, uint32_t>, std::weak_ptr<ModelShader::ShadowMaps>> m_shadowMaps;
+    // shaders linked in background
+    std::vector<std::weak_ptr<ModelShader>> m_pending;
+};
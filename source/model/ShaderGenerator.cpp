@@ -8,34 +8,76 @@ void AppendHeader(std::string & result)
     result += "#endif\n\n";
 }
 
+bool IsInstanced(const ModelShader::Config & config)
+{
+    return config.flags & (uint32_t)ModelShader::Config::Flags::Instanced;
+}
+
+// material is given by uniforms or per instance attributes
+bool HasRuntimeMaterial(const ModelShader::Config & config)
+{
+    return (config.flags & (uint32_t)ModelShader::Config::Flags::UseRuntimeMaterial) || IsInstanced(config);
+}
+
 void AppendAttributes(const ModelShader::Config & config, std::string & result)
 {
+    bool octahedral = config.flags & (uint32_t)ModelShader::Config::Flags::OctahedralNormals;
+
     result += "// *** attributes ***\n";
     result += "attribute vec3 positionModelSpace;\n";
-    result += "attribute vec3 normalModelSpace;\n";
+    result += octahedral ? "attribute vec2 normalModelSpace;\n" : "attribute vec3 normalModelSpace;\n";
     for (uint32_t i = 0; i < config.GetUVChannelsCount(); ++i)
         result += "attribute vec2 vertexUV" + std::to_string(i) + ";\n";
     if (config.textures.normal.size())
     {
+        // with octahedral normals third component is sign of bitangent
         result += "attribute vec3 tangentModelSpace;\n";
         //result += "attribute vec3 bitangentModelSpace;\n";
     }
+    if (IsInstanced(config))
+    {
+        result += "attribute mat4 instanceModel;\n";
+        result += "attribute vec3 instanceAmbient;\n";
+        result += "attribute vec3 instanceDiffuse;\n";
+        result += "attribute vec3 instanceSpecular;\n";
+        // shininess and its strength
+        result += "attribute vec2 instanceShininess;\n";
+    }
     result += "// ******************\n";
 }
 
 void AppendUniforms(const ModelShader::Config & config, std::string & result)
 {
     result += "// *** general uniforms ***\n";
-    result += "uniform mat4 MVP;\n";
-    result += "uniform mat4 M;\n";
+    if (IsInstanced(config))
+    {
+        // model matrix is per instance
+        result += "uniform mat4 VP;\n";
+    }
+    else
+    {
+        result += "uniform mat4 MVP;\n";
+        result += "uniform mat4 M;\n";
+    }
     result += "uniform vec3 cameraWorldSpace;\n";
     result += "// ************************\n";
 }
 
+void AppendUniformsVertex(const ModelShader::Config & config, std::string & result)
+{
+    if (!(config.flags & (uint32_t)ModelShader::Config::Flags::QuantizedPositions))
+        return;
+
+    result += "// *** vertex decoding uniforms ***\n";
+    result += "uniform vec3 positionOffset;\n";
+    result += "uniform vec3 positionScale;\n";
+    result += "// ********************************\n";
+}
+
 void AppendUniformsMaterial(const ModelShader::Config & config, std::string & result)
 {
     result += "// *** material uniforms ***\n";
-    if (config.flags & (uint32_t)ModelShader::Config::Flags::UseRuntimeMaterial)
+    if (HasRuntimeMaterial(config))
     {
         result += "struct Material\n";
         result += "{\n";
@@ -45,7 +87,8 @@ void AppendUniformsMaterial(const ModelShader::Config & config, std::string & re
         result += "    float shininess;\n";
         result += "    float shininessStrength;\n";
         result += "};\n";
-        result += "uniform Material material;\n";
+        // instanced material is filled from varyings at the beginning of main
+        result += IsInstanced(config) ? "Material material;\n" : "uniform Material material;\n";
     }
     if (config.textures.ambient.size())
         result += "uniform sampler2D textureAmbient[" + std::to_string(config.textures.ambient.size()) + "];\n";
@@ -135,11 +178,18 @@ void AppendVaryings(const ModelShader::Config & config, std::string & result)
         result += "varying vec3 normalWorldSpace;\n";
     if (config.GetUVChannelsCount())
         result += "varying vec2 vertexUVA[" + std::to_string(config.GetUVChannelsCount()) + "];\n";
+    if (IsInstanced(config))
+    {
+        result += "varying vec3 materialAmbient;\n";
+        result += "varying vec3 materialDiffuse;\n";
+        result += "varying vec3 materialSpecular;\n";
+        result += "varying vec2 materialShininess;\n";
+    }
 
     result += "// ****************\n";
 }
 
-void AppendFunctionSupport(std::string & result)
+void AppendFunctionSupport(const ModelShader::Config & config, std::string & result)
 {
     result += "// *** support functions ***\n";
     result += "mat3 transposeCustom(mat3 m)\n";
@@ -164,6 +214,18 @@ void AppendFunctionSupport(std::string & result)
     result += "              b11, ( a22 * a00 - a02 * a20), (-a12 * a00 + a02 * a10),\n";
     result += "              b21, (-a21 * a00 + a01 * a20), ( a11 * a00 - a01 * a10)) / det;\n";
     result += "}\n";
+    if (config.flags & (uint32_t)ModelShader::Config::Flags::OctahedralNormals)
+    {
+        result += "\n";
+        result += "vec3 DecodeOctahedral(vec2 e)\n";
+        result += "{\n";
+        result += "  vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));\n";
+        result += "  // lower half is folded over the diagonals\n";
+        result += "  if (v.z < 0.0)\n";
+        result += "    v.xy = (1.0 - abs(e.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);\n";
+        result += "  return normalize(v);\n";
+        result += "}\n";
+    }
     result += "// *************************\n";
 }
 
@@ -171,24 +233,50 @@ void AppendBodyVertex(const ModelShader::Config & config, std::string & result)
 {
     result += "// *** vertex body ***\n";
     result += "void main(void)\n";
+    bool octahedral = config.flags & (uint32_t)ModelShader::Config::Flags::OctahedralNormals;
+
     result += "{\n";
-    result += "  gl_Position =  MVP * vec4(positionModelSpace, 1.0);\n";
-    result += "  positionWorldSpace = vec3(M * vec4(positionModelSpace, 1.0));\n\n";
+    if (config.flags & (uint32_t)ModelShader::Config::Flags::QuantizedPositions)
+        result += "  vec3 position = positionOffset + positionModelSpace * positionScale;\n";
+    else
+        result += "  vec3 position = positionModelSpace;\n";
+    result += octahedral ? "  vec3 normal = DecodeOctahedral(normalModelSpace);\n\n" : "  vec3 normal = normalModelSpace;\n\n";
+    if (IsInstanced(config))
+    {
+        result += "  mat4 M = instanceModel;\n";
+        result += "  gl_Position =  VP * M * vec4(position, 1.0);\n";
+    }
+    else
+    {
+        result += "  gl_Position =  MVP * vec4(position, 1.0);\n";
+    }
+    result += "  positionWorldSpace = vec3(M * vec4(position, 1.0));\n\n";
     result += "  mat3 normalMatrix = transposeCustom(inverseCustom(mat3(M)));\n";
     if (config.textures.normal.size())
     {
-        result += "  vec3 T = normalize(normalMatrix * tangentModelSpace);\n";
-        result += "  vec3 N = normalize(normalMatrix * normalModelSpace);\n";
+        result += octahedral ? "  vec3 tangent = DecodeOctahedral(tangentModelSpace.xy);\n" : "  vec3 tangent = tangentModelSpace;\n";
+        result += "  vec3 T = normalize(normalMatrix * tangent);\n";
+        result += "  vec3 N = normalize(normalMatrix * normal);\n";
         result += "  T = normalize(T - dot(T, N) * N);\n";
-        result += "  vec3 B = normalize(cross(N, T));\n";
+        if (octahedral)
+            result += "  vec3 B = normalize(cross(N, T)) * (tangentModelSpace.z < 0.0 ? -1.0 : 1.0);\n";
+        else
+            result += "  vec3 B = normalize(cross(N, T));\n";
         result += "  TBN = mat3(T, B, N);\n\n";
     }
     else
     {
-        result += "  normalWorldSpace = normalMatrix * normalModelSpace;\n\n";
+        result += "  normalWorldSpace = normalMatrix * normal;\n\n";
     }
     for (uint32_t i = 0; i < config.GetUVChannelsCount(); ++i)
         result += "  vertexUVA[" + std::to_string(i) + "] = vertexUV" + std::to_string(i) + ";\n";
+    if (IsInstanced(config))
+    {
+        result += "  materialAmbient = instanceAmbient;\n";
+        result += "  materialDiffuse = instanceDiffuse;\n";
+        result += "  materialSpecular = instanceSpecular;\n";
+        result += "  materialShininess = instanceShininess;\n";
+    }
 
     result += "}\n";
     result += "// ******************\n";
@@ -264,7 +352,7 @@ void AppendFunctionLightSpot(std::string & result, const std::string & shininess
 void AppendFunctionLight(const ModelShader::Config & config, std::string & result)
 {
     std::string shininess = std::to_string(config.material.shininess);
-    if (config.flags & (uint32_t)ModelShader::Config::Flags::UseRuntimeMaterial)
+    if (HasRuntimeMaterial(config))
         shininess = "material.shininess";
 
     result += "// *** light functions ***\n";
@@ -512,7 +600,7 @@ static std::string Convert(const glm::vec3 & c)
 
 void AppendFunctionColor(const ModelShader::Config & config, std::string & result)
 {
-    bool useMaterial = config.flags & (uint32_t)ModelShader::Config::Flags::UseRuntimeMaterial;
+    bool useMaterial = HasRuntimeMaterial(config);
 
     result += "// *** color functions ***\n";
     AppendFunctionColorTextureStack("Ambient", useMaterial ? "material.ambient" : Convert(config.material.ambient), config.textures.ambient, result);
@@ -532,11 +620,13 @@ void AppendBodyFragment(const ModelShader::Config & config, std::string & result
     result += "// *** fragment body ***\n";
     result += "void main(void)\n";
     result += "{\n";
+    if (IsInstanced(config))
+        result += "    material = Material(materialAmbient, materialDiffuse, materialSpecular, materialShininess.x, materialShininess.y);\n\n";
     result += "    vec3 ambientColor = CalcAmbientColor();\n";
     result += "    vec3 diffuseColor = CalcDiffuseColor();\n";
     result += "    vec3 specularColor = CalcSpecularColor();\n\n";
 
-    if (config.flags & (uint32_t)ModelShader::Config::Flags::UseRuntimeMaterial)
+    if (HasRuntimeMaterial(config))
         result += "    specularColor *= material.shininessStrength;\n\n";
     else
         result += "    specularColor *= " + std::to_string(config.material.shininessStrength) + ";\n\n";
@@ -604,8 +694,9 @@ std::string GenerateVertex(const ModelShader::Config & config)
     AppendHeader(result);
     AppendAttributes(config, result);
     AppendUniforms(config, result);
+    AppendUniformsVertex(config, result);
     AppendVaryings(config, result);
-    AppendFunctionSupport(result);
+    AppendFunctionSupport(config, result);
     AppendBodyVertex(config, result);
 
     return result;
@@ -5,6 +5,21 @@
 static const GLsizei SHADOW_WIDTH = 1024;
 static const GLsizei SHADOW_HEIGHT = 1024;
 
+bool ShadowCache::IsCached(const std::optional<uint64_t> & casters) const
+{
+    return casters && m_casters == casters;
+}
+
+void ShadowCache::SetCached(const std::optional<uint64_t> & casters)
+{
+    m_casters = casters;
+}
+
+void ShadowCache::Invalidate()
+{
+    m_casters.reset();
+}
+
 static const char * DIRECTIONAL_FRAGMENT_SHADER = \
 "#version 100\n"
 "void main()\n"
@@ -45,7 +60,8 @@ ShadowDirectionalLight::ShadowDirectionalLight()
       m_planes(1.0f, 50.0f),
       m_lightProjection(glm::ortho(-15.0f, 15.0f, -15.0f, 15.0f, m_planes.x, m_planes.y))
 {
-
+    m_locationModel = m_shaderDepth.GetLocation("model", Shader::LocationType::Uniform);
+    m_locationLightSpaceMatrix = m_shaderDepth.GetLocation("lightSpaceMatrix", Shader::LocationType::Uniform);
 }
 
 void ShadowDirectionalLight::SetLightData(const glm::vec3 & direction)
@@ -54,7 +70,13 @@ void ShadowDirectionalLight::SetLightData(const glm::vec3 & direction)
     glm::vec3 position = -direction;
 
     glm::mat4 view = glm::lookAt(position, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
-    m_lightSpaceMatrix = m_lightProjection * view;
+    glm::mat4 lightSpaceMatrix = m_lightProjection * view;
+
+    if (lightSpaceMatrix != m_lightSpaceMatrix)
+    {
+        m_lightSpaceMatrix = lightSpaceMatrix;
+        Invalidate();
+    }
 }
 
 void ShadowDirectionalLight::BeginRender()
@@ -66,7 +88,7 @@ void ShadowDirectionalLight::BeginRender()
     glClear(GL_DEPTH_BUFFER_BIT);
 
     m_shaderDepth.BeginRender();
-    m_shaderDepth.SetUniform(m_lightSpaceMatrix, "lightSpaceMatrix");
+    m_shaderDepth.SetUniform(m_lightSpaceMatrix, m_locationLightSpaceMatrix);
 
     //glCullFace(GL_FRONT);
 }
@@ -88,6 +110,11 @@ Shader & ShadowDirectionalLight::GetShader()
     return m_shaderDepth;
 }
 
+void ShadowDirectionalLight::BindModel(const glm::mat4 & model)
+{
+    m_shaderDepth.SetUniform(model, m_locationModel);
+}
+
 GLuint ShadowDirectionalLight::GetTexture()
 {
     return m_framebufferDepth.GetTextureAttachment();
@@ -135,7 +162,8 @@ ShadowSpotLight::ShadowSpotLight()
     m_debug(nullptr, SPOT_DEBUG_FRAGMENT_SHADER),
     m_planes(0.1f, 25.0f)
 {
-
+    m_locationModel = m_shaderDepth.GetLocation("model", Shader::LocationType::Uniform);
+    m_locationLightSpaceMatrix = m_shaderDepth.GetLocation("lightSpaceMatrix", Shader::LocationType::Uniform);
 }
 
 void ShadowSpotLight::SetLightData(const glm::vec3 & position, const glm::vec3 & direction, float cutoff, float outerCutoff)
@@ -143,7 +171,13 @@ void ShadowSpotLight::SetLightData(const glm::vec3 & position, const glm::vec3 &
     m_projection = glm::perspective(2.0f*glm::acos(outerCutoff), (float)SHADOW_WIDTH / (float)SHADOW_HEIGHT, m_planes.x, m_planes.y);
     m_view = glm::lookAt(position, position + direction, glm::vec3(0.0, 1.0, 0.0));
     
-    m_lightSpaceMatrix = m_projection * m_view;
+    glm::mat4 lightSpaceMatrix = m_projection * m_view;
+
+    if (lightSpaceMatrix != m_lightSpaceMatrix)
+    {
+        m_lightSpaceMatrix = lightSpaceMatrix;
+        Invalidate();
+    }
 }
 
 // looks like all of those functions are same
@@ -157,7 +191,7 @@ void ShadowSpotLight::BeginRender()
     glClear(GL_DEPTH_BUFFER_BIT);
 
     m_shaderDepth.BeginRender();
-    m_shaderDepth.SetUniform(m_lightSpaceMatrix, "lightSpaceMatrix");
+    m_shaderDepth.SetUniform(m_lightSpaceMatrix, m_locationLightSpaceMatrix);
 
     //glCullFace(GL_FRONT);
 }
@@ -179,6 +213,11 @@ Shader & ShadowSpotLight::GetShader()
     return m_shaderDepth;
 }
 
+void ShadowSpotLight::BindModel(const glm::mat4 & model)
+{
+    m_shaderDepth.SetUniform(model, m_locationModel);
+}
+
 GLuint ShadowSpotLight::GetTexture()
 {
     return m_framebufferDepth.GetTextureAttachment();
@@ -257,10 +296,20 @@ ShadowPointLight::ShadowPointLight()
       m_planes(0.1f, 25.0f),
       m_shadowProjection(glm::perspective(glm::radians(90.0f), (float)SHADOW_WIDTH / (float)SHADOW_HEIGHT, m_planes.x, m_planes.y))
 {
+    m_locationModel = m_shaderDepth.GetLocation("model", Shader::LocationType::Uniform);
+    for (size_t i = 0; i < 6; ++i)
+        m_locationShadowMatrices.push_back(m_shaderDepth.GetLocation("shadowMatrices[" + std::to_string(i) + "]", Shader::LocationType::Uniform));
+    m_locationFarPlane = m_shaderDepth.GetLocation("farPlane", Shader::LocationType::Uniform);
+    m_locationLightPosition = m_shaderDepth.GetLocation("lightPositionWorldSpace", Shader::LocationType::Uniform);
 }
 
 void ShadowPointLight::SetLightData(const glm::vec3 & lightPosition)
 {
+    if (!m_lightSpaceMatrix.empty() && lightPosition == m_lightPosition)
+        return;
+
+    Invalidate();
+
     m_lightSpaceMatrix.clear();
 
     m_lightSpaceMatrix.push_back(m_shadowProjection * glm::lookAt(lightPosition, lightPosition + glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)));
@@ -281,15 +330,11 @@ void ShadowPointLight::BeginRender()
     glClear(GL_DEPTH_BUFFER_BIT);
 
     m_shaderDepth.BeginRender();
-    m_shaderDepth.SetUniform(m_lightSpaceMatrix[0], "shadowMatrices[0]");
-    m_shaderDepth.SetUniform(m_lightSpaceMatrix[1], "shadowMatrices[1]");
-    m_shaderDepth.SetUniform(m_lightSpaceMatrix[2], "shadowMatrices[2]");
-    m_shaderDepth.SetUniform(m_lightSpaceMatrix[3], "shadowMatrices[3]");
-    m_shaderDepth.SetUniform(m_lightSpaceMatrix[4], "shadowMatrices[4]");
-    m_shaderDepth.SetUniform(m_lightSpaceMatrix[5], "shadowMatrices[5]");
+    for (size_t i = 0; i < m_locationShadowMatrices.size(); ++i)
+        m_shaderDepth.SetUniform(m_lightSpaceMatrix[i], m_locationShadowMatrices[i]);
 
-    m_shaderDepth.SetUniform(m_planes.y, "farPlane");
-    m_shaderDepth.SetUniform(m_lightPosition, "lightPositionWorldSpace");
+    m_shaderDepth.SetUniform(m_planes.y, m_locationFarPlane);
+    m_shaderDepth.SetUniform(m_lightPosition, m_locationLightPosition);
 }
 
 void ShadowPointLight::EndRender()
@@ -307,6 +352,11 @@ Shader & ShadowPointLight::GetShader()
     return m_shaderDepth;
 }
 
+void ShadowPointLight::BindModel(const glm::mat4 & model)
+{
+    m_shaderDepth.SetUniform(model, m_locationModel);
+}
+
 GLuint ShadowPointLight::GetTexture()
 {
     return m_framebufferDepth.GetTextureAttachment();
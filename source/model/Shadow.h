@@ -3,8 +3,26 @@
 #include "utils/Framebuffer.h"
 #include "utils/Texture.h"
 #include <vector>
+#include <optional>
+#include <cstdint>
 
-class ShadowDirectionalLight
+// Content of shadow map is kept while light data and revision of casters stay the same,
+// light data invalidate it in SetLightData when they change.
+class ShadowCache
+{
+public:
+    // none never matches, map rendered without revision is always rendered again
+    bool IsCached(const std::optional<uint64_t> & casters) const;
+    void SetCached(const std::optional<uint64_t> & casters);
+
+protected:
+    void Invalidate();
+
+private:
+    std::optional<uint64_t> m_casters;
+};
+
+class ShadowDirectionalLight : public ShadowCache
 {
 public:
     ShadowDirectionalLight();
@@ -15,6 +33,8 @@ public:
     void EndRender();
 
     Shader & GetShader();
+    // between BeginRender and EndRender
+    void BindModel(const glm::mat4 & model);
 
     GLuint GetTexture();
     glm::vec2 GetTextureSize();
@@ -27,6 +47,8 @@ public:
 private:
     FramebufferDepth m_framebufferDepth;
     Shader m_shaderDepth;
+    GLuint m_locationModel;
+    GLuint m_locationLightSpaceMatrix;
 
     glm::mat4 m_lightSpaceMatrix;
 
@@ -36,7 +58,7 @@ private:
     const glm::mat4 m_lightProjection;
 };
 
-class ShadowSpotLight
+class ShadowSpotLight : public ShadowCache
 {
 public:
     ShadowSpotLight();
@@ -47,6 +69,8 @@ public:
     void EndRender();
 
     Shader & GetShader();
+    // between BeginRender and EndRender
+    void BindModel(const glm::mat4 & model);
 
     GLuint GetTexture();
     glm::vec2 GetTextureSize();
@@ -59,6 +83,8 @@ public:
 private:
     FramebufferDepth m_framebufferDepth;
     Shader m_shaderDepth;
+    GLuint m_locationModel;
+    GLuint m_locationLightSpaceMatrix;
 
     glm::mat4 m_lightSpaceMatrix;
 
@@ -70,7 +96,7 @@ private:
 };
 
 #if !defined(EMSCRIPTEN) && !defined(ANDROID)
-class ShadowPointLight
+class ShadowPointLight : public ShadowCache
 {
 public:
     ShadowPointLight();
@@ -81,6 +107,8 @@ public:
     void EndRender();
 
     Shader & GetShader();
+    // between BeginRender and EndRender
+    void BindModel(const glm::mat4 & model);
 
     GLuint GetTexture();
     glm::vec2 GetTextureSize();
@@ -91,6 +119,10 @@ public:
 private:
     FramebufferDepthCube m_framebufferDepth;
     Shader m_shaderDepth;
+    GLuint m_locationModel;
+    std::vector<GLuint> m_locationShadowMatrices;
+    GLuint m_locationFarPlane;
+    GLuint m_locationLightPosition;
 
     std::vector<glm::mat4> m_lightSpaceMatrix;
     glm::vec3 m_lightPosition;
@@ -100,7 +132,7 @@ private:
 };
 #else
 // TODO implementation with 6 render passes
-class ShadowPointLight
+class ShadowPointLight : public ShadowCache
 {
 public:
     ShadowPointLight() : m_shader("", "") {}
@@ -108,6 +140,7 @@ public:
     void BeginRender() {}
     void EndRender() {}
     Shader & GetShader() { return m_shader; }
+    void BindModel(const glm::mat4 & model) {}
     GLuint GetTexture() { return 0; }
     glm::vec2 GetTextureSize() { return {}; }
     glm::vec2 GetPlanes() { return {}; }
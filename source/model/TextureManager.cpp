@@ -1,5 +1,6 @@
 #include "TextureManager.h"
 #include "utils/Texture.h"
+#include "utils/GLState.h"
 
 TextureManager & TextureManager::Instance()
 {
@@ -11,7 +12,7 @@ TextureManager & TextureManager::Instance()
 TextureManager::~TextureManager()
 {
     for (auto[_, texture] : m_textures)
-        glDeleteTextures(1, &texture);
+        GLState::Instance().DeleteTexture(texture);
 }
 
 std::optional<GLuint> TextureManager::GetTexture(const char * path)
@@ -1,4 +1,16 @@
 #include "Bullet.h"
+#include <algorithm>
+#if BT_THREADSAFE
+#include "TaskScheduler.h"
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#endif
+
+static const float FIXED_TIME_STEP = 1.0f / 60.0f;
+// time over this budget is dropped, simulation slows down instead of stalling frames
+static const uint32_t MAX_SUB_STEPS = 5;
+// bit for each of three buffers of published states
+static const uint32_t ALL_BUFFERS = 0x7;
 
 static glm::vec3 Convert(const btVector3 & v)
 {
@@ -16,16 +28,31 @@ Bullet::Bullet(const glm::vec3 & gravity)
     // Collision configuration contains default setup for memory, collision setup. Advanced users can create their own configuration.
     m_collisionConfiguration.reset(new btDefaultCollisionConfiguration());
 
-    // Use the default collision dispatcher. For parallel processing you can use a diffent dispatcher (see Extras/BulletMultiThreaded)
-    m_dispatcher.reset(new btCollisionDispatcher(m_collisionConfiguration.get()));
-
     // btDbvtBroadphase is a good general purpose broadphase. You can also try out btAxis3Sweep.
     m_broadphase.reset(new btDbvtBroadphase());
 
-    // The default constraint solver. For parallel processing you can use a different solver (see Extras/BulletMultiThreaded)
+#if BT_THREADSAFE
+    // parallel loops of world run on work-stealing pool, threads count is set by SetThreadsCount
+    if (btGetTaskScheduler() != &TaskScheduler::Instance())
+        btSetTaskScheduler(&TaskScheduler::Instance());
+
+    // narrowphase of overlapping pairs in parallel, 40 pairs per task as in Bullet examples
+    m_dispatcher.reset(new btCollisionDispatcherMt(m_collisionConfiguration.get(), 40));
+
+    // islands are solved in parallel by pooled solvers, large islands by parallel solver
+    m_solverPool.reset(new btConstraintSolverPoolMt(TaskScheduler::Instance().getMaxNumThreads()));
+    m_solver.reset(new btSequentialImpulseConstraintSolverMt());
+
+    m_world.reset(new btDiscreteDynamicsWorldMt(m_dispatcher.get(), m_broadphase.get(), m_solverPool.get(), m_solver.get(), m_collisionConfiguration.get()));
+#else
+    // Use the default collision dispatcher.
+    m_dispatcher.reset(new btCollisionDispatcher(m_collisionConfiguration.get()));
+
+    // The default constraint solver.
     m_solver.reset(new btSequentialImpulseConstraintSolver());
 
     m_world.reset(new btDiscreteDynamicsWorld(m_dispatcher.get(), m_broadphase.get(), m_solver.get(), m_collisionConfiguration.get()));
+#endif
 
     m_world->setGravity(Convert(gravity));
     m_world->setDebugDrawer(&m_debug);
@@ -33,6 +60,8 @@ Bullet::Bullet(const glm::vec3 & gravity)
 
 Bullet::~Bullet()
 {
+    StopThread();
+
     // Remove the rigid bodies from the dynamics world and delete them
     for (int32_t i = m_world->getNumCollisionObjects() - 1; i >= 0; i--)
     {
@@ -78,31 +107,31 @@ btConeShape * Bullet::CreateShape(const Shapes::Defintion::Cone & definition)
     return new btConeShape(definition.radius, definition.height);
 }
 
-btRigidBody * Bullet::AddBox(const Shapes::Defintion::Box & definition, bool isStatic)
+btRigidBody * Bullet::AddBox(const Shapes::Defintion::Box & definition, bool isStatic, uint32_t id)
 {
-    return AddCommon(definition.position, definition.rotation, isStatic, CreateShape(definition));
+    return AddCommon(definition.position, definition.rotation, isStatic, id, CreateShape(definition));
 }
 
-btRigidBody * Bullet::AddSphere(const Shapes::Defintion::Sphere & definition, bool isStatic)
+btRigidBody * Bullet::AddSphere(const Shapes::Defintion::Sphere & definition, bool isStatic, uint32_t id)
 {
-    return AddCommon(definition.position, definition.rotation, isStatic, CreateShape(definition));
+    return AddCommon(definition.position, definition.rotation, isStatic, id, CreateShape(definition));
 }
 
-btRigidBody * Bullet::AddCylinder(const Shapes::Defintion::Cylinder & definition, bool isStatic)
+btRigidBody * Bullet::AddCylinder(const Shapes::Defintion::Cylinder & definition, bool isStatic, uint32_t id)
 {
-    return AddCommon(definition.position, definition.rotation, isStatic, CreateShape(definition));
+    return AddCommon(definition.position, definition.rotation, isStatic, id, CreateShape(definition));
 }
 
-btRigidBody * Bullet::AddCone(const Shapes::Defintion::Cone & definition, bool isStatic)
+btRigidBody * Bullet::AddCone(const Shapes::Defintion::Cone & definition, bool isStatic, uint32_t id)
 {
-    return AddCommon(definition.position, definition.rotation, isStatic, CreateShape(definition));
+    return AddCommon(definition.position, definition.rotation, isStatic, id, CreateShape(definition));
 }
 
-btRigidBody * Bullet::AddCompound(const glm::vec3 & position, const glm::vec3 & rotation, bool isStatic)
+btRigidBody * Bullet::AddCompound(const glm::vec3 & position, const glm::vec3 & rotation, bool isStatic, uint32_t id)
 {
     btCompoundShape * shape = new btCompoundShape();
 
-    return AddCommon(position, rotation, isStatic, shape);
+    return AddCommon(position, rotation, isStatic, id, shape);
 }
 
 template<class T>
@@ -119,16 +148,19 @@ btCollisionShape * Bullet::AddShape(btRigidBody * body, const T & definition)
     //btCompoundShape * parent = dynamic_cast<btCompoundShape*>(body->getCollisionShape());
     btCompoundShape* parent = static_cast<btCompoundShape*>(body->getCollisionShape());
 
-    parent->addChildShape(transform, result);
-
-    if (!body->isStaticObject())
+    Execute([body, parent, transform, result]()
     {
-        btVector3 inertia;
-        btScalar mass = body->getInvMass();
+        parent->addChildShape(transform, result);
 
-        parent->calculateLocalInertia(mass, inertia);
-        body->setMassProps(mass, inertia);
-    }
+        if (!body->isStaticObject())
+        {
+            btVector3 inertia;
+            btScalar mass = body->getInvMass();
+
+            parent->calculateLocalInertia(mass, inertia);
+            body->setMassProps(mass, inertia);
+        }
+    });
 
     return result;
 }
@@ -145,10 +177,10 @@ void Bullet::RemoveShape(btRigidBody * body, btCollisionShape * shape)
     //btCompoundShape * parent = dynamic_cast<btCompoundShape*>(body->getCollisionShape());
     btCompoundShape* parent = static_cast<btCompoundShape*>(body->getCollisionShape());
 
-    parent->removeChildShape(shape);
+    Execute([parent, shape]() { parent->removeChildShape(shape); });
 }
 
-btRigidBody * Bullet::AddCommon(const glm::vec3 & position, const glm::vec3 & rotation, bool isStatic, btCollisionShape * shape)
+btRigidBody * Bullet::AddCommon(const glm::vec3 & position, const glm::vec3 & rotation, bool isStatic, uint32_t id, btCollisionShape * shape)
 {
     m_collisionShapes.push_back(shape);
 
@@ -169,34 +201,385 @@ btRigidBody * Bullet::AddCommon(const glm::vec3 & position, const glm::vec3 & ro
     if (isDynamic)
         shape->calculateLocalInertia(mass, localInertia);
 
-    //using motionstate is optional, it provides interpolation capabilities, and only synchronizes 'active' objects
-    btDefaultMotionState * myMotionState = new btDefaultMotionState(groundTransform);
+    // motion state is synchronized only for active objects, it keeps states for interpolation
+    MotionState * myMotionState = new MotionState(groundTransform, *this, id);
     btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, myMotionState, shape, localInertia);
     btRigidBody* body = new btRigidBody(rbInfo);
 
     //add the body to the dynamics world
-    m_world->addRigidBody(body);
+    Execute([this, body]() { m_world->addRigidBody(body); });
 
     return body;
 }
 
 void Bullet::RemoveBody(btRigidBody * body)
 {
-    m_world->removeRigidBody(body);
-    delete body->getMotionState();
-    delete body;
+    Execute([this, body]()
+    {
+        m_world->removeRigidBody(body);
+
+        MotionState * state = static_cast<MotionState*>(body->getMotionState());
+        if (state->IsChanged())
+            m_changed.erase(std::find(m_changed.begin(), m_changed.end(), state));
+
+        delete state;
+        delete body;
+    });
 }
 
-void Bullet::Step()
+void Bullet::Step(float elapsed)
 {
-    m_debug.Clear();
-    m_world->stepSimulation(1.0f / 60.f, 10);
+    if (IsThreadRunning())
+    {
+        bool fresh = m_shared.load() & SNAPSHOT_FRESH;
+        if (fresh)
+            m_read = m_shared.exchange(m_read) & ~SNAPSHOT_FRESH;
+
+        static const std::vector<uint32_t> NONE;
+        UpdateMoved(fresh, fresh ? m_snapshots[m_read].moving : NONE);
+
+        // states of the latest step are reached when the next one is due
+        float age = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_snapshots[m_read].time).count();
+        m_alpha = std::min(age / FIXED_TIME_STEP, 1.0f);
+        return;
+    }
+
+    m_accumulator += std::min(elapsed, MAX_SUB_STEPS * FIXED_TIME_STEP);
+    uint64_t step = m_step;
+
+    while (m_accumulator >= FIXED_TIME_STEP)
+    {
+        // no substeps of Bullet, motion states get exact state of each step
+        m_step++;
+        m_world->stepSimulation(FIXED_TIME_STEP, 0);
+        m_accumulator -= FIXED_TIME_STEP;
+    }
+
+    m_alpha = m_accumulator / FIXED_TIME_STEP;
+
+    UpdateMoved(m_step != step, m_moving);
+    m_moving.clear();
+}
+
+void Bullet::UpdateMoved(bool stepped, const std::vector<uint32_t> & moving)
+{
+    // bodies interpolated so far are refreshed once more to reach state of their last step
+    m_moved = m_interpolated;
+
+    if (stepped)
+    {
+        m_interpolated = moving;
+        std::sort(m_interpolated.begin(), m_interpolated.end());
+        m_interpolated.erase(std::unique(m_interpolated.begin(), m_interpolated.end()), m_interpolated.end());
+    }
+
+    m_moved.insert(m_moved.end(), moving.begin(), moving.end());
+    std::sort(m_moved.begin(), m_moved.end());
+    m_moved.erase(std::unique(m_moved.begin(), m_moved.end()), m_moved.end());
+}
+
+const std::vector<uint32_t> & Bullet::GetMovedBodies() const
+{
+    return m_moved;
+}
+
+bool Bullet::StartThread()
+{
+#if BT_THREADSAFE
+    return false;
+#else
+    if (IsThreadRunning())
+        return true;
+
+    // all buffers start with current states, bodies moved since the last Step are listed in the
+    // first one which is left to be taken by reader
+    m_publishing = true;
+    for (int32_t i = 0; i < m_world->getNumCollisionObjects(); ++i)
+    {
+        btRigidBody * body = btRigidBody::upcast(m_world->getCollisionObjectArray()[i]);
+        if (body && body->getMotionState())
+            static_cast<MotionState*>(body->getMotionState())->MarkChanged();
+    }
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        m_snapshots[i].moving.clear();
+        Publish(i);
+    }
+
+    m_shared = 0 | SNAPSHOT_FRESH;
+    m_read = 1;
+    m_write = 2;
+
+    m_stop = false;
+    m_thread = std::thread(&Bullet::Run, this);
+
+    return true;
+#endif
+}
+
+void Bullet::StopThread()
+{
+    if (!IsThreadRunning())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_worldMutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+    m_publishing = false;
+
+    // bodies of steps not taken by reader yet are left for next Step
+    uint32_t shared = m_shared.load();
+    if (shared & SNAPSHOT_FRESH)
+        m_moving.insert(m_moving.end(), m_snapshots[shared & ~SNAPSHOT_FRESH].moving.begin(), m_snapshots[shared & ~SNAPSHOT_FRESH].moving.end());
+    m_moving.insert(m_moving.end(), m_snapshots[m_write].moving.begin(), m_snapshots[m_write].moving.end());
+
+    // commands queued after the last step
+    RunCommands();
+    m_accumulator = 0.0f;
+}
+
+bool Bullet::IsThreadRunning() const
+{
+    return m_thread.joinable();
+}
+
+void Bullet::Run()
+{
+    using Clock = std::chrono::steady_clock;
+    const Clock::duration step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(FIXED_TIME_STEP));
+
+    Clock::time_point next = Clock::now();
+
+    std::unique_lock<std::mutex> lock(m_worldMutex);
+    while (!m_stop)
+    {
+        RunCommands();
+
+        m_step++;
+        m_world->stepSimulation(FIXED_TIME_STEP, 0);
+
+        Publish(m_write);
+        uint32_t previous = m_shared.exchange(m_write | SNAPSHOT_FRESH);
+        m_write = previous & ~SNAPSHOT_FRESH;
+
+        // reader skipped the buffer, its bodies must be listed by the next one it takes
+        if (!(previous & SNAPSHOT_FRESH))
+            m_snapshots[m_write].moving.clear();
+
+        // time over budget is dropped as in Step, simulation slows down instead of catching up
+        next += step;
+        Clock::time_point now = Clock::now();
+        if (now - next > step * MAX_SUB_STEPS)
+            next = now;
+
+        // world is free for queries while waiting
+        m_condition.wait_until(lock, next, [this] { return m_stop; });
+    }
+}
+
+void Bullet::Publish(uint32_t index)
+{
+    // states changed since this buffer was written, list keeps those still behind in other buffers
+    size_t write = 0;
+    for (MotionState * state : m_changed)
+    {
+        state->Publish(index);
+        if (state->IsChanged())
+            m_changed[write++] = state;
+    }
+    m_changed.resize(write);
+
+    Snapshot & snapshot = m_snapshots[index];
+    snapshot.step = m_step;
+    snapshot.time = std::chrono::steady_clock::now();
+    snapshot.moving.insert(snapshot.moving.end(), m_moving.begin(), m_moving.end());
+    m_moving.clear();
+}
+
+uint64_t Bullet::GetRenderedStep() const
+{
+    return IsThreadRunning() ? m_snapshots[m_read].step : m_step;
+}
+
+void Bullet::Execute(std::function<void()> command)
+{
+    if (!IsThreadRunning())
+    {
+        command();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_commandsMutex);
+    m_commands.push_back(std::move(command));
+}
+
+void Bullet::RunCommands()
+{
+    std::vector<std::function<void()>> commands;
+    {
+        std::lock_guard<std::mutex> lock(m_commandsMutex);
+        commands.swap(m_commands);
+    }
+
+    for (const auto & command : commands)
+        command();
+}
+
+btTransform Bullet::GetTransform(const btRigidBody * body)
+{
+    return static_cast<const MotionState*>(body->getMotionState())->GetTransform();
+}
+
+void Bullet::SetPosition(btRigidBody * body, const glm::vec3 & position)
+{
+    MotionState * state = static_cast<MotionState*>(body->getMotionState());
+
+    state->GetWorld().Execute([body, state, position]()
+    {
+        btTransform transform(body->getWorldTransform());
+        transform.setOrigin(Convert(position));
+
+        body->setWorldTransform(transform);
+        body->setInterpolationWorldTransform(transform);
+        state->Reset(transform);
+    });
+}
+
+void Bullet::SetRotation(btRigidBody * body, const glm::vec3 & rotation)
+{
+    MotionState * state = static_cast<MotionState*>(body->getMotionState());
+
+    state->GetWorld().Execute([body, state, rotation]()
+    {
+        btQuaternion quaternion;
+        quaternion.setEulerZYX(rotation.x, rotation.y, rotation.z);
+
+        btTransform transform(body->getWorldTransform());
+        transform.setRotation(quaternion);
+
+        body->setWorldTransform(transform);
+        body->setInterpolationWorldTransform(transform);
+        state->Reset(transform);
+    });
+}
+
+Bullet::MotionState::MotionState(const btTransform & transform, Bullet & world, uint32_t id)
+    : m_world(world), m_id(id)
+{
+    m_state = { transform, transform, 0 };
+    for (State & published : m_published)
+        published = m_state;
+}
+
+void Bullet::MotionState::getWorldTransform(btTransform & transform) const
+{
+    transform = m_state.current;
+}
+
+void Bullet::MotionState::setWorldTransform(const btTransform & transform)
+{
+    // body not simulated in previous step hasn't moved since
+    m_state.previous = m_state.current;
+    m_state.current = transform;
+    m_state.step = m_world.m_step;
+
+    // called only for active bodies, sleeping and static ones stay off the lists
+    m_world.m_moving.push_back(m_id);
+    MarkChanged();
+}
+
+Bullet & Bullet::MotionState::GetWorld() const
+{
+    return m_world;
+}
+
+void Bullet::MotionState::Reset(const btTransform & transform)
+{
+    // commands run before the step, marking the next one makes static bodies refreshed as well
+    m_state = { transform, transform, m_world.m_step + 1 };
+    m_world.m_moving.push_back(m_id);
+    MarkChanged();
+}
+
+void Bullet::MotionState::MarkChanged()
+{
+    // copies are read only while the physics thread runs, they are all refreshed when it starts
+    if (!m_world.m_publishing)
+        return;
+
+    if (!m_stale)
+        m_world.m_changed.push_back(this);
+
+    m_stale = ALL_BUFFERS;
+}
+
+bool Bullet::MotionState::IsChanged() const
+{
+    return m_stale != 0;
+}
+
+void Bullet::MotionState::Publish(uint32_t index)
+{
+    if (m_stale & (1u << index))
+        m_published[index] = m_state;
+
+    m_stale &= ~(1u << index);
+}
+
+const Bullet::State & Bullet::MotionState::GetState() const
+{
+    return m_world.IsThreadRunning() ? m_published[m_world.m_read] : m_state;
+}
+
+btTransform Bullet::MotionState::GetTransform() const
+{
+    const State & state = GetState();
+    if (state.step != m_world.GetRenderedStep())
+        return state.current;
+
+    float alpha = m_world.m_alpha;
+    return btTransform(state.previous.getRotation().slerp(state.current.getRotation(), alpha),
+        state.previous.getOrigin().lerp(state.current.getOrigin(), alpha));
+}
+
+void Bullet::SetThreadsCount(uint32_t count)
+{
+#if BT_THREADSAFE
+    TaskScheduler::Instance().setNumThreads((int)count);
+#endif
+}
+
+uint32_t Bullet::GetThreadsCount() const
+{
+#if BT_THREADSAFE
+    return (uint32_t)TaskScheduler::Instance().getNumThreads();
+#else
+    return 1;
+#endif
+}
+
+uint32_t Bullet::GetMaxThreadsCount() const
+{
+#if BT_THREADSAFE
+    return (uint32_t)TaskScheduler::Instance().getMaxNumThreads();
+#else
+    return 1;
+#endif
 }
 
 void Bullet::DebugDraw(const glm::mat4 & view, const glm::mat4 & projection)
 {
+    std::lock_guard<std::mutex> lock(m_worldMutex);
+    RunCommands();
+
     m_world->debugDrawWorld();
     m_debug.Draw(view, projection);
+    // world may not be stepped before next draw
+    m_debug.Clear();
 }
 
 struct RayCastResult : public btCollisionWorld::RayResultCallback
@@ -240,7 +623,48 @@ std::vector<Bullet::RayResult> Bullet::RayCast(const glm::vec3 & position, const
     glm::vec3 destination = position + glm::normalize(direction) * TEST_DISTANCE;
     RayCastResult result(Convert(position), Convert(destination));
 
+    // removed bodies must leave the world before their user pointers are read
+    std::lock_guard<std::mutex> lock(m_worldMutex);
+    RunCommands();
+
     m_world->getCollisionWorld()->rayTest(result.fromPoint, result.toPoint, result);
 
     return result.bodies;
 }
+
+struct CullResult : public btDbvt::ICollide
+{
+    std::vector<const btCollisionObject*> & objects;
+
+    CullResult(std::vector<const btCollisionObject*> & result) : objects(result) {}
+
+    virtual void Process(const btDbvtNode * leaf) override
+    {
+        const btBroadphaseProxy * proxy = static_cast<const btBroadphaseProxy*>(leaf->data);
+        objects.push_back(static_cast<const btCollisionObject*>(proxy->m_clientObject));
+    }
+};
+
+void Bullet::Cull(const std::array<glm::vec4, 6> & planes, std::vector<const btCollisionObject*> & result)
+{
+    btVector3 normals[6];
+    btScalar offsets[6];
+
+    for (size_t i = 0; i < planes.size(); ++i)
+    {
+        normals[i] = Convert(glm::vec3(planes[i]));
+        offsets[i] = planes[i].w;
+    }
+
+    result.clear();
+    CullResult callback(result);
+
+    // aabb trees are kept up to date by stepSimulation, dynamic and static objects are in separate sets
+    for (const btDbvt & set : m_broadphase->m_sets)
+        btDbvt::collideKDOP(set.m_root, normals, offsets, (int)planes.size(), callback);
+}
+
+uint32_t Bullet::GetObjectsCount() const
+{
+    return (uint32_t)m_world->getNumCollisionObjects();
+}
@@ -1,8 +1,19 @@
 #pragma once
 
 #include <btBulletDynamicsCommon.h>
+#if BT_THREADSAFE
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#endif
 #include "glm/glm.hpp"
 #include <memory>
+#include <array>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <chrono>
 #include "BulletDebug.h"
 // include shapes because of defintions
 #include "Shapes.h"
@@ -13,20 +24,41 @@ public:
     Bullet(const glm::vec3 & gravity);
     ~Bullet();
 
+    // Changes of bodies and shapes are applied between steps of the world. With the physics thread
+    // running they are queued, new bodies enter the world and removed ones are deleted by next step.
+
+    // Bodies are identified by id of the owner in lists of moved bodies.
+
     // TODO in a case single shape body is created Shapes::Definition position and rotation is actaully body position and rotation
-    btRigidBody * AddBox(const Shapes::Defintion::Box & definition, bool isStatic);
-    btRigidBody * AddSphere(const Shapes::Defintion::Sphere & definition, bool isStatic);
-    btRigidBody * AddCylinder(const Shapes::Defintion::Cylinder & definition, bool isStatic);
-    btRigidBody * AddCone(const Shapes::Defintion::Cone & definition, bool isStatic);
+    btRigidBody * AddBox(const Shapes::Defintion::Box & definition, bool isStatic, uint32_t id);
+    btRigidBody * AddSphere(const Shapes::Defintion::Sphere & definition, bool isStatic, uint32_t id);
+    btRigidBody * AddCylinder(const Shapes::Defintion::Cylinder & definition, bool isStatic, uint32_t id);
+    btRigidBody * AddCone(const Shapes::Defintion::Cone & definition, bool isStatic, uint32_t id);
 
-    btRigidBody * AddCompound(const glm::vec3 & position, const glm::vec3 & rotation, bool isStatic);
+    btRigidBody * AddCompound(const glm::vec3 & position, const glm::vec3 & rotation, bool isStatic, uint32_t id);
     template<class T>
     btCollisionShape * AddShape(btRigidBody * body, const T & definition);
     void RemoveShape(btRigidBody * body, btCollisionShape * shape);
 
     void RemoveBody(btRigidBody * body);
 
-    void Step();
+    // simulation advances by fixed steps of accumulated time, transforms of bodies are interpolated
+    // between the last two steps by time left (see GetTransform), with the physics thread running
+    // it only picks the latest published state and elapsed time is ignored
+    void Step(float elapsed);
+    // steps the world at fixed rate on its own thread, transforms are published to rendering without
+    // locks (triple buffer), not available when Bullet is built with BULLET2_MULTITHREADING as its
+    // parallel loops must be started by the main thread
+    bool StartThread();
+    void StopThread();
+    bool IsThreadRunning() const;
+    // threads solving the world, always one unless Bullet is built with BULLET2_MULTITHREADING,
+    // the scheduler is shared by all worlds
+    void SetThreadsCount(uint32_t count);
+    uint32_t GetThreadsCount() const;
+    uint32_t GetMaxThreadsCount() const;
+
+    // waits for the current step to finish when the physics thread is running
     void DebugDraw(const glm::mat4 & view, const glm::mat4 & projection);
 
     struct RayResult
@@ -35,22 +67,132 @@ public:
         const btCollisionShape * shape;
         glm::vec3 worldPoint;
     };
+    // waits for the current step to finish when the physics thread is running
     std::vector<RayResult> RayCast(const glm::vec3 & position, const glm::vec3 & direction);
 
+    // rendered transform of body, static and sleeping bodies are at their last state
+    static btTransform GetTransform(const btRigidBody * body);
+    // ids of bodies whose rendered transform may have changed by the last Step, simulated ones and
+    // moved by hand, sorted; bodies removed since may be listed
+    const std::vector<uint32_t> & GetMovedBodies() const;
+    // moves body without interpolation from previous state, rotation in euler angles
+    static void SetPosition(btRigidBody * body, const glm::vec3 & position);
+    static void SetRotation(btRigidBody * body, const glm::vec3 & rotation);
+
+    // objects whose broadphase aabb is not outside of planes, xyz normal pointing inside, w distance,
+    // broadphase is owned by the physics thread while it runs
+    void Cull(const std::array<glm::vec4, 6> & planes, std::vector<const btCollisionObject*> & result);
+    uint32_t GetObjectsCount() const;
+
 private:
+    // states of the last two steps body was simulated in
+    struct State
+    {
+        btTransform previous;
+        btTransform current;
+        // step of world current state is from, state of body not simulated in the last one is not interpolated
+        uint64_t step;
+    };
+
+    class MotionState : public btMotionState
+    {
+    public:
+        MotionState(const btTransform & transform, Bullet & world, uint32_t id);
+
+        virtual void getWorldTransform(btTransform & transform) const override;
+        virtual void setWorldTransform(const btTransform & transform) override;
+
+        Bullet & GetWorld() const;
+        // state body is moved to is shown since the next step
+        void Reset(const btTransform & transform);
+        // state differs from all published copies, it is listed to be published to each buffer
+        void MarkChanged();
+        bool IsChanged() const;
+        void Publish(uint32_t index);
+
+        // state not from rendered step is not interpolated
+        btTransform GetTransform() const;
+
+    private:
+        // state read by rendering
+        const State & GetState() const;
+
+        Bullet & m_world;
+        uint32_t m_id;
+        // written by stepping thread
+        State m_state;
+        // copies of state for rendering, one for each buffer of published states
+        State m_published[3];
+        // bit for each buffer whose copy is behind the state
+        uint32_t m_stale = 0;
+    };
+
+    float m_accumulator = 0.0f;
+    float m_alpha = 0.0f;
+    uint64_t m_step = 0;
+
+    // bodies simulated or reset since the list was handed to rendering, written by stepping thread
+    std::vector<uint32_t> m_moving;
+    // bodies simulated in steps rendered now, they follow alpha every frame
+    std::vector<uint32_t> m_interpolated;
+    std::vector<uint32_t> m_moved;
+    // list of bodies moving since previous frame is taken by rendering
+    void UpdateMoved(bool stepped, const std::vector<uint32_t> & moving);
+
+    // changes of world, applied immediately unless the physics thread runs
+    void Execute(std::function<void()> command);
+    void RunCommands();
+    std::mutex m_commandsMutex;
+    std::vector<std::function<void()>> m_commands;
+
+    void Run();
+    // copies changed states of bodies and step to buffer, moving bodies are added to its list
+    void Publish(uint32_t index);
+    // states behind in some buffer, written by stepping thread, so publishing doesn't touch bodies
+    // which haven't changed since each buffer was written
+    std::vector<MotionState*> m_changed;
+    // states are published while the physics thread runs, changed only while it is stopped
+    bool m_publishing = false;
+    // step of state read by rendering
+    uint64_t GetRenderedStep() const;
+
+    std::thread m_thread;
+    // held by the physics thread while stepping, guards m_stop
+    std::mutex m_worldMutex;
+    std::condition_variable m_condition;
+    bool m_stop = false;
+
+    // triple buffer of published states, writer and reader own one buffer each and swap it with the
+    // shared one, fresh flag marks buffer written since reader took one
+    struct Snapshot
+    {
+        uint64_t step = 0;
+        std::chrono::steady_clock::time_point time;
+        // bodies moving since buffer taken by reader before, buffer skipped by reader keeps its list
+        std::vector<uint32_t> moving;
+    };
+    static const uint32_t SNAPSHOT_FRESH = 0x4;
+    Snapshot m_snapshots[3];
+    std::atomic<uint32_t> m_shared{ 2 };
+    uint32_t m_write = 1;
+    uint32_t m_read = 0;
+
     btBoxShape * CreateShape(const Shapes::Defintion::Box & definition);
     btSphereShape * CreateShape(const Shapes::Defintion::Sphere & definition);
     btCylinderShape * CreateShape(const Shapes::Defintion::Cylinder & definition);
     btConeShape * CreateShape(const Shapes::Defintion::Cone & definition);
 
-    btRigidBody * AddCommon(const glm::vec3 & position, const glm::vec3 & rotation, bool isStatic, btCollisionShape * shape);
+    btRigidBody * AddCommon(const glm::vec3 & position, const glm::vec3 & rotation, bool isStatic, uint32_t id, btCollisionShape * shape);
 
     BulletDebug m_debug;
 
     std::unique_ptr<btDefaultCollisionConfiguration> m_collisionConfiguration;
     std::unique_ptr<btCollisionDispatcher> m_dispatcher;
-    std::unique_ptr<btBroadphaseInterface> m_broadphase;
+    std::unique_ptr<btDbvtBroadphase> m_broadphase;
     std::unique_ptr<btSequentialImpulseConstraintSolver> m_solver;
+#if BT_THREADSAFE
+    std::unique_ptr<btConstraintSolverPoolMt> m_solverPool;
+#endif
     std::unique_ptr<btDiscreteDynamicsWorld> m_world;
 
     btAlignedObjectArray<btCollisionShape*> m_collisionShapes;
@@ -0,0 +1,103 @@
+#include "RenderQueue.h"
+#include <cstring>
+#include <array>
+
+static const uint32_t DEPTH_BITS = 24;
+static const uint32_t MATERIAL_BITS = 24;
+static const uint32_t MESH_BITS = 6;
+static const uint32_t SHADER_BITS = 6;
+static const uint32_t PASS_BITS = 4;
+
+static uint64_t Field(uint32_t value, uint32_t bits, uint32_t shift)
+{
+    return uint64_t(value & ((1u << bits) - 1)) << shift;
+}
+
+// maps float to unsigned integer with the same ordering
+static uint32_t OrderedBits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    // negative numbers are ordered backwards, positive ones need to be above them
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+uint64_t RenderQueue::MakeKey(uint32_t pass, uint32_t shader, uint32_t mesh, uint32_t material, float depth)
+{
+    uint32_t shift = 0;
+    uint64_t result = Field(OrderedBits(depth) >> (32 - DEPTH_BITS), DEPTH_BITS, shift);
+    result |= Field(material, MATERIAL_BITS, shift += DEPTH_BITS);
+    result |= Field(mesh, MESH_BITS, shift += MATERIAL_BITS);
+    result |= Field(shader, SHADER_BITS, shift += MESH_BITS);
+    result |= Field(pass, PASS_BITS, shift += SHADER_BITS);
+
+    return result;
+}
+
+uint32_t RenderQueue::Hash(const void * data, size_t size)
+{
+    // FNV-1a folded to 24 bits
+    const uint8_t * bytes = (const uint8_t*)data;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 16777619u;
+
+    return (hash >> MATERIAL_BITS) ^ (hash & ((1u << MATERIAL_BITS) - 1));
+}
+
+float RenderQueue::GetDepth(const glm::mat4 & viewProjection, const glm::vec3 & position)
+{
+    // clip space z grows with distance for both projections
+    return viewProjection[0][2] * position.x + viewProjection[1][2] * position.y + viewProjection[2][2] * position.z + viewProjection[3][2];
+}
+
+void RenderQueue::Clear()
+{
+    m_records.clear();
+}
+
+void RenderQueue::Add(uint64_t key, uint32_t index)
+{
+    m_records.push_back({ key, index });
+}
+
+void RenderQueue::Sort()
+{
+    // histograms of all bytes in one pass
+    std::array<std::array<uint32_t, 256>, 8> histograms = {};
+    for (const Record & record : m_records)
+    {
+        for (size_t byte = 0; byte < 8; ++byte)
+            histograms[byte][(record.key >> (byte * 8)) & 0xFF]++;
+    }
+
+    m_sorted.resize(m_records.size());
+
+    for (size_t byte = 0; byte < 8; ++byte)
+    {
+        std::array<uint32_t, 256> & histogram = histograms[byte];
+
+        // all records have the same value of this byte
+        if (histogram[(m_records.empty() ? 0 : m_records[0].key >> (byte * 8)) & 0xFF] == m_records.size())
+            continue;
+
+        uint32_t offset = 0;
+        for (uint32_t & count : histogram)
+        {
+            uint32_t current = count;
+            count = offset;
+            offset += current;
+        }
+
+        for (const Record & record : m_records)
+            m_sorted[histogram[(record.key >> (byte * 8)) & 0xFF]++] = record;
+
+        m_records.swap(m_sorted);
+    }
+}
+
+const std::vector<RenderQueue::Record> & RenderQueue::GetRecords() const
+{
+    return m_records;
+}
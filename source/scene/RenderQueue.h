@@ -0,0 +1,42 @@
+#pragma once
+#include "glm/glm.hpp"
+#include <vector>
+#include <cstdint>
+
+// Flat list of draws sorted by 64-bit key, so that draws sharing state follow each other.
+// Key from the most significant bits:
+//      pass      4 bits
+//      shader    6 bits
+//      mesh      6 bits
+//      material 24 bits, hash of material data
+//      depth    24 bits, front to back
+class RenderQueue
+{
+public:
+    struct Record
+    {
+        uint64_t key;
+        // index into array of draws of the owner
+        uint32_t index;
+    };
+
+    static uint64_t MakeKey(uint32_t pass, uint32_t shader, uint32_t mesh, uint32_t material, float depth);
+
+    // 24-bit hash of plain data
+    static uint32_t Hash(const void * data, size_t size);
+
+    // depth of point in clip space of given matrix, works for both perspective and orthographic projection
+    static float GetDepth(const glm::mat4 & viewProjection, const glm::vec3 & position);
+
+    void Clear();
+    void Add(uint64_t key, uint32_t index);
+
+    // stable radix sort, bytes which are the same for all records are skipped
+    void Sort();
+
+    const std::vector<Record> & GetRecords() const;
+
+private:
+    std::vector<Record> m_records;
+    std::vector<Record> m_sorted;
+};
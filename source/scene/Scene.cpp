@@ -1,25 +1,43 @@
 #include "Scene.h"
 #include "glm/gtc/matrix_transform.hpp"
+#include "utils/GLState.h"
+#include "model/ModelShaderManager.h"
+#include <cstring>
 
 static const glm::vec3 WORLD_GRAVITY(0.0f, -10.0f, 0.0f);
+// radius of sphere enclosing unit shapes, these fit into <-1, 1> cube
+static const float SHAPE_RADIUS = 1.7321f;
 
-glm::vec3 Scene::BodyHandle::GetPosition()
+Scene::BodyHandle::BodyHandle(Scene * scene, SlotMap::Handle handle)
+    : m_scene(scene), m_handle(handle)
 {
-    auto p = it->body->getWorldTransform().getOrigin();
-    return { p.x(), p.y(), p.z() };
 }
 
-void Scene::BodyHandle::SetPosition(const glm::vec3& position)
+uint32_t Scene::BodyHandle::GetIndex() const
 {
-    btTransform t(it->body->getWorldTransform());
-    t.setOrigin({ position.x, position.y, position.z });
+    if (!m_scene)
+    {
+        printf("Scene null body handle\n");
+        throw std::runtime_error("Scene null body handle");
+    }
 
-    it->body->setWorldTransform(t);
+    return m_scene->m_bodies.slots.GetIndex(m_handle);
 }
 
-glm::vec3 Scene::BodyHandle::GetRotation()
+glm::vec3 Scene::BodyHandle::GetPosition() const
 {
-    btQuaternion q = it->body->getWorldTransform().getRotation();
+    auto p = Bullet::GetTransform(m_scene->m_bodies.body[GetIndex()]).getOrigin();
+    return { p.x(), p.y(), p.z() };
+}
+
+void Scene::BodyHandle::SetPosition(const glm::vec3& position) const
+{
+    Bullet::SetPosition(m_scene->m_bodies.body[GetIndex()], position);
+}
+
+glm::vec3 Scene::BodyHandle::GetRotation() const
+{
+    btQuaternion q = Bullet::GetTransform(m_scene->m_bodies.body[GetIndex()]).getRotation();
     glm::vec3 r;
 
     q.getEulerZYX(r.x, r.y, r.z);
@@ -27,83 +45,153 @@ glm::vec3 Scene::BodyHandle::GetRotation()
     return r;
 }
 
-void Scene::BodyHandle::SetRotation(const glm::vec3& rotation)
+void Scene::BodyHandle::SetRotation(const glm::vec3& rotation) const
 {
-    btTransform t(it->body->getWorldTransform());
-    btQuaternion q;
-    q.setEulerZYX(rotation.x, rotation.y, rotation.z);
-    t.setRotation(q);
+    Bullet::SetRotation(m_scene->m_bodies.body[GetIndex()], rotation);
+}
 
-    it->body->setWorldTransform(t);
+bool Scene::BodyHandle::IsStatic() const
+{
+    return m_scene->m_bodies.body[GetIndex()]->isStaticObject();
+}
+
+bool Scene::BodyHandle::IsCompound() const
+{
+    return m_scene->m_bodies.body[GetIndex()]->getCollisionShape()->isCompound();
+}
+
+const std::vector<Scene::Shape> & Scene::BodyHandle::GetShapes() const
+{
+    return m_scene->m_bodies.shapes[GetIndex()];
+}
+
+bool Scene::BodyHandle::IsValid() const
+{
+    return m_scene && m_scene->m_bodies.slots.Find(m_handle).has_value();
 }
 
-bool Scene::BodyHandle::IsStatic()
+Scene::BodyHandle::operator bool() const
 {
-    return it->body->isStaticObject();
+    return m_handle != SlotMap::INVALID;
 }
 
-bool Scene::BodyHandle::IsCompound()
+bool Scene::BodyHandle::operator==(const BodyHandle & o) const
 {
-    return it->body->getCollisionShape()->isCompound();
+    return m_scene == o.m_scene && m_handle == o.m_handle;
 }
 
-const std::vector<Scene::Shape> & Scene::BodyHandle::GetShapes()
+bool Scene::BodyHandle::operator!=(const BodyHandle & o) const
 {
-    return it->shapes;
+    return !(*this == o);
 }
 
-glm::vec3 Scene::ShapeHandle::GetPosition()
+bool Scene::BodyHandle::operator<(const BodyHandle & o) const
+{
+    return m_scene != o.m_scene ? m_scene < o.m_scene : m_handle < o.m_handle;
+}
+
+Scene::ShapeHandle::ShapeHandle(Scene * scene, SlotMap::Handle handle)
+    : m_scene(scene), m_handle(handle)
+{
+}
+
+uint32_t Scene::ShapeHandle::GetIndex() const
+{
+    if (!m_scene)
+    {
+        printf("Scene null shape handle\n");
+        throw std::runtime_error("Scene null shape handle");
+    }
+
+    return m_scene->m_shapes.slots.GetIndex(m_handle);
+}
+
+glm::vec3 Scene::ShapeHandle::GetPosition() const
 {
     // TODO transform from compound shape
     return glm::vec3(0.0f);
 }
 
-glm::vec3 Scene::ShapeHandle::GetRotation()
+glm::vec3 Scene::ShapeHandle::GetRotation() const
 {
     // TODO transform from compound shape
     return glm::vec3(0.0f);
 }
 
-glm::vec3 Scene::ShapeHandle::GetScale()
+glm::vec3 Scene::ShapeHandle::GetScale() const
+{
+    return m_scene->m_shapes.scale[GetIndex()];
+}
+
+Shapes::Type Scene::ShapeHandle::GetType() const
+{
+    return m_scene->m_shapes.shape[GetIndex()]->type;
+}
+
+Scene::BodyHandle Scene::ShapeHandle::GetBody() const
+{
+    return BodyHandle(m_scene, m_scene->m_shapes.body[GetIndex()]);
+}
+
+uint32_t& Scene::ShapeHandle::GetFlags() const
+{
+    return m_scene->m_shapes.flags[GetIndex()];
+}
+
+const glm::mat4& Scene::ShapeHandle::GetTransform() const
 {
-    return it->second.scale;
+    return m_scene->m_shapes.model[GetIndex()];
 }
 
-Shapes::Type Scene::ShapeHandle::GetType()
+Material::Data& Scene::ShapeHandle::GetMaterial() const
 {
-    return it->first->type;
+    return m_scene->m_shapes.material[GetIndex()];
 }
 
-Scene::BodyHandle * Scene::ShapeHandle::GetBody()
+bool Scene::ShapeHandle::IsValid() const
 {
-    return it->second.body;
+    return m_scene && m_scene->m_shapes.slots.Find(m_handle).has_value();
 }
 
-uint32_t& Scene::ShapeHandle::GetFlags()
+Scene::ShapeHandle::operator bool() const
 {
-    return it->second.flags;
+    return m_handle != SlotMap::INVALID;
 }
 
-const glm::mat4& Scene::ShapeHandle::GetTransform()
+bool Scene::ShapeHandle::operator==(const ShapeHandle & o) const
 {
-    return it->second.model;
+    return m_scene == o.m_scene && m_handle == o.m_handle;
 }
 
-Material::Data& Scene::ShapeHandle::GetMaterial()
+bool Scene::ShapeHandle::operator!=(const ShapeHandle & o) const
 {
-    return it->second.material;
+    return !(*this == o);
+}
+
+bool Scene::ShapeHandle::operator<(const ShapeHandle & o) const
+{
+    return m_scene != o.m_scene ? m_scene < o.m_scene : m_handle < o.m_handle;
 }
 
 Scene::Scene(const Light::Config & light)
     : m_world(WORLD_GRAVITY)
 {
+    InvalidateCasters();
+
     ModelShader::Config config;
 
     config.light = light;
     config.shading = ModelShader::ShadingModel::BlinnPhong;
     config.flags = (uint32_t)ModelShader::Config::Flags::UseRuntimeMaterial;
 
-    m_shader = std::make_unique<ModelShader>(config);
+    m_instanced = IsInstancingSupported();
+    if (m_instanced)
+    {
+        config.flags = (uint32_t)ModelShader::Config::Flags::Instanced;
+        glGenBuffers(1, &m_instanceBuffer);
+    }
+
+    m_shader = ModelShaderManager::Instance().GetShader(config);
     m_cube = std::make_unique<Shapes::Cube>(m_shader.get());
     m_sphere = std::make_unique<Shapes::Sphere>(m_shader.get());
     m_cylinder = std::make_unique<Shapes::Cylinder>(m_shader.get());
@@ -112,37 +200,42 @@ Scene::Scene(const Light::Config & light)
 
 Scene::~Scene()
 {
-
+    if (m_instanceBuffer)
+        GLState::Instance().DeleteBuffer(m_instanceBuffer);
 }
 
 Scene::Body Scene::AddCube(const Shapes::Defintion::Box & definition, const Material::Data & material, bool isStatic)
 {
-    Body body = AddBody(m_world.AddBox(definition, isStatic));
-    AddShape(body->it->body->getCollisionShape(), glm::mat4(1.0f), definition.extents, body, material, m_cube.get(), 0);
+    SlotMap::Handle handle = ReserveBody();
+    Body body = AddBody(handle, m_world.AddBox(definition, isStatic, handle));
+    AddShape(m_bodies.body[body.GetIndex()]->getCollisionShape(), glm::mat4(1.0f), definition.extents, body, material, m_cube.get(), 0);
 
     return body;
 }
 
 Scene::Body Scene::AddSphere(const Shapes::Defintion::Sphere & definition, const Material::Data & material, bool isStatic)
 {
-    Body body = AddBody(m_world.AddSphere(definition, isStatic));
-    AddShape(body->it->body->getCollisionShape(), glm::mat4(1.0f), glm::vec3(definition.radius), body, material, m_sphere.get(), 0);
+    SlotMap::Handle handle = ReserveBody();
+    Body body = AddBody(handle, m_world.AddSphere(definition, isStatic, handle));
+    AddShape(m_bodies.body[body.GetIndex()]->getCollisionShape(), glm::mat4(1.0f), glm::vec3(definition.radius), body, material, m_sphere.get(), 0);
 
     return body;
 }
 
 Scene::Body Scene::AddCylinder(const Shapes::Defintion::Cylinder & definition, const Material::Data & material, bool isStatic)
 {
-    Body body = AddBody(m_world.AddCylinder(definition, isStatic));
-    AddShape(body->it->body->getCollisionShape(), glm::mat4(1.0f), glm::vec3(definition.radius, definition.height, definition.radius), body, material, m_cylinder.get(), 0);
+    SlotMap::Handle handle = ReserveBody();
+    Body body = AddBody(handle, m_world.AddCylinder(definition, isStatic, handle));
+    AddShape(m_bodies.body[body.GetIndex()]->getCollisionShape(), glm::mat4(1.0f), glm::vec3(definition.radius, definition.height, definition.radius), body, material, m_cylinder.get(), 0);
 
     return body;
 }
 
 Scene::Body Scene::AddCone(const Shapes::Defintion::Cone & definition, const Material::Data & material, bool isStatic)
 {
-    Body body = AddBody(m_world.AddCone(definition, isStatic));
-    AddShape(body->it->body->getCollisionShape(), glm::mat4(1.0f), glm::vec3(definition.radius, definition.height, definition.radius), body, material, m_cone.get(), 0);
+    SlotMap::Handle handle = ReserveBody();
+    Body body = AddBody(handle, m_world.AddCone(definition, isStatic, handle));
+    AddShape(m_bodies.body[body.GetIndex()]->getCollisionShape(), glm::mat4(1.0f), glm::vec3(definition.radius, definition.height, definition.radius), body, material, m_cone.get(), 0);
 
     return body;
 }
@@ -166,8 +259,9 @@ Scene::Body Scene::AddCompound(const glm::vec3 & position, const glm::vec3 & rot
     const std::vector<std::tuple<Shapes::Defintion::Cylinder, Material::Data>> & cylinder,
     const std::vector<std::tuple<Shapes::Defintion::Cone, Material::Data>> & cone)
 {
-    btRigidBody * worldBody = m_world.AddCompound(position, rotation, isStatic);
-    Body body = AddBody(worldBody);
+    SlotMap::Handle handle = ReserveBody();
+    btRigidBody * worldBody = m_world.AddCompound(position, rotation, isStatic, handle);
+    Body body = AddBody(handle, worldBody);
 
     for (const auto&[definition, material] : box)
         AddShape(m_world.AddShape(worldBody, definition), GetTransform(definition), definition.extents, body, material, m_cube.get(), 0);
@@ -184,48 +278,52 @@ Scene::Body Scene::AddCompound(const glm::vec3 & position, const glm::vec3 & rot
     return body;
 }
 
-Scene::Body Scene::AddBody(btRigidBody * body)
+SlotMap::Handle Scene::ReserveBody()
 {
-    BodyHandle * newBody = new BodyHandle;
-
-    BodyData data;
-    data.body = body;
-    data.handle.reset(newBody);
+    SlotMap::Handle handle = m_bodies.slots.Add();
+    m_bodies.body.push_back(nullptr);
+    m_bodies.shapes.emplace_back();
 
-    auto it = m_bodies.insert(std::move(data));
-    it.first->handle->it = it.first;
+    return handle;
+}
 
-    body->setUserPointer(newBody);
+Scene::Body Scene::AddBody(SlotMap::Handle handle, btRigidBody * body)
+{
+    m_bodies.body[m_bodies.slots.GetIndex(handle)] = body;
+    body->setUserIndex((int)handle);
 
-    return newBody;
+    return Body(this, handle);
 }
 
-Scene::Shape Scene::AddShape(btCollisionShape * shape, const glm::mat4 & localTransform, const glm::vec3 & scale, BodyHandle * body, const Material::Data & material, Shapes::Shape * drawShape, uint32_t flags)
+Scene::Shape Scene::AddShape(btCollisionShape * shape, const glm::mat4 & localTransform, const glm::vec3 & scale, Body body, const Material::Data & material, Shapes::Shape * drawShape, uint32_t flags)
 {
-    ShapeHandle * newShape = new ShapeHandle;
+    SlotMap::Handle handle = m_shapes.slots.Add();
+    uint32_t index = m_shapes.slots.GetIndex(handle);
+
+    m_shapes.model.push_back(glm::mat4(1.0f));
+    m_shapes.localTransform.push_back(localTransform);
+    m_shapes.scale.push_back(scale);
+    m_shapes.material.push_back(material);
+    m_shapes.flags.push_back(flags);
+    m_shapes.shape.push_back(drawShape);
+    m_shapes.collisionShape.push_back(shape);
+    m_shapes.body.push_back(body.m_handle);
 
-    ShapeData data;
-    data.body = body;
-    data.handle.reset(newShape);
-    data.material = material;
-    data.model = glm::mat4(1.0f);
-    data.scale = scale;
-    data.shape = shape;
-    data.localTransform = localTransform;
-    data.flags = flags;
+    shape->setUserIndex((int)handle);
 
-    std::multimap<Shapes::Shape*, ShapeData>::iterator it = m_shapes.insert({ drawShape, std::move(data) });
-    newShape->it = it;
+    uint32_t bodyIndex = body.GetIndex();
 
-    shape->setUserPointer(newShape);
+    glm::mat4 model;
+    Bullet::GetTransform(m_bodies.body[bodyIndex]).getOpenGLMatrix(&model[0][0]);
 
-    RefreshShapeModel(it->second);
+    RefreshShapeModel(index, model);
+    if (!(flags & ShapeFlagNoDraw))
+        InvalidateCasters();
 
-    // TODO why need to const cast here ?
-    std::vector<ShapeHandle*> & shapes = const_cast<std::vector<ShapeHandle*>&>(body->it->shapes);
-    shapes.push_back(newShape);
+    Shape result(this, handle);
+    m_bodies.shapes[bodyIndex].push_back(result);
 
-    return newShape;
+    return result;
 }
 
 template<class T>
@@ -238,115 +336,320 @@ Scene::Shape Scene::AddShape(Body compound, const T& definition, const Material:
 template<>
 Scene::Shape Scene::AddShape(Body compound, const Shapes::Defintion::Box & definition, const Material::Data & material, uint32_t flags)
 {
-    return AddShape(m_world.AddShape(compound->it->body, definition), GetTransform(definition), 
+    return AddShape(m_world.AddShape(m_bodies.body[compound.GetIndex()], definition), GetTransform(definition), 
         definition.extents, compound, material, m_cube.get(), flags);
 }
 
 template<>
 Scene::Shape Scene::AddShape(Body compound, const Shapes::Defintion::Sphere & definition, const Material::Data & material, uint32_t flags)
 {
-    return AddShape(m_world.AddShape(compound->it->body, definition), GetTransform(definition), 
+    return AddShape(m_world.AddShape(m_bodies.body[compound.GetIndex()], definition), GetTransform(definition), 
         glm::vec3(definition.radius), compound, material, m_sphere.get(), flags);
 }
 
 template<>
 Scene::Shape Scene::AddShape(Body compound, const Shapes::Defintion::Cylinder & definition, const Material::Data & material, uint32_t flags)
 {
-    return AddShape(m_world.AddShape(compound->it->body, definition), GetTransform(definition),
+    return AddShape(m_world.AddShape(m_bodies.body[compound.GetIndex()], definition), GetTransform(definition),
         glm::vec3(definition.radius, definition.height, definition.radius), compound, material, m_cylinder.get(), flags);
 }
 
 template<>
 Scene::Shape Scene::AddShape(Body compound, const Shapes::Defintion::Cone & definition, const Material::Data & material, uint32_t flags)
 {
-    return AddShape(m_world.AddShape(compound->it->body, definition), GetTransform(definition),
+    return AddShape(m_world.AddShape(m_bodies.body[compound.GetIndex()], definition), GetTransform(definition),
         glm::vec3(definition.radius, definition.height, definition.radius), compound, material, m_cone.get(), flags);
 }
 
 void Scene::RemoveBody(Body body)
 {
+    uint32_t index = body.GetIndex();
+
     // remove all shapes
-    for (ShapeHandle * shape : body->it->shapes)
-        m_shapes.erase(shape->it);
+    for (Shape shape : m_bodies.shapes[index])
+    {
+        uint32_t shapeIndex = m_shapes.slots.Remove(shape.m_handle);
+        SlotMap::Erase(shapeIndex, m_shapes.model, m_shapes.localTransform, m_shapes.scale, m_shapes.material,
+            m_shapes.flags, m_shapes.shape, m_shapes.collisionShape, m_shapes.body);
+    }
     // remove body
-    m_world.RemoveBody(body->it->body);
-    m_bodies.erase(body->it);
+    m_world.RemoveBody(m_bodies.body[index]);
+
+    m_bodies.slots.Remove(body.m_handle);
+    SlotMap::Erase(index, m_bodies.body, m_bodies.shapes);
+
+    InvalidateCasters();
+}
+
+void Scene::InvalidateCasters()
+{
+    // unique among scenes, shadow maps are shared by shaders of the same light config
+    static uint64_t revision = 0;
+    m_casters = ++revision;
 }
 
 void Scene::RefreshShapeModels()
 {
-    for (auto & shape : m_shapes)
+    bool moved = false;
+
+    // static and sleeping bodies are never listed
+    for (SlotMap::Handle handle : m_world.GetMovedBodies())
     {
-        // TODO some optimization, no need to get transform for sleeping bodies
-        RefreshShapeModel(shape.second);
+        // body may have been removed since it moved
+        std::optional<uint32_t> index = m_bodies.slots.Find(handle);
+        if (!index)
+            continue;
+
+        // transform of body is shared by all its shapes
+        glm::mat4 model;
+        Bullet::GetTransform(m_bodies.body[*index]).getOpenGLMatrix(&model[0][0]);
+
+        for (Shape shape : m_bodies.shapes[*index])
+        {
+            uint32_t shapeIndex = m_shapes.slots.GetIndex(shape.m_handle);
+            if (RefreshShapeModel(shapeIndex, model) && !(m_shapes.flags[shapeIndex] & ShapeFlagNoDraw))
+                moved = true;
+        }
     }
+
+    if (moved)
+        InvalidateCasters();
 }
 
-void Scene::RefreshShapeModel(ShapeData & cube)
+bool Scene::RefreshShapeModel(uint32_t shape, const glm::mat4 & body)
 {
-    cube.body->it->body->getWorldTransform().getOpenGLMatrix(&cube.model[0][0]);
+    glm::mat4 model = body * m_shapes.localTransform[shape];
 
-    cube.model = cube.model * cube.localTransform;
+    model = glm::scale(model, m_shapes.scale[shape]);
 
-    cube.model = glm::scale(cube.model, cube.scale);
+    if (model == m_shapes.model[shape])
+        return false;
+
+    m_shapes.model[shape] = model;
+    return true;
 }
 
-void Scene::Step()
+void Scene::Step(float elapsed)
 {
-    m_world.Step();
+    m_world.Step(elapsed);
 
     RefreshShapeModels();
 }
 
-void Scene::DrawShapes(DrawType drawType, const glm::mat4 & view, const glm::mat4 & projection)
+void Scene::SetPhysicsThreads(uint32_t count)
 {
-    if (m_shapes.empty())
-        return;
+    m_world.SetThreadsCount(count);
+}
+
+uint32_t Scene::GetPhysicsThreads() const
+{
+    return m_world.GetThreadsCount();
+}
+
+uint32_t Scene::GetMaxPhysicsThreads() const
+{
+    return m_world.GetMaxThreadsCount();
+}
+
+bool Scene::StartPhysicsThread()
+{
+    return m_world.StartThread();
+}
 
-    auto it = m_shapes.begin();
-    Shapes::Shape * shape = it->first;
-    shape->Bind();
+void Scene::StopPhysicsThread()
+{
+    m_world.StopThread();
+}
 
-    while (it != std::end(m_shapes))
+bool Scene::IsPhysicsThreadRunning() const
+{
+    return m_world.IsThreadRunning();
+}
+
+void Scene::CollectDrawables(const std::optional<Frustum> & frustum)
+{
+    m_drawables.clear();
+
+    uint32_t count = m_shapes.slots.GetSize();
+
+    if (!frustum)
     {
-        if (it->first != shape)
+        for (uint32_t i = 0; i < count; ++i)
         {
-            shape = it->first;
-            shape->Bind();
+            if (!(m_shapes.flags[i] & ShapeFlagNoDraw))
+                m_drawables.push_back(i);
         }
+        return;
+    }
 
-        while (it != std::end(m_shapes) && it->first == shape)
+    // broadphase belongs to the physics thread, rendered models are tested instead
+    if (m_world.IsThreadRunning())
+    {
+        for (uint32_t i = 0; i < count; ++i)
         {
-            if (it->second.flags & ShapeFlagNoDraw)
+            if (m_shapes.flags[i] & ShapeFlagNoDraw)
+                continue;
+
+            m_statistics.shapes.tested++;
+            if (!frustum->IsSphereVisible(glm::vec3(0.0f), SHAPE_RADIUS, m_shapes.model[i]))
             {
-                it++;
+                m_statistics.shapes.culled++;
                 continue;
             }
 
-            if (drawType == DrawType::Shadow)
+            m_drawables.push_back(i);
+        }
+        return;
+    }
+
+    m_world.Cull(frustum->GetPlanes(), m_visibleObjects);
+
+    m_statistics.bodies.tested += m_world.GetObjectsCount();
+    m_statistics.bodies.culled += m_world.GetObjectsCount() - (uint32_t)m_visibleObjects.size();
+
+    for (const btCollisionObject * object : m_visibleObjects)
+    {
+        uint32_t body = m_bodies.slots.GetIndex((SlotMap::Handle)object->getUserIndex());
+        // aabb of compound body encloses all its shapes
+        bool compound = object->getCollisionShape()->isCompound();
+
+        for (Shape shape : m_bodies.shapes[body])
+        {
+            uint32_t index = m_shapes.slots.GetIndex(shape.m_handle);
+            if (m_shapes.flags[index] & ShapeFlagNoDraw)
+                continue;
+
+            if (compound)
             {
-                m_shader->BindTransformShadow(it->second.model);
+                m_statistics.shapes.tested++;
+                if (!frustum->IsSphereVisible(glm::vec3(0.0f), SHAPE_RADIUS, m_shapes.model[index]))
+                {
+                    m_statistics.shapes.culled++;
+                    continue;
+                }
             }
-            else
+
+            m_drawables.push_back(index);
+        }
+    }
+}
+
+void Scene::DrawShapes(DrawType drawType, uint32_t pass, const glm::mat4 & view, const glm::mat4 & projection, const std::optional<glm::mat4> & viewProjection)
+{
+    std::optional<Frustum> frustum;
+    if (viewProjection)
+        frustum.emplace(*viewProjection);
+
+    CollectDrawables(frustum);
+
+    m_queue.Clear();
+
+    for (uint32_t i = 0; i < m_drawables.size(); ++i)
+    {
+        uint32_t index = m_drawables[i];
+
+        // depth only pass doesn't care about materials, neither do instanced draws
+        uint32_t material = drawType == DrawType::Material && !m_instanced ? RenderQueue::Hash(&m_shapes.material[index], sizeof(Material::Data)) : 0;
+        float depth = viewProjection ? RenderQueue::GetDepth(*viewProjection, glm::vec3(m_shapes.model[index][3])) : 0.0f;
+
+        // all shapes share one shader
+        m_queue.Add(RenderQueue::MakeKey(pass, 0, (uint32_t)m_shapes.shape[index]->type, material, depth), i);
+    }
+
+    m_queue.Sort();
+
+    if (drawType == DrawType::Material && m_instanced)
+    {
+        DrawInstanced(view, projection);
+        return;
+    }
+
+    Shapes::Shape * shape = nullptr;
+    const Material::Data * material = nullptr;
+
+    for (const RenderQueue::Record & record : m_queue.GetRecords())
+    {
+        uint32_t index = m_drawables[record.index];
+
+        if (m_shapes.shape[index] != shape)
+        {
+            shape = m_shapes.shape[index];
+            shape->Bind();
+        }
+
+        if (drawType == DrawType::Shadow)
+        {
+            m_shader->BindTransformShadow(m_shapes.model[index]);
+        }
+        else
+        {
+            // same materials follow each other, hashes may collide so the data are compared
+            if (!material || memcmp(material, &m_shapes.material[index], sizeof(Material::Data)) != 0)
             {
-                m_shader->BindMaterial(it->second.material);
-                m_shader->BindTransform(it->second.model, view, projection);
+                material = &m_shapes.material[index];
+                m_shader->BindMaterial(*material);
             }
 
-            shape->Draw();
-
-            it++;
+            m_shader->BindTransform(m_shapes.model[index], view, projection);
         }
+
+        shape->Draw();
+    }
+}
+
+void Scene::DrawInstanced(const glm::mat4 & view, const glm::mat4 & projection)
+{
+    const std::vector<RenderQueue::Record> & records = m_queue.GetRecords();
+    if (records.empty())
+        return;
+
+    m_instances.clear();
+    for (const RenderQueue::Record & record : records)
+    {
+        uint32_t index = m_drawables[record.index];
+        const Material::Data & material = m_shapes.material[index];
+
+        m_instances.push_back({ m_shapes.model[index], material.ambient, material.diffuse, material.specular, { material.shininess, material.shininessStrength } });
+    }
+
+    // new storage every frame, driver doesn't have to wait for draws of previous one
+    GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_instances.size() * sizeof(Instances::Data), m_instances.data(), GL_STREAM_DRAW);
+    CheckGlError("glBufferData");
+
+    m_shader->BindViewProjection(view, projection);
+
+    // records are sorted by shape type first, each type is one range of instance buffer
+    for (size_t first = 0; first < records.size();)
+    {
+        Shapes::Shape * shape = m_shapes.shape[m_drawables[records[first].index]];
+
+        size_t last = first + 1;
+        while (last < records.size() && m_shapes.shape[m_drawables[records[last].index]] == shape)
+            last++;
+
+        shape->Bind();
+        m_shader->BindInstances(m_instanceBuffer, uint32_t(first * sizeof(Instances::Data)));
+        shape->DrawInstanced((GLsizei)(last - first));
+        m_shader->UnbindInstances();
+
+        first = last;
     }
 }
 
 void Scene::Draw(const glm::mat4 & view, const glm::mat4 & projection, const glm::vec3 & cameraPosition, const Light::Data & data)
 {
+    m_statistics = {};
+
     m_shader->BeginRender();
 
-    while (m_shader->BeginRenderShadow(data))
+    uint32_t pass = 0;
+
+    // maps are rendered only when light or casters changed since they were rendered last time
+    while (m_shader->BeginRenderShadow(data, m_casters))
     {
-        DrawShapes(DrawType::Shadow, view, projection);
+        // cube map of point light is not culled
+        DrawShapes(DrawType::Shadow, pass++, view, projection, m_shader->GetShadowLightSpaceMatrix());
 
         m_shader->EndRenderShadow();
     }
@@ -354,7 +657,10 @@ void Scene::Draw(const glm::mat4 & view, const glm::mat4 & projection, const glm
     m_shader->BindCamera(cameraPosition);
     m_shader->BindLight(data);
 
-    DrawShapes(DrawType::Material, view, projection);
+    DrawShapes(DrawType::Material, pass, view, projection, projection * view);
+
+    m_statistics.visible = (uint32_t)m_drawables.size();
+    m_statistics.total = m_shapes.slots.GetSize();
 
     m_shader->EndRender();
 }
@@ -364,6 +670,11 @@ void Scene::DrawDebug(const glm::mat4 & view, const glm::mat4 & projection)
     m_world.DebugDraw(view, projection);
 }
 
+const Scene::Statistics & Scene::GetStatistics() const
+{
+    return m_statistics;
+}
+
 std::vector<std::tuple<Scene::Shape, glm::vec3>> Scene::RayCast(const glm::vec3 & position, const glm::vec3 & direction)
 {
     auto castResult = m_world.RayCast(position, direction);
@@ -371,7 +682,11 @@ std::vector<std::tuple<Scene::Shape, glm::vec3>> Scene::RayCast(const glm::vec3
     std::vector<std::tuple<Scene::Shape, glm::vec3>> result;
     for (auto[_, shape, position] : castResult)
     {
-        result.push_back({ (Shape)shape->getUserPointer(), position });
+        // with the physics thread running removal from the world is deferred to its next step,
+        // shapes already removed from the scene may still be hit
+        Shape hit(this, (SlotMap::Handle)shape->getUserIndex());
+        if (hit.IsValid())
+            result.push_back({ hit, position });
     }
 
     return result;
@@ -379,11 +694,8 @@ std::vector<std::tuple<Scene::Shape, glm::vec3>> Scene::RayCast(const glm::vec3
 
 void Scene::Clear()
 {
-    m_bodies.clear();
-    m_shapes.clear();
-}
+    while (m_bodies.slots.GetSize())
+        RemoveBody(Body(this, m_bodies.slots.GetHandle(m_bodies.slots.GetSize() - 1)));
 
-bool Scene::BodyData::operator<(const BodyData & o) const
-{
-    return body < o.body;
+    InvalidateCasters();
 }
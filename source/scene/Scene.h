@@ -1,58 +1,88 @@
 #pragma once
 #include <memory>
-#include <map>
-#include <set>
+#include <vector>
 #include "Bullet.h"
 #include "Shapes.h"
+#include "SlotMap.h"
 #include "model/ModelShader.h"
+#include "utils/Frustum.h"
+#include "RenderQueue.h"
+#include <optional>
 
 class Scene
 {
-    struct ShapeData;
-    struct BodyData;
 public:
     Scene(const Light::Config & light);
-    // desctructor must be implemented  where SceneShapeHandle is defined
     ~Scene();
 
     static const uint32_t ShapeFlagNoDraw = 0x0001;
 
-    struct BodyHandle;
-    struct ShapeHandle
+    // Handles are generational ids into storage of scene, default one is null. Calls through handle
+    // of removed shape or body throw. References returned point into arrays of scene, they are
+    // valid until shapes are added or removed.
+    class BodyHandle;
+    class ShapeHandle
     {
         friend class Scene;
-
-        glm::vec3 GetPosition();
-        glm::vec3 GetRotation();
-        glm::vec3 GetScale();
-        Shapes::Type GetType();
-        BodyHandle * GetBody();
-        uint32_t & GetFlags();
-        const glm::mat4& GetTransform();
-        Material::Data& GetMaterial();
+    public:
+        ShapeHandle() = default;
+
+        glm::vec3 GetPosition() const;
+        glm::vec3 GetRotation() const;
+        glm::vec3 GetScale() const;
+        Shapes::Type GetType() const;
+        BodyHandle GetBody() const;
+        uint32_t & GetFlags() const;
+        const glm::mat4& GetTransform() const;
+        Material::Data& GetMaterial() const;
+
+        // shape was not removed
+        bool IsValid() const;
+        explicit operator bool() const;
+        bool operator==(const ShapeHandle & o) const;
+        bool operator!=(const ShapeHandle & o) const;
+        bool operator<(const ShapeHandle & o) const;
 
     private:
-        std::multimap<Shapes::Shape*, ShapeData>::iterator it;
+        ShapeHandle(Scene * scene, SlotMap::Handle handle);
+        uint32_t GetIndex() const;
+
+        Scene * m_scene = nullptr;
+        SlotMap::Handle m_handle = SlotMap::INVALID;
     };
-    using Shape = ShapeHandle*;
+    using Shape = ShapeHandle;
 
-    struct BodyHandle
+    class BodyHandle
     {
         friend class Scene;
+    public:
+        BodyHandle() = default;
+
+        glm::vec3 GetPosition() const;
+        void SetPosition(const glm::vec3& position) const;
+
+        glm::vec3 GetRotation() const;
+        void SetRotation(const glm::vec3& rotation) const;
 
-        glm::vec3 GetPosition();
-        void SetPosition(const glm::vec3& position);
+        bool IsStatic() const;
+        bool IsCompound() const;
+        const std::vector<Shape> & GetShapes() const;
 
-        glm::vec3 GetRotation();
-        void SetRotation(const glm::vec3& rotation);
+        // body was not removed
+        bool IsValid() const;
+        explicit operator bool() const;
+        bool operator==(const BodyHandle & o) const;
+        bool operator!=(const BodyHandle & o) const;
+        bool operator<(const BodyHandle & o) const;
 
-        bool IsStatic();
-        bool IsCompound();
-        const std::vector<Shape> & GetShapes();
     private:
-        std::set<BodyData>::iterator it;
+        BodyHandle(Scene * scene, SlotMap::Handle handle);
+        uint32_t GetIndex() const;
+
+        Scene * m_scene = nullptr;
+        SlotMap::Handle m_handle = SlotMap::INVALID;
     };
-    using Body = BodyHandle*;
+    using Body = BodyHandle;
 
     Body AddCube(const Shapes::Defintion::Box & definition, const Material::Data & material, bool isStatic);
     Body AddSphere(const Shapes::Defintion::Sphere & definition, const Material::Data & material, bool isStatic);
@@ -67,50 +97,100 @@ public:
     Shape AddShape(Body compound, const T & definition, const Material::Data & material, uint32_t flags = 0);
     void RemoveBody(Body body);
 
-    void Step();
+    // advances physics by elapsed seconds, see Bullet::Step
+    void Step(float elapsed);
+    // threads stepping the physics world, see Bullet::SetThreadsCount
+    void SetPhysicsThreads(uint32_t count);
+    uint32_t GetPhysicsThreads() const;
+    uint32_t GetMaxPhysicsThreads() const;
+    // physics steps on its own thread and overlaps with rendering, changes of bodies are applied
+    // at step boundaries, see Bullet::StartThread
+    bool StartPhysicsThread();
+    void StopPhysicsThread();
+    bool IsPhysicsThreadRunning() const;
 
     void Draw(const glm::mat4 & view, const glm::mat4 & projection, const glm::vec3 & cameraPosition, const Light::Data & data);
     void DrawDebug(const glm::mat4 & view, const glm::mat4 & projection);
 
+    // counters of last Draw, culling of shadow passes included
+    struct Statistics
+    {
+        // bodies rejected by broadphase query are culled
+        Frustum::Statistics bodies;
+        // shapes of compound bodies tested one by one
+        Frustum::Statistics shapes;
+        // shapes drawn by material pass and all shapes of scene
+        uint32_t visible = 0;
+        uint32_t total = 0;
+    };
+    const Statistics & GetStatistics() const;
+
     using RayCastResult = std::tuple<Shape, glm::vec3>;
     std::vector<RayCastResult> RayCast(const glm::vec3 & position, const glm::vec3 & direction);
 
     void Clear();
 
 private:
-    std::unique_ptr<ModelShader> m_shader;
+    ModelShaderPtr m_shader;
 
-    struct ShapeData
+    // structure of arrays, element of each array by index of slot map
+    struct ShapeStorage
     {
-        glm::mat4 model;
-        glm::mat4 localTransform;
-        glm::vec3 scale;
-        Material::Data material;
-        BodyHandle * body;
-        btCollisionShape * shape;
-        std::unique_ptr<ShapeHandle> handle;
-        uint32_t flags = 0;
+        SlotMap slots;
+        std::vector<glm::mat4> model;
+        std::vector<glm::mat4> localTransform;
+        std::vector<glm::vec3> scale;
+        std::vector<Material::Data> material;
+        std::vector<uint32_t> flags;
+        std::vector<Shapes::Shape*> shape;
+        std::vector<btCollisionShape*> collisionShape;
+        std::vector<SlotMap::Handle> body;
     };
-    std::multimap<Shapes::Shape*, ShapeData> m_shapes;
+    ShapeStorage m_shapes;
 
-    struct BodyData
+    struct BodyStorage
     {
-        btRigidBody * body;
-        std::unique_ptr<BodyHandle> handle;
-        std::vector<ShapeHandle*> shapes;
-
-        bool operator<(const BodyData & o) const;
+        SlotMap slots;
+        std::vector<btRigidBody*> body;
+        std::vector<std::vector<Shape>> shapes;
     };
-    std::set<BodyData> m_bodies;
+    BodyStorage m_bodies;
+
+    // indices of shapes drawn by current pass, records of render queue index into it
+    std::vector<uint32_t> m_drawables;
+    RenderQueue m_queue;
+
+    // shapes of bodies found in broadphase of physics world, none means all shapes
+    void CollectDrawables(const std::optional<Frustum> & frustum);
+    std::vector<const btCollisionObject*> m_visibleObjects;
 
     enum class DrawType{ Shadow, Material };
-    void DrawShapes(DrawType drawType, const glm::mat4 & view, const glm::mat4 & projection);
+    // shapes are culled and sorted front to back by view projection, none means no culling (cube maps)
+    void DrawShapes(DrawType drawType, uint32_t pass, const glm::mat4 & view, const glm::mat4 & projection, const std::optional<glm::mat4> & viewProjection);
+    // sorted queue drawn with one instanced call per shape type
+    void DrawInstanced(const glm::mat4 & view, const glm::mat4 & projection);
+
+    // material pass is instanced when supported, shadow passes always draw shapes one by one
+    bool m_instanced = false;
+    GLuint m_instanceBuffer = 0;
+    std::vector<Instances::Data> m_instances;
+
+    Statistics m_statistics;
+
+    // revision of shadow casters, changed when drawn shape moves, is added or removed,
+    // shadow maps rendered with the same revision are kept
+    uint64_t m_casters;
+    void InvalidateCasters();
 
+    // only shapes of bodies listed as moved by the last step
     void RefreshShapeModels();
-    void RefreshShapeModel(ShapeData & cube);
+    // returns true when model matrix changed
+    bool RefreshShapeModel(uint32_t shape, const glm::mat4 & body);
 
-    Scene::Shape AddShape(btCollisionShape * shape, const glm::mat4 & local, const glm::vec3 & scale, BodyHandle * body, const Material::Data & material, Shapes::Shape * drawShape, uint32_t flags);
-    Scene::Body AddBody(btRigidBody * body);
+    Scene::Shape AddShape(btCollisionShape * shape, const glm::mat4 & local, const glm::vec3 & scale, Body body, const Material::Data & material, Shapes::Shape * drawShape, uint32_t flags);
+    // slot of body is taken before it is created, physics world knows bodies by handle
+    SlotMap::Handle ReserveBody();
+    Scene::Body AddBody(SlotMap::Handle handle, btRigidBody * body);
 
     std::unique_ptr<Shapes::Cube> m_cube;
     std::unique_ptr<Shapes::Sphere> m_sphere;
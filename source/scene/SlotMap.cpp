@@ -0,0 +1,99 @@
+#include "SlotMap.h"
+#include <stdexcept>
+#include <cstdio>
+
+static const uint32_t SLOT_BITS = 20;
+static const uint32_t SLOT_MASK = (1u << SLOT_BITS) - 1;
+static const uint32_t GENERATION_MASK = (1u << (32 - SLOT_BITS)) - 1;
+
+static SlotMap::Handle MakeHandle(uint32_t slot, uint16_t generation)
+{
+    return (uint32_t(generation) << SLOT_BITS) | slot;
+}
+
+SlotMap::Handle SlotMap::Add()
+{
+    uint32_t slot;
+    if (!m_free.empty())
+    {
+        slot = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        if (m_indices.size() > SLOT_MASK)
+        {
+            printf("SlotMap is full, %u elements\n", SLOT_MASK + 1);
+            throw std::runtime_error("SlotMap is full");
+        }
+
+        slot = (uint32_t)m_indices.size();
+        m_indices.push_back(0);
+        m_generations.push_back(1);
+    }
+
+    m_indices[slot] = (uint32_t)m_slots.size();
+    m_slots.push_back(slot);
+
+    return MakeHandle(slot, m_generations[slot]);
+}
+
+uint32_t SlotMap::Remove(Handle handle)
+{
+    uint32_t index = GetIndex(handle);
+    uint32_t slot = handle & SLOT_MASK;
+
+    // the last element takes place of removed one
+    m_slots[index] = m_slots.back();
+    m_indices[m_slots[index]] = index;
+    m_slots.pop_back();
+
+    // handles of removed element get stale
+    m_generations[slot] = uint16_t(m_generations[slot] % GENERATION_MASK + 1);
+    m_free.push_back(slot);
+
+    return index;
+}
+
+void SlotMap::Clear()
+{
+    // slots are reused with new generations, so handles of cleared elements stay stale
+    while (!m_slots.empty())
+        Remove(GetHandle((uint32_t)m_slots.size() - 1));
+}
+
+std::optional<uint32_t> SlotMap::Find(Handle handle) const
+{
+    uint32_t slot = handle & SLOT_MASK;
+    if (slot >= m_generations.size() || m_generations[slot] != handle >> SLOT_BITS)
+        return std::nullopt;
+
+    uint32_t index = m_indices[slot];
+    if (index >= m_slots.size() || m_slots[index] != slot)
+        return std::nullopt;
+
+    return index;
+}
+
+uint32_t SlotMap::GetIndex(Handle handle) const
+{
+    std::optional<uint32_t> index = Find(handle);
+    if (!index)
+    {
+        printf("SlotMap stale handle 0x%08x\n", handle);
+        throw std::runtime_error("SlotMap stale handle");
+    }
+
+    return *index;
+}
+
+SlotMap::Handle SlotMap::GetHandle(uint32_t index) const
+{
+    uint32_t slot = m_slots[index];
+    return MakeHandle(slot, m_generations[slot]);
+}
+
+uint32_t SlotMap::GetSize() const
+{
+    return (uint32_t)m_slots.size();
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include <optional>
+#include <utility>
+#include <cstdint>
+
+// Generational handles of elements packed densely in parallel arrays of the owner.
+// Elements are added at the end of arrays, removed one is replaced by the last one, so handles
+// stay valid while indices move. Handle of removed element is stale until generation of its slot wraps.
+// Handle from the most significant bits:
+//      generation 12 bits, never 0 so zero handle is invalid
+//      slot       20 bits
+class SlotMap
+{
+public:
+    using Handle = uint32_t;
+    static const Handle INVALID = 0;
+
+    // index of the new element is the previous size
+    Handle Add();
+    // returns index the last element is moved to, see Erase
+    uint32_t Remove(Handle handle);
+    void Clear();
+
+    // none for stale handle
+    std::optional<uint32_t> Find(Handle handle) const;
+    // throws for stale handle
+    uint32_t GetIndex(Handle handle) const;
+    Handle GetHandle(uint32_t index) const;
+    uint32_t GetSize() const;
+
+    // moves the last element of each array to index of removed one
+    template<class ... T>
+    static void Erase(uint32_t index, std::vector<T> & ... arrays);
+
+private:
+    std::vector<uint32_t> m_indices;
+    std::vector<uint16_t> m_generations;
+    // slot of element by index
+    std::vector<uint32_t> m_slots;
+    std::vector<uint32_t> m_free;
+};
+
+template<class ... T>
+void SlotMap::Erase(uint32_t index, std::vector<T> & ... arrays)
+{
+    auto erase = [index](auto & array)
+    {
+        if (index + 1 != array.size())
+            array[index] = std::move(array.back());
+        array.pop_back();
+    };
+
+    (erase(arrays), ...);
+}
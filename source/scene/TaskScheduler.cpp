@@ -0,0 +1,210 @@
+#include "TaskScheduler.h"
+#include <algorithm>
+
+TaskScheduler::TaskScheduler()
+    : btITaskScheduler("TaskScheduler")
+{
+    // Bullet indexes its per thread data by order in which threads ask for index,
+    // creating thread is 0 and workers are registered one by one to follow it
+    btGetCurrentThreadIndex();
+
+    uint32_t count = std::min<uint32_t>(std::max(std::thread::hardware_concurrency(), 1u), BT_MAX_THREAD_COUNT);
+    m_queues = std::vector<Queue>(count);
+    m_threads = count;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (uint32_t i = 1; i < count; ++i)
+    {
+        m_workers.emplace_back(&TaskScheduler::Worker, this, i);
+        m_condition.wait(lock, [this, i] { return m_registered == i; });
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    if (btGetTaskScheduler() == this)
+        btSetTaskScheduler(btGetSequentialTaskScheduler());
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+
+    for (auto & worker : m_workers)
+        worker.join();
+}
+
+TaskScheduler & TaskScheduler::Instance()
+{
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+int TaskScheduler::getMaxNumThreads() const
+{
+    return (int)m_queues.size();
+}
+
+int TaskScheduler::getNumThreads() const
+{
+    return (int)m_threads;
+}
+
+void TaskScheduler::setNumThreads(int numThreads)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threads = (uint32_t)std::clamp(numThreads, 1, getMaxNumThreads());
+}
+
+void TaskScheduler::parallelFor(int begin, int end, int grainSize, const btIParallelForBody & body)
+{
+    Run({ begin, end, grainSize, &body, nullptr });
+}
+
+btScalar TaskScheduler::parallelSum(int begin, int end, int grainSize, const btIParallelSumBody & body)
+{
+    Run({ begin, end, grainSize, nullptr, &body });
+
+    btScalar sum = 0;
+    for (uint32_t i = 0; i < m_threads; ++i)
+        sum += m_queues[i].sum;
+
+    return sum;
+}
+
+void TaskScheduler::Run(const Loop & loop)
+{
+    int grainSize = std::max(loop.grainSize, 1);
+    int chunks = (loop.end - loop.begin + grainSize - 1) / grainSize;
+    if (chunks <= 0)
+        return;
+
+    m_loop = loop;
+    m_loop.grainSize = grainSize;
+
+    // workers wait for next loop, so threads count can't change meanwhile
+    uint32_t threads = std::min<uint32_t>(m_threads, (uint32_t)chunks);
+    for (uint32_t i = 0; i < m_threads; ++i)
+    {
+        std::lock_guard<std::mutex> lock(m_queues[i].mutex);
+        m_queues[i].next = i < threads ? int(int64_t(chunks) * i / threads) : 0;
+        m_queues[i].end = i < threads ? int(int64_t(chunks) * (i + 1) / threads) : 0;
+        m_queues[i].sum = 0;
+    }
+    m_remaining = chunks;
+
+    if (threads > 1)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = true;
+            m_generation++;
+        }
+        m_condition.notify_all();
+    }
+
+    Work(0);
+
+    // chunks claimed by others are still running
+    while (m_remaining.load() != 0)
+        std::this_thread::yield();
+
+    if (threads > 1)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+
+        // late workers found no chunks, loop data must stay valid until they leave
+        while (m_working.load() != 0)
+            std::this_thread::yield();
+    }
+}
+
+void TaskScheduler::Worker(uint32_t thread)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    btGetCurrentThreadIndex();
+    m_registered = thread;
+    m_condition.notify_all();
+
+    uint64_t generation = m_generation;
+
+    while (true)
+    {
+        m_condition.wait(lock, [this, thread, &generation] { return m_stop || (m_running && m_generation != generation && thread < m_threads); });
+        if (m_stop)
+            return;
+
+        generation = m_generation;
+        m_working++;
+
+        lock.unlock();
+        Work(thread);
+        lock.lock();
+
+        m_working--;
+    }
+}
+
+void TaskScheduler::Work(uint32_t thread)
+{
+    int chunk;
+    while (Claim(thread, chunk))
+    {
+        int begin = m_loop.begin + chunk * m_loop.grainSize;
+        int end = std::min(m_loop.end, begin + m_loop.grainSize);
+
+        if (m_loop.forBody)
+            m_loop.forBody->forLoop(begin, end);
+        else
+            m_queues[thread].sum += m_loop.sumBody->sumLoop(begin, end);
+
+        m_remaining--;
+    }
+}
+
+bool TaskScheduler::Claim(uint32_t thread, int & chunk)
+{
+    Queue & own = m_queues[thread];
+    {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.next < own.end)
+        {
+            chunk = own.next++;
+            return true;
+        }
+    }
+
+    // only the owner adds chunks to its queue, so it stays empty while stealing
+    for (uint32_t i = 1; i < m_threads; ++i)
+    {
+        Queue & victim = m_queues[(thread + i) % m_threads];
+
+        int begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            int count = victim.end - victim.next;
+            if (count <= 0)
+                continue;
+
+            // half from the back, owner keeps working from the front
+            end = victim.end;
+            begin = end - (count + 1) / 2;
+            victim.end = begin;
+        }
+
+        chunk = begin;
+
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.next = begin + 1;
+        own.end = end;
+
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <LinearMath/btThreads.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+// Work-stealing thread pool running parallel loops of Bullet (see btSetTaskScheduler).
+// Range of loop is split to chunks of grain size dealt evenly to queues of active threads,
+// thread with empty queue steals half of chunks left in queue of another one.
+// Calling thread works on loop as well and returns once all chunks are done.
+class TaskScheduler : public btITaskScheduler
+{
+public:
+    ~TaskScheduler();
+    // must be created by thread stepping the world, Bullet gives it thread index 0
+    static TaskScheduler & Instance();
+
+    // one thread per hardware thread is created, setNumThreads limits how many of them work
+    virtual int getMaxNumThreads() const override;
+    virtual int getNumThreads() const override;
+    virtual void setNumThreads(int numThreads) override;
+
+    virtual void parallelFor(int begin, int end, int grainSize, const btIParallelForBody & body) override;
+    virtual btScalar parallelSum(int begin, int end, int grainSize, const btIParallelSumBody & body) override;
+
+private:
+    TaskScheduler();
+
+    struct Loop
+    {
+        int begin;
+        int end;
+        int grainSize;
+        // one of them is set
+        const btIParallelForBody * forBody;
+        const btIParallelSumBody * sumBody;
+    };
+    void Run(const Loop & loop);
+
+    struct Queue
+    {
+        std::mutex mutex;
+        // chunks not claimed yet
+        int next = 0;
+        int end = 0;
+        btScalar sum = 0;
+    };
+
+    void Worker(uint32_t thread);
+    // runs chunks of own queue, then stolen ones, until there are none
+    void Work(uint32_t thread);
+    bool Claim(uint32_t thread, int & chunk);
+
+    std::vector<std::thread> m_workers;
+    std::vector<Queue> m_queues;
+
+    Loop m_loop;
+    std::atomic<int> m_remaining{ 0 };
+    // workers inside Work, loop is not finished until they leave
+    std::atomic<int> m_working{ 0 };
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    // guarded by m_mutex
+    uint64_t m_generation = 0;
+    bool m_running = false;
+    bool m_stop = false;
+    uint32_t m_threads;
+    uint32_t m_registered = 0;
+};
@@ -2,6 +2,7 @@
 #include "Common.h"
 #include "OpenGL.h"
 #include "Texture.h"
+#include "GLState.h"
 #include "EventDispatchers.h"
 
 #include "Application.h" // resize dispatcher
@@ -79,11 +80,11 @@ void Framebuffer::Init()
 
 void Framebuffer::Deinit()
 {
-    glDeleteTextures(1, &m_texture);
+    GLState::Instance().DeleteTexture(m_texture);
     glDeleteFramebuffers(1, &m_framebuffer);
     if (m_samples)
     {
-        glDeleteTextures(1, &m_multisampleTexture);
+        GLState::Instance().DeleteTexture(m_multisampleTexture);
         glDeleteFramebuffers(1, &m_multisampleFramebuffer);
     }
 }
@@ -131,7 +132,7 @@ std::tuple<GLuint, GLuint> Framebuffer::GenerateFramebuffer(uint32_t width, uint
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    GLState::Instance().BindTexture(GL_TEXTURE_2D, texture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -170,7 +171,7 @@ std::tuple<GLuint, GLuint> Framebuffer::GenerateFramebuffer(uint32_t width, uint
     }
 
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::Instance().BindTexture(GL_TEXTURE_2D, 0);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     return { framebuffer, texture };
@@ -185,7 +186,7 @@ std::tuple<GLuint, GLuint> Framebuffer::GenerateMultisampleFramebuffer(uint32_t
     glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, texture);
+    GLState::Instance().BindTexture(GL_TEXTURE_2D_MULTISAMPLE, texture);
     glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, GL_RGBA, width, height, GL_TRUE);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -224,7 +225,7 @@ std::tuple<GLuint, GLuint> Framebuffer::GenerateMultisampleFramebuffer(uint32_t
     }
 
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::Instance().BindTexture(GL_TEXTURE_2D, 0);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     return { framebuffer, texture };
@@ -241,7 +242,7 @@ FramebufferDepth::FramebufferDepth(uint32_t width, uint32_t height)
 
     // prepare depth texture
     glGenTextures(1, &m_texture);
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+    GLState::Instance().BindTexture(GL_TEXTURE_2D, m_texture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT, GetOverridenDataTypeOfPixel(GL_FLOAT), NULL);
     CheckGlError("glTexImage2D");
 
@@ -255,7 +256,7 @@ FramebufferDepth::FramebufferDepth(uint32_t width, uint32_t height)
     glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, BORDER_COLOR);
 #endif
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::Instance().BindTexture(GL_TEXTURE_2D, 0);
 
     // attach depth texture as FBO's depth buffer
     glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
@@ -291,7 +292,7 @@ FramebufferDepth::FramebufferDepth(uint32_t width, uint32_t height)
 
 FramebufferDepth::~FramebufferDepth()
 {
-    glDeleteTextures(1, &m_texture);
+    GLState::Instance().DeleteTexture(m_texture);
     glDeleteFramebuffers(1, &m_framebuffer);
 }
 
@@ -321,7 +322,7 @@ FramebufferDepthCube::FramebufferDepthCube(uint32_t width, uint32_t height)
 
     // prepare depth texture
     glGenTextures(1, &m_texture);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_texture);
+    GLState::Instance().BindTexture(GL_TEXTURE_CUBE_MAP, m_texture);
 
     for (uint32_t i = 0; i < 6; ++i)
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT, GetOverridenDataTypeOfPixel(GL_FLOAT), NULL);
@@ -341,7 +342,7 @@ FramebufferDepthCube::FramebufferDepthCube(uint32_t width, uint32_t height)
 
 FramebufferDepthCube::~FramebufferDepthCube()
 {
-    glDeleteTextures(1, &m_texture);
+    GLState::Instance().DeleteTexture(m_texture);
     glDeleteFramebuffers(1, &m_framebuffer);
 }
 
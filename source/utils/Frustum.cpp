@@ -0,0 +1,78 @@
+#include "Frustum.h"
+#include <algorithm>
+#include <cmath>
+
+Frustum::Frustum(const glm::mat4 & matrix)
+{
+    // rows of matrix, glm is column major
+    glm::vec4 rows[4];
+    for (int32_t i = 0; i < 4; ++i)
+        rows[i] = glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+
+    // left, right, bottom, top, near, far
+    for (int32_t i = 0; i < 3; ++i)
+    {
+        m_planes[i * 2] = rows[3] + rows[i];
+        m_planes[i * 2 + 1] = rows[3] - rows[i];
+    }
+
+    for (glm::vec4 & plane : m_planes)
+        plane /= glm::length(glm::vec3(plane));
+}
+
+bool Frustum::IsSphereVisible(const glm::vec3 & center, float radius) const
+{
+    for (const glm::vec4 & plane : m_planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+
+    return true;
+}
+
+bool Frustum::IsBoxVisible(const glm::vec3 & lower, const glm::vec3 & upper) const
+{
+    for (const glm::vec4 & plane : m_planes)
+    {
+        // corner of box farthest along plane normal
+        glm::vec3 corner(plane.x >= 0.0f ? upper.x : lower.x,
+            plane.y >= 0.0f ? upper.y : lower.y,
+            plane.z >= 0.0f ? upper.z : lower.z);
+
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+bool Frustum::IsSphereVisible(const glm::vec3 & center, float radius, const glm::mat4 & model) const
+{
+    return IsSphereVisible(glm::vec3(model * glm::vec4(center, 1.0f)), radius * GetMaxScale(model));
+}
+
+bool Frustum::IsBoxVisible(const glm::vec3 & lower, const glm::vec3 & upper, const glm::mat4 & model) const
+{
+    // box enclosing transformed box (Arvo, Transforming Axis-Aligned Bounding Boxes)
+    glm::vec3 center = glm::vec3(model * glm::vec4((lower + upper) * 0.5f, 1.0f));
+    glm::vec3 extents = (upper - lower) * 0.5f;
+    glm::vec3 transformed(0.0f);
+
+    for (int32_t i = 0; i < 3; ++i)
+        transformed += glm::abs(glm::vec3(model[i])) * extents[i];
+
+    return IsBoxVisible(center - transformed, center + transformed);
+}
+
+const std::array<glm::vec4, 6> & Frustum::GetPlanes() const
+{
+    return m_planes;
+}
+
+float GetMaxScale(const glm::mat4 & model)
+{
+    return std::sqrt(std::max({ glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+        glm::dot(glm::vec3(model[1]), glm::vec3(model[1])),
+        glm::dot(glm::vec3(model[2]), glm::vec3(model[2])) }));
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "glm/glm.hpp"
+#include <array>
+#include <cstdint>
+
+// Planes of view frustum extracted from view-projection matrix (Gribb & Hartmann),
+// tests are conservative, object may be reported visible while it's not.
+class Frustum
+{
+public:
+    // matrix transforming from space of tested objects to clip space
+    explicit Frustum(const glm::mat4 & matrix);
+
+    bool IsSphereVisible(const glm::vec3 & center, float radius) const;
+    bool IsBoxVisible(const glm::vec3 & lower, const glm::vec3 & upper) const;
+
+    // objects in model space, transformed by model matrix first
+    bool IsSphereVisible(const glm::vec3 & center, float radius, const glm::mat4 & model) const;
+    bool IsBoxVisible(const glm::vec3 & lower, const glm::vec3 & upper, const glm::mat4 & model) const;
+
+    // left, right, bottom, top, near, far
+    const std::array<glm::vec4, 6> & GetPlanes() const;
+
+    // counters of culling tests, reset every frame by owner
+    struct Statistics
+    {
+        uint32_t tested = 0;
+        uint32_t culled = 0;
+    };
+
+private:
+    // xyz normal pointing inside, w distance
+    std::array<glm::vec4, 6> m_planes;
+};
+
+// maximal scale of model matrix axes, for transforming radius
+float GetMaxScale(const glm::mat4 & model);
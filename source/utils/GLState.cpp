@@ -0,0 +1,231 @@
+#include "GLState.h"
+
+GLState & GLState::Instance()
+{
+    static GLState instance;
+
+    return instance;
+}
+
+template<class T>
+bool GLState::Change(std::optional<T> & current, const T & value)
+{
+    if (current && *current == value)
+    {
+        m_current.elided++;
+        return false;
+    }
+
+    current = value;
+    m_current.issued++;
+    return true;
+}
+
+void GLState::UseProgram(GLuint program)
+{
+    if (!Change(m_program, program))
+        return;
+
+    glUseProgram(program);
+    CheckGlError("glUseProgram");
+}
+
+void GLState::BindVertexArray(GLuint vao)
+{
+    if (!Change(m_vao, vao))
+        return;
+
+    glBindVertexArray(vao);
+    CheckGlError("glBindVertexArray");
+
+    m_elementBuffer.reset();
+}
+
+void GLState::BindBuffer(GLenum target, GLuint buffer)
+{
+    std::optional<GLuint> * current = nullptr;
+    if (target == GL_ARRAY_BUFFER)
+        current = &m_arrayBuffer;
+    else if (target == GL_ELEMENT_ARRAY_BUFFER)
+        current = &m_elementBuffer;
+
+    if (current && !Change(*current, buffer))
+        return;
+    if (!current)
+        m_current.issued++;
+
+    glBindBuffer(target, buffer);
+    CheckGlError("glBindBuffer");
+}
+
+void GLState::ActiveTexture(GLuint unit)
+{
+    if (!Change(m_activeUnit, unit))
+        return;
+
+    glActiveTexture(GL_TEXTURE0 + unit);
+    CheckGlError("glActiveTexture");
+}
+
+void GLState::BindTexture(GLenum target, GLuint texture)
+{
+    std::optional<GLuint> * current = nullptr;
+    if (m_activeUnit && *m_activeUnit < MAX_TEXTURE_UNITS)
+    {
+        if (target == GL_TEXTURE_2D)
+            current = &m_textures[*m_activeUnit][Texture2D];
+        else if (target == GL_TEXTURE_CUBE_MAP)
+            current = &m_textures[*m_activeUnit][TextureCube];
+    }
+
+    if (current && !Change(*current, texture))
+        return;
+    if (!current)
+        m_current.issued++;
+
+    glBindTexture(target, texture);
+    CheckGlError("glBindTexture");
+}
+
+void GLState::SetEnabled(GLenum capability, bool enabled)
+{
+    std::optional<bool> * current = nullptr;
+    if (capability == GL_BLEND)
+        current = &m_capabilities[CapabilityBlend];
+    else if (capability == GL_DEPTH_TEST)
+        current = &m_capabilities[CapabilityDepthTest];
+    else if (capability == GL_CULL_FACE)
+        current = &m_capabilities[CapabilityCullFace];
+
+    if (current && !Change(*current, enabled))
+        return;
+    if (!current)
+        m_current.issued++;
+
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+void GLState::BlendFunc(GLenum source, GLenum destination)
+{
+    if (!Change(m_blendFunc, { source, destination, source, destination }))
+        return;
+
+    glBlendFunc(source, destination);
+}
+
+void GLState::BlendFuncSeparate(GLenum sourceColor, GLenum destinationColor, GLenum sourceAlpha, GLenum destinationAlpha)
+{
+    if (!Change(m_blendFunc, { sourceColor, destinationColor, sourceAlpha, destinationAlpha }))
+        return;
+
+    glBlendFuncSeparate(sourceColor, destinationColor, sourceAlpha, destinationAlpha);
+}
+
+void GLState::DepthFunc(GLenum function)
+{
+    if (!Change(m_depthFunc, function))
+        return;
+
+    glDepthFunc(function);
+}
+
+void GLState::CullFace(GLenum mode)
+{
+    if (!Change(m_cullFace, mode))
+        return;
+
+    glCullFace(mode);
+}
+
+void GLState::DeleteProgram(GLuint program)
+{
+    glDeleteProgram(program);
+
+    // program in use is deleted once it's not used anymore
+    if (m_program == program)
+        m_program.reset();
+}
+
+void GLState::DeleteVertexArray(GLuint vao)
+{
+    glDeleteVertexArrays(1, &vao);
+
+    if (m_vao == vao)
+    {
+        m_vao = 0;
+        m_elementBuffer.reset();
+    }
+}
+
+void GLState::DeleteBuffer(GLuint buffer)
+{
+    glDeleteBuffers(1, &buffer);
+
+    if (m_arrayBuffer == buffer)
+        m_arrayBuffer = 0;
+    if (m_elementBuffer == buffer)
+        m_elementBuffer = 0;
+}
+
+void GLState::DeleteTexture(GLuint texture)
+{
+    glDeleteTextures(1, &texture);
+
+    for (auto & unit : m_textures)
+    {
+        for (auto & bound : unit)
+        {
+            if (bound == texture)
+                bound = 0;
+        }
+    }
+}
+
+void GLState::Reset()
+{
+    UseProgram(0);
+    if (IsVAOSupported())
+        BindVertexArray(0);
+    BindBuffer(GL_ARRAY_BUFFER, 0);
+    BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    ActiveTexture(0);
+}
+
+void GLState::Invalidate()
+{
+    m_program.reset();
+    m_vao.reset();
+    m_arrayBuffer.reset();
+    m_elementBuffer.reset();
+
+    m_activeUnit.reset();
+    for (auto & unit : m_textures)
+        unit.fill(std::nullopt);
+
+    m_capabilities.fill(std::nullopt);
+    m_blendFunc.reset();
+    m_depthFunc.reset();
+    m_cullFace.reset();
+}
+
+void GLState::BeginFrame()
+{
+    m_previous = m_current;
+    m_current = {};
+}
+
+void GLState::CountUniform(bool issued)
+{
+    if (issued)
+        m_current.uniformsIssued++;
+    else
+        m_current.uniformsElided++;
+}
+
+const GLState::Statistics & GLState::GetStatistics() const
+{
+    return m_previous;
+}
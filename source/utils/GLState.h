@@ -0,0 +1,81 @@
+#pragma once
+#include "OpenGL.h"
+#include <array>
+#include <optional>
+#include <cstdint>
+
+// Shadow copy of OpenGL state, changes to the value which is already set are not issued.
+// State changed by direct gl calls is not seen, such code has to restore it (imgui does)
+// or call Invalidate.
+class GLState
+{
+public:
+    struct Statistics
+    {
+        uint32_t issued = 0;
+        uint32_t elided = 0;
+        // uniform values are cached per program by Shader
+        uint32_t uniformsIssued = 0;
+        uint32_t uniformsElided = 0;
+    };
+
+    static GLState & Instance();
+
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vao);
+    // element array buffer is part of vao state, it is unknown after vao is changed
+    void BindBuffer(GLenum target, GLuint buffer);
+
+    void ActiveTexture(GLuint unit);
+    // binds to active texture unit
+    void BindTexture(GLenum target, GLuint texture);
+
+    // GL_BLEND, GL_DEPTH_TEST and GL_CULL_FACE are tracked, other capabilities are always issued
+    void SetEnabled(GLenum capability, bool enabled);
+    void BlendFunc(GLenum source, GLenum destination);
+    void BlendFuncSeparate(GLenum sourceColor, GLenum destinationColor, GLenum sourceAlpha, GLenum destinationAlpha);
+    void DepthFunc(GLenum function);
+    void CullFace(GLenum mode);
+
+    // deleted objects are unbound by OpenGL and their names may be reused
+    void DeleteProgram(GLuint program);
+    void DeleteVertexArray(GLuint vao);
+    void DeleteBuffer(GLuint buffer);
+    void DeleteTexture(GLuint texture);
+
+    // binds default program, vao, buffers and texture unit for code which doesn't use this class
+    void Reset();
+    // forgets all values, next change of each state is issued
+    void Invalidate();
+
+    // counters of previous frame are kept for GetStatistics
+    void BeginFrame();
+    void CountUniform(bool issued);
+    const Statistics & GetStatistics() const;
+
+private:
+    // true when value differs from shadow copy, which is updated
+    template<class T>
+    bool Change(std::optional<T> & current, const T & value);
+
+    static const GLuint MAX_TEXTURE_UNITS = 32;
+    enum TextureTarget { Texture2D, TextureCube, TextureTargetsCount };
+    enum Capability { CapabilityBlend, CapabilityDepthTest, CapabilityCullFace, CapabilitiesCount };
+
+    std::optional<GLuint> m_program;
+    std::optional<GLuint> m_vao;
+    std::optional<GLuint> m_arrayBuffer;
+    std::optional<GLuint> m_elementBuffer;
+
+    std::optional<GLuint> m_activeUnit;
+    std::array<std::array<std::optional<GLuint>, TextureTargetsCount>, MAX_TEXTURE_UNITS> m_textures;
+
+    std::array<std::optional<bool>, CapabilitiesCount> m_capabilities;
+    // source and destination of color, then of alpha
+    std::optional<std::array<GLenum, 4>> m_blendFunc;
+    std::optional<GLenum> m_depthFunc;
+    std::optional<GLenum> m_cullFace;
+
+    Statistics m_current;
+    Statistics m_previous;
+};
@@ -1,6 +1,7 @@
 #include "Postprocess.h"
 #include "OpenGL.h"
 #include "Common.h"
+#include "GLState.h"
 
 // vertex attributes for a quad that fills the entire screen in Normalized Device Coordinates.
 static const float SCREEN_VERTICES[] =
@@ -83,11 +84,11 @@ void Postprocess::InitBuffers()
     if (IsVAOSupported())
     {
         glGenVertexArrays(1, &m_vao);
-        glBindVertexArray(m_vao);
+        GLState::Instance().BindVertexArray(m_vao);
     }
 
     glGenBuffers(1, &m_vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_vbo);
 
     glBufferData(GL_ARRAY_BUFFER, sizeof(SCREEN_VERTICES), &SCREEN_VERTICES, GL_STATIC_DRAW);
 
@@ -99,10 +100,10 @@ void Postprocess::InitBuffers()
         glEnableVertexAttribArray(m_locationVertexUV);
         glVertexAttribPointer(m_locationVertexUV, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
 
-        glBindVertexArray(0);
+        GLState::Instance().BindVertexArray(0);
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void Postprocess::Draw()
@@ -0,0 +1,156 @@
+#include "ProgramCache.h"
+#include "Common.h"
+#include <SDL.h>
+#include <vector>
+#include <cstring>
+#include <cinttypes>
+
+static const uint32_t MAGIC = 0x42475250; // "PRGB"
+
+struct Header
+{
+    uint32_t magic;
+    uint32_t format;
+};
+
+// FNV-1a
+static uint64_t Hash(std::string_view data, uint64_t hash = 14695981039346656037ull)
+{
+    for (char c : data)
+        hash = (hash ^ (uint8_t)c) * 1099511628211ull;
+
+    // terminator makes concatenated parts unambiguous
+    return (hash ^ 0xFF) * 1099511628211ull;
+}
+
+static std::string_view GetString(GLenum name)
+{
+    const GLubyte * value = glGetString(name);
+    return value ? (const char *)value : "";
+}
+
+ProgramCache & ProgramCache::Instance()
+{
+    static ProgramCache instance;
+
+    return instance;
+}
+
+ProgramCache::ProgramCache()
+{
+    if (!IsProgramBinarySupported())
+        return;
+
+    // created if it doesn't exist
+    char * path = SDL_GetPrefPath("SimpleSDL", "ProgramCache");
+    if (!path)
+    {
+        printf("Program cache disabled: %s\n", SDL_GetError());
+        return;
+    }
+    m_directory = path;
+    SDL_free(path);
+
+    m_driverHash = Hash(GetString(GL_VERSION), Hash(GetString(GL_RENDERER), Hash(GetString(GL_VENDOR))));
+    m_enabled = true;
+}
+
+uint64_t ProgramCache::GetKey(std::string_view vertex, std::optional<std::string_view> geometry, std::string_view fragment, const AttributeLocations & attributes) const
+{
+    uint64_t result = Hash(vertex, m_driverHash);
+    // no geometry shader differs from empty one
+    result = geometry ? Hash(*geometry, result) : Hash("", result ^ 1);
+    result = Hash(fragment, result);
+
+    for (const auto & [name, location] : attributes)
+        result = Hash(std::to_string(location), Hash(name, result));
+
+    return result;
+}
+
+std::string ProgramCache::GetPath(uint64_t key) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016" PRIx64 ".bin", key);
+    return m_directory + name;
+}
+
+std::optional<GLuint> ProgramCache::Load(uint64_t key)
+{
+    if (!m_enabled)
+        return std::nullopt;
+
+    // missing file is expected, common file functions would report it
+    std::string path = GetPath(key);
+    SDL_RWops * file = SDL_RWFromFile(path.c_str(), "rb");
+    if (!file)
+        return std::nullopt;
+
+    std::vector<uint8_t> data;
+    Sint64 size = SDL_RWsize(file);
+    if (size > (Sint64)sizeof(Header))
+    {
+        data.resize((size_t)size);
+        if (SDL_RWread(file, data.data(), 1, data.size()) != data.size())
+            data.clear();
+    }
+    SDL_RWclose(file);
+
+    Header header = {};
+    if (data.size() > sizeof(Header))
+        memcpy(&header, data.data(), sizeof(Header));
+    if (header.magic != MAGIC)
+    {
+        printf("Invalid cached program %s\n", path.c_str());
+        return std::nullopt;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, data.data() + sizeof(Header), (GLsizei)(data.size() - sizeof(Header)));
+
+    // binary is rejected after driver update or when format is not supported
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        printf("Cached program %s rejected, compiling\n", path.c_str());
+        glDeleteProgram(program);
+        // unknown format is reported as error, it's handled here
+        while (glGetError() != GL_NO_ERROR);
+        return std::nullopt;
+    }
+
+    return program;
+}
+
+void ProgramCache::SetRetrievable(GLuint program)
+{
+#if !defined(ANDROID)
+    // OpenGL ES returns binaries without hint
+    if (m_enabled && glProgramParameteri)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+}
+
+void ProgramCache::Store(uint64_t key, GLuint program)
+{
+    if (!m_enabled)
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<uint8_t> data(sizeof(Header) + length);
+    Header header = { MAGIC, 0 };
+    glGetProgramBinary(program, length, &length, &header.format, data.data() + sizeof(Header));
+    CheckGlError("glGetProgramBinary");
+
+    memcpy(data.data(), &header, sizeof(Header));
+    data.resize(sizeof(Header) + length);
+
+    std::string path = GetPath(key);
+    if (!Common::WriteFile(path.c_str(), data))
+        printf("Failed to store program %s\n", path.c_str());
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "OpenGL.h"
+#include "Shader.h"
+#include <optional>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// Linked programs stored on disk as driver binaries, keyed by hash of sources and driver identification.
+// Missing or rejected binary means the caller compiles program from sources and stores it.
+class ProgramCache
+{
+public:
+    static ProgramCache & Instance();
+
+    uint64_t GetKey(std::string_view vertex, std::optional<std::string_view> geometry, std::string_view fragment, const AttributeLocations & attributes) const;
+
+    // none when program is not cached or driver rejected the binary
+    std::optional<GLuint> Load(uint64_t key);
+    // must be called before linking, otherwise driver may not return the binary
+    void SetRetrievable(GLuint program);
+    void Store(uint64_t key, GLuint program);
+
+private:
+    ProgramCache();
+
+    std::string GetPath(uint64_t key) const;
+
+    // binary formats are supported and cache directory exists
+    bool m_enabled = false;
+    std::string m_directory;
+    // binaries are valid only for the same driver
+    uint64_t m_driverHash = 0;
+};
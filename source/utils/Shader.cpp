@@ -1,35 +1,45 @@
 #include "Shader.h"
 #include "Common.h"
+#include "GLState.h"
+#include "ProgramCache.h"
 #include <vector>
+#include <string_view>
+#include <cstring>
 
-std::optional<GLuint> CompileShader(const char * data, GLenum type)
+// source doesn't have to be null terminated, status is checked once program is linked
+GLuint CompileShader(std::string_view data, GLenum type)
 {
     GLuint result = glCreateShader(type);
 
-    glShaderSource(result, 1, &data, NULL);
+    const GLchar * source = data.data();
+    GLint length = (GLint)data.size();
+    glShaderSource(result, 1, &source, &length);
     glCompileShader(result);
 
-    //Check vertex shader for errors
+    return result;
+}
+
+// prints log of shader which failed to compile
+bool CheckShader(GLuint shader)
+{
     GLint shaderCompiled = GL_FALSE;
-    glGetShaderiv(result, GL_COMPILE_STATUS, &shaderCompiled);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &shaderCompiled);
     if (shaderCompiled != GL_TRUE)
     {
         GLint logLength;
-        glGetShaderiv(result, GL_INFO_LOG_LENGTH, &logLength);
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
         if (logLength > 0)
         {
             std::vector<GLchar> buffer(logLength);
-            glGetShaderInfoLog(result, logLength, &logLength, buffer.data());
+            glGetShaderInfoLog(shader, logLength, &logLength, buffer.data());
 
             printf("Shader compile log: %s\n", buffer.data());
         }
 
-        glDeleteShader(result);
-
-        return std::nullopt;
+        return false;
     }
 
-    return result;
+    return true;
 }
 
 void PrintProgramInfo(GLuint program)
@@ -46,72 +56,112 @@ void PrintProgramInfo(GLuint program)
     }
 }
 
-std::optional<GLuint> CreateAndLinkProgram(const char * vertexData, const char * geometryData, const char * fragmentData, std::function<void(GLuint)> bindCallback)
+// compiles and links without waiting for the driver, program loaded from cache is linked already
+ProgramLink SubmitProgram(std::string_view vertexData, std::optional<std::string_view> geometryData, std::string_view fragmentData, const AttributeLocations & attributes, std::function<void(GLuint)> bindCallback)
 {
-    std::optional<GLuint> vertexShader = CompileShader(vertexData, GL_VERTEX_SHADER);
-    std::optional<GLuint> geometryShader;
-    std::optional<GLuint> fragmentShader = CompileShader(fragmentData, GL_FRAGMENT_SHADER);
+    ProgramLink result;
 
-    if (!vertexShader || !fragmentShader)
-        return std::nullopt;
+    // locations bound by callback are not part of the key, such programs are always compiled
+    if (!bindCallback)
+    {
+        uint64_t key = ProgramCache::Instance().GetKey(vertexData, geometryData, fragmentData, attributes);
+        if (auto program = ProgramCache::Instance().Load(key))
+        {
+            result.program = *program;
+            return result;
+        }
+        result.cacheKey = key;
+    }
 
+    result.shaders.push_back(CompileShader(vertexData, GL_VERTEX_SHADER));
+    result.shaders.push_back(CompileShader(fragmentData, GL_FRAGMENT_SHADER));
     if (geometryData)
-        geometryShader = CompileShader(geometryData, GL_GEOMETRY_SHADER);
-
-    if (geometryData && !geometryShader)
-        return std::nullopt;
+        result.shaders.push_back(CompileShader(*geometryData, GL_GEOMETRY_SHADER));
 
     // Create program, attach shaders to it, and link it
-    GLuint program = glCreateProgram();
+    result.program = glCreateProgram();
 
-    glAttachShader(program, *vertexShader);
-    glAttachShader(program, *fragmentShader);
-    if (geometryShader)
-        glAttachShader(program, *geometryShader);
+    for (GLuint shader : result.shaders)
+        glAttachShader(result.program, shader);
 
     // bind locations before linking
+    for (const auto & [name, location] : attributes)
+        glBindAttribLocation(result.program, location, name.c_str());
     if (bindCallback)
-        bindCallback(program);
+        bindCallback(result.program);
+
+    if (result.cacheKey)
+        ProgramCache::Instance().SetRetrievable(result.program);
 
-    glLinkProgram(program);
+    glLinkProgram(result.program);
+
+    return result;
+}
 
+// waits for the driver when link is not finished yet
+std::optional<GLuint> FinishProgram(const ProgramLink & link)
+{
     GLint linked;
-    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    glGetProgramiv(link.program, GL_LINK_STATUS, &linked);
+
+    for (GLuint shader : link.shaders)
+    {
+        if (!linked)
+            CheckShader(shader);
+
+        glDetachShader(link.program, shader);
+        // Delete the shaders as the program has them now
+        glDeleteShader(shader);
+    }
+
     if (!linked)
     {
-        PrintProgramInfo(program);
+        PrintProgramInfo(link.program);
+        glDeleteProgram(link.program);
 
         return std::nullopt;
     }
 
-    glDetachShader(program, *vertexShader);
-    glDetachShader(program, *fragmentShader);
+    if (link.cacheKey)
+        ProgramCache::Instance().Store(*link.cacheKey, link.program);
 
-    // Delete the shaders as the program has them now
-    glDeleteShader(*vertexShader);
-    glDeleteShader(*fragmentShader);
+    return link.program;
+}
+
+std::optional<GLuint> CreateAndLinkProgramInternal(std::string_view vertexData, std::optional<std::string_view> geometryData, std::string_view fragmentData, std::function<void(GLuint)> bindCallback)
+{
+    return FinishProgram(SubmitProgram(vertexData, geometryData, fragmentData, {}, bindCallback));
+}
+
+std::optional<GLuint> CreateAndLinkProgram(const char * vertexData, const char * geometryData, const char * fragmentData, std::function<void(GLuint)> bindCallback)
+{
+    std::optional<std::string_view> geometry;
+    if (geometryData)
+        geometry = geometryData;
 
-    return program;
+    return CreateAndLinkProgramInternal(vertexData, geometry, fragmentData, bindCallback);
 }
 
 std::optional<GLuint> CreateAndLinkProgramFile(const char * vertexFile, const char * geometryFile, const char * fragmentFile, std::function<void(GLuint)> bindCallback)
 {
     printf("Compiling shaders from files: %s %s", vertexFile, fragmentFile);
 
-    auto vertexData = Common::ReadFile(vertexFile);
-    vertexData.push_back('\0');
-
-    auto fragmentData = Common::ReadFile(fragmentFile);
-    fragmentData.push_back('\0');
+    // sources are compiled straight from mapped files
+    auto vertexData = Common::MapFile(vertexFile);
+    auto fragmentData = Common::MapFile(fragmentFile);
 
-    std::vector<uint8_t> geometryData;
+    Common::MappedFile geometryData;
+    std::optional<std::string_view> geometry;
     if (geometryFile)
     {
-        geometryData = Common::ReadFile(geometryFile);
-        geometryData.push_back('\0');
+        geometryData = Common::MapFile(geometryFile);
+        geometry = std::string_view((const char *)geometryData.data(), geometryData.size());
     }
 
-    return CreateAndLinkProgram((const char *)vertexData.data(), geometryData.empty() ? nullptr : (const char *)geometryData.data(), (const char *)fragmentData.data(), bindCallback);
+    return CreateAndLinkProgramInternal(std::string_view((const char *)vertexData.data(), vertexData.size()),
+        geometry,
+        std::string_view((const char *)fragmentData.data(), fragmentData.size()),
+        bindCallback);
 }
 
 Shader::Shader(const char * vertex, const char * fragment)
@@ -124,10 +174,47 @@ Shader::Shader(const char * vertex, const char * geometry, const char * fragment
     m_program = CreateAndLinkProgram(vertex, geometry, fragment);
 }
 
+Shader::Shader(const char * vertex, const char * fragment, const AttributeLocations & attributes, bool async)
+{
+    ProgramLink link = SubmitProgram(vertex, std::nullopt, fragment, attributes, nullptr);
+
+    if (async)
+        m_link = std::move(link);
+    else
+        m_program = FinishProgram(link);
+}
+
 Shader::~Shader()
 {
     if (m_program)
-        glDeleteProgram(*m_program);
+        GLState::Instance().DeleteProgram(*m_program);
+
+    if (m_link)
+    {
+        for (GLuint shader : m_link->shaders)
+            glDeleteShader(shader);
+        glDeleteProgram(m_link->program);
+    }
+}
+
+bool Shader::IsReady()
+{
+    if (!m_link)
+        return true;
+
+    // without the extension status query waits for the driver
+    if (IsParallelShaderCompileSupported())
+    {
+        GLint completed = GL_FALSE;
+        glGetProgramiv(m_link->program, GL_COMPLETION_STATUS_KHR, &completed);
+        if (!completed)
+            return false;
+    }
+
+    m_program = FinishProgram(*m_link);
+    m_link.reset();
+
+    return true;
 }
 
 Shader::operator bool()
@@ -137,10 +224,19 @@ Shader::operator bool()
 
 void Shader::BindVAO(GLuint vao)
 {
-    glBindVertexArray(vao);
+    GLState::Instance().BindVertexArray(vao);
     m_boundVAO = true;
 }
 
+void Shader::BindArrayBuffer(GLuint buffer)
+{
+    // vao of previous draw is kept bound, attributes must not change it
+    if (!m_boundVAO && IsVAOSupported())
+        GLState::Instance().BindVertexArray(0);
+
+    GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, buffer);
+}
+
 template<class T>
 void Shader::BindBuffer(GLuint buffer, const char * locationName, uint32_t offset, uint32_t stride)
 {
@@ -158,12 +254,11 @@ void Shader::BindBuffer(GLuint buffer, GLuint location, uint32_t offset, uint32_
 template<>
 void Shader::BindBuffer<glm::vec4>(GLuint buffer, GLuint location, uint32_t offset, uint32_t stride)
 {
+    BindArrayBuffer(buffer);
+
     glEnableVertexAttribArray(location);
     CheckGlError("glEnableVertexAttribArray");
 
-    glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    CheckGlError("glBindBuffer");
-
     glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (void*)offset);
     CheckGlError("glVertexAttribPointer");
 
@@ -181,12 +276,11 @@ void Shader::BindBuffer<glm::vec4>(GLuint buffer, const char* locationName, uint
 template<>
 void Shader::BindBuffer<glm::vec3>(GLuint buffer, GLuint location, uint32_t offset, uint32_t stride)
 {
+    BindArrayBuffer(buffer);
+
     glEnableVertexAttribArray(location);
     CheckGlError("glEnableVertexAttribArray");
 
-    glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    CheckGlError("glBindBuffer");
-
     glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, stride, (void*)offset);
     CheckGlError("glVertexAttribPointer");
 
@@ -204,12 +298,11 @@ void Shader::BindBuffer<glm::vec3>(GLuint buffer, const char* locationName, uint
 template<>
 void Shader::BindBuffer<glm::vec2>(GLuint buffer, GLuint location, uint32_t offset, uint32_t stride)
 {
+    BindArrayBuffer(buffer);
+
     glEnableVertexAttribArray(location);
     CheckGlError("glEnableVertexAttribArray");
 
-    glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    CheckGlError("glBindBuffer");
-
     glVertexAttribPointer(location, 2, GL_FLOAT, GL_FALSE, stride, (void*)offset);
     CheckGlError("glVertexAttribPointer");
 
@@ -224,10 +317,37 @@ void Shader::BindBuffer<glm::vec2>(GLuint buffer, const char * locationName, uin
     BindBuffer<glm::vec2>(buffer, location, offset, stride);
 }
 
+void Shader::BindBuffer(GLuint buffer, GLuint location, GLint components, GLenum type, GLboolean normalized, uint32_t offset, uint32_t stride)
+{
+    BindArrayBuffer(buffer);
+
+    glEnableVertexAttribArray(location);
+    CheckGlError("glEnableVertexAttribArray");
+
+    glVertexAttribPointer(location, components, type, normalized, stride, (void*)(uintptr_t)offset);
+    CheckGlError("glVertexAttribPointer");
+
+    m_boundLocations.push_back(location);
+}
+
 void Shader::BindElementBuffer(GLuint buffer)
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
-    CheckGlError("glBindBuffer");
+    GLState::Instance().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+}
+
+bool Shader::ChangeUniform(GLuint location, const void * value, size_t size)
+{
+    // invalid location is ignored by OpenGL
+    if (location == GLuint(-1))
+        return false;
+
+    std::vector<uint8_t> & current = m_uniformValues[location];
+    bool changed = current.size() != size || memcmp(current.data(), value, size) != 0;
+    if (changed)
+        current.assign((const uint8_t*)value, (const uint8_t*)value + size);
+
+    GLState::Instance().CountUniform(changed);
+    return changed;
 }
 
 template<class T>
@@ -247,6 +367,9 @@ void Shader::SetUniform(const T & value, GLuint location)
 template<>
 void Shader::SetUniform<glm::mat4>(const glm::mat4 & value, GLuint location)
 {
+    if (!ChangeUniform(location, &value, sizeof(value)))
+        return;
+
     glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
     CheckGlError("glUniformMatrix4fv");
 }
@@ -261,6 +384,9 @@ void Shader::SetUniform<glm::mat4>(const glm::mat4 & value, const char * locatio
 template<>
 void Shader::SetUniform<glm::mat3>(const glm::mat3 & value, GLuint location)
 {
+    if (!ChangeUniform(location, &value, sizeof(value)))
+        return;
+
     glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
     CheckGlError("glUniformMatrix3fv");
 }
@@ -275,6 +401,9 @@ void Shader::SetUniform<glm::mat3>(const glm::mat3 & value, const char * locatio
 template<>
 void Shader::SetUniform<glm::vec4>(const glm::vec4& value, GLuint location)
 {
+    if (!ChangeUniform(location, &value, sizeof(value)))
+        return;
+
     glUniform4f(location, value.x, value.y, value.z, value.w);
     CheckGlError("glUniform3f");
 }
@@ -289,6 +418,9 @@ void Shader::SetUniform<glm::vec4>(const glm::vec4& value, const char* locationN
 template<>
 void Shader::SetUniform<glm::vec3>(const glm::vec3 & value, GLuint location)
 {
+    if (!ChangeUniform(location, &value, sizeof(value)))
+        return;
+
     glUniform3f(location, value.x, value.y, value.z);
     CheckGlError("glUniform3f");
 }
@@ -303,6 +435,9 @@ void Shader::SetUniform<glm::vec3>(const glm::vec3 & value, const char * locatio
 template<>
 void Shader::SetUniform<glm::vec2>(const glm::vec2 & value, GLuint location)
 {
+    if (!ChangeUniform(location, &value, sizeof(value)))
+        return;
+
     glUniform2f(location, value.x, value.y);
     CheckGlError("glUniform3f");
 }
@@ -317,6 +452,9 @@ void Shader::SetUniform<glm::vec2>(const glm::vec2 & value, const char * locatio
 template<>
 void Shader::SetUniform<float>(const float & value, GLuint location)
 {
+    if (!ChangeUniform(location, &value, sizeof(value)))
+        return;
+
     glUniform1f(location, value);
     CheckGlError("glUniform1f");
 }
@@ -331,6 +469,9 @@ void Shader::SetUniform<float>(const float & value, const char * locationName)
 template<>
 void Shader::SetUniform<GLint>(const GLint & value, GLuint location)
 {
+    if (!ChangeUniform(location, &value, sizeof(value)))
+        return;
+
     glUniform1i(location, value);
     CheckGlError("glUniform1i");
 }
@@ -344,14 +485,10 @@ void Shader::SetUniform<GLint>(const GLint & value, const char * locationName)
 
 void Shader::BindTexture(GLuint texture, GLuint location)
 {
-    glActiveTexture(GL_TEXTURE0 + m_currentTexture);
-    CheckGlError("glActiveTexture");
+    GLState::Instance().ActiveTexture(m_currentTexture);
+    GLState::Instance().BindTexture(GL_TEXTURE_2D, texture);
 
-    glBindTexture(GL_TEXTURE_2D, texture);
-    CheckGlError("glBindTexture");
-
-    glUniform1i(location, m_currentTexture);
-    CheckGlError("glUniform1i");
+    SetUniform((GLint)m_currentTexture, location);
 
     m_currentTexture++;
 }
@@ -370,22 +507,17 @@ void Shader::BindCubemapTexture(GLuint texture, const char * locationName)
 
 void Shader::BindCubemapTexture(GLuint texture, GLuint location)
 {
-    glActiveTexture(GL_TEXTURE0 + m_currentTexture);
-    CheckGlError("glActiveTexture");
-
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
-    CheckGlError("glBindTexture");
+    GLState::Instance().ActiveTexture(m_currentTexture);
+    GLState::Instance().BindTexture(GL_TEXTURE_CUBE_MAP, texture);
 
-    glUniform1i(location, m_currentTexture);
-    CheckGlError("glUniform1i");
+    SetUniform((GLint)m_currentTexture, location);
 
     m_currentTexture++;
 }
 
 void Shader::BeginRender()
 {
-    glUseProgram(*m_program);
-    CheckGlError("glUseProgram");
+    GLState::Instance().UseProgram(*m_program);
 }
 
 void Shader::EndRender()
@@ -394,24 +526,16 @@ void Shader::EndRender()
     Validate();
 #endif
 
-    if (m_boundVAO)
-    {
-        glBindVertexArray(0);
-    }
-    else
+    // program, vao and buffers stay bound, next draw changes only what differs
+    if (!m_boundVAO)
     {
         for (auto location : m_boundLocations)
             glDisableVertexAttribArray(location);
-        m_boundLocations.clear();
     }
+    m_boundLocations.clear();
+    m_boundVAO = false;
 
-    glActiveTexture(GL_TEXTURE0);
     m_currentTexture = 0;
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-    glUseProgram(0);
 }
 
 GLuint Shader::GetLocation(const std::string & locationName, LocationType type)
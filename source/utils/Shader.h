@@ -6,6 +6,19 @@
 #include <unordered_map>
 #include "glm/glm.hpp"
 #include <functional>
+#include <tuple>
+
+// attribute names bound to locations before linking
+using AttributeLocations = std::vector<std::tuple<std::string, GLuint>>;
+
+// program which is being linked, its shaders are deleted once it's finished
+struct ProgramLink
+{
+    GLuint program = 0;
+    std::vector<GLuint> shaders;
+    // program is stored to cache once linked
+    std::optional<uint64_t> cacheKey;
+};
 
 // geometry shader is optional
 std::optional<GLuint> CreateAndLinkProgramFile(const char * vertexFile, const char * geometryFile, const char * fragmentFile, std::function<void(GLuint)> bindCallback = nullptr);
@@ -16,8 +29,13 @@ class Shader
 public:
     Shader(const char * vertex, const char * fragment);
     Shader(const char * vertex, const char * geometry, const char * fragment);
+    // async program is linked in background, it can be used once IsReady returns true
+    Shader(const char * vertex, const char * fragment, const AttributeLocations & attributes, bool async);
     ~Shader();
 
+    // false while driver links program in background, errors are reported once it's finished
+    bool IsReady();
+
     enum class LocationType { Attrib, Uniform };
     std::vector<GLuint> GetLocations(const std::vector<std::tuple<std::string, LocationType>> & locations);
     GLuint GetLocation(const char * locationName, LocationType type);
@@ -30,6 +48,8 @@ public:
     void BindBuffer(GLuint buffer, const char * locationName, uint32_t offset = 0, uint32_t stride = 0);
     template<class T>
     void BindBuffer(GLuint buffer, GLuint location, uint32_t offset = 0, uint32_t stride = 0);
+    // attribute of any type, e.g. normalized integers of compact vertex layout
+    void BindBuffer(GLuint buffer, GLuint location, GLint components, GLenum type, GLboolean normalized, uint32_t offset, uint32_t stride);
 
     void BindElementBuffer(GLuint buffer);
 
@@ -55,15 +75,23 @@ public:
 private:
 
     void Validate();
+    void BindArrayBuffer(GLuint buffer);
+    // true when value differs from the one last set to location, new value is remembered
+    bool ChangeUniform(GLuint location, const void * value, size_t size);
     bool m_validated = false;
 
     std::unordered_map<std::string, GLuint> m_locations;
     std::optional<GLuint> m_program;
+    // async program not finished yet
+    std::optional<ProgramLink> m_link;
+    // values are part of program state, they persist while other programs are used
+    std::unordered_map<GLuint, std::vector<uint8_t>> m_uniformValues;
 
     GLuint m_currentTexture = 0;
     // TODO this is good only for non-vao drawing maybe it's not worth it
     std::vector<GLuint> m_boundLocations;
 
+    // vao bound since BeginRender
     bool m_boundVAO = false;
 };
 
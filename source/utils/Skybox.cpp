@@ -1,5 +1,6 @@
 #include "Skybox.h"
 #include "Common.h"
+#include "GLState.h"
 
 static const float SKYBOX_VERTICES[] =
 {
@@ -69,11 +70,11 @@ Skybox::Skybox(const std::vector<std::string>& paths)
     if (IsVAOSupported())
     {
         glGenVertexArrays(1, &m_vao);
-        glBindVertexArray(m_vao);
+        GLState::Instance().BindVertexArray(m_vao);
     }
 
     glGenBuffers(1, &m_vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_vbo);
     
     glBufferData(GL_ARRAY_BUFFER, sizeof(SKYBOX_VERTICES), &SKYBOX_VERTICES, GL_STATIC_DRAW);
 
@@ -82,22 +83,22 @@ Skybox::Skybox(const std::vector<std::string>& paths)
         glEnableVertexAttribArray(m_positionAttributeLocation);
         glVertexAttribPointer(m_positionAttributeLocation, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 
-        glBindVertexArray(0);
+        GLState::Instance().BindVertexArray(0);
     }
 }
 
 Skybox::~Skybox()
 {
-    glDeleteTextures(1, &m_texture);
-    glDeleteVertexArrays(1, &m_vao);
-    glDeleteBuffers(1, &m_vbo);
+    GLState::Instance().DeleteTexture(m_texture);
+    GLState::Instance().DeleteVertexArray(m_vao);
+    GLState::Instance().DeleteBuffer(m_vbo);
 }
 
 void Skybox::Draw(const glm::mat4 & view, const glm::mat4 & projection)
 {
     glm::mat4 viewSky = glm::mat4(glm::mat3(view)); // remove translation from the view matrix
 
-    glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
+    GLState::Instance().DepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
     
     m_shader.BeginRender();
 
@@ -120,7 +121,7 @@ void Skybox::Draw(const glm::mat4 & view, const glm::mat4 & projection)
 
     m_shader.EndRender();
 
-    glDepthFunc(GL_LESS); // set depth function back to default
+    GLState::Instance().DepthFunc(GL_LESS); // set depth function back to default
 }
 
 GLuint Skybox::GetSkyboxTexture()
@@ -1,5 +1,6 @@
 #include "Texture.h"
 #include "Common.h"
+#include "GLState.h"
 #include <vector>
 #include <string>
 
@@ -68,7 +69,7 @@ namespace Texture
         //glActiveTexture(GL_TEXTURE0);
 
         // "Bind" the newly created texture : all future texture functions will modify this texture
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        GLState::Instance().BindTexture(GL_TEXTURE_2D, textureID);
 
         // TODO: row of bitmap file must be multiple of 4, if it's not, there can be padding
 
@@ -145,7 +146,7 @@ namespace Texture
     {
         printf("Reading image %s\n", imagePath);
 
-        std::vector<uint8_t> data = Common::ReadFile(imagePath);
+        Common::MappedFile data = Common::MapFile(imagePath);
 
         if (data.empty())
         {
@@ -165,17 +166,17 @@ namespace Texture
             return std::nullopt;
         }
 
-        uint8_t * header = &data[4];
+        const uint8_t * header = &data[4];
 
-        uint32_t height = *(uint32_t*)&(header[8]);
-        uint32_t width = *(uint32_t*)&(header[12]);
-        uint32_t linearSize = *(uint32_t*)&(header[16]);
-        uint32_t mipMapCount = *(uint32_t*)&(header[24]);
-        uint32_t fourCC = *(uint32_t*)&(header[80]);
+        uint32_t height = *(const uint32_t*)&(header[8]);
+        uint32_t width = *(const uint32_t*)&(header[12]);
+        uint32_t linearSize = *(const uint32_t*)&(header[16]);
+        uint32_t mipMapCount = *(const uint32_t*)&(header[24]);
+        uint32_t fourCC = *(const uint32_t*)&(header[80]);
         uint32_t bufsize = mipMapCount > 1 ? linearSize * 2 : linearSize;
         /* how big is it going to be including all mipmaps? */
 
-        uint8_t * buffer = header + 124;
+        const uint8_t * buffer = header + 124;
 
         unsigned int components = (fourCC == FOURCC_DXT1) ? 3 : 4;
         unsigned int format;
@@ -202,7 +203,7 @@ namespace Texture
         glGenTextures(1, &textureID);
 
         // "Bind" the newly created texture : all future texture functions will modify this texture
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        GLState::Instance().BindTexture(GL_TEXTURE_2D, textureID);
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
         uint32_t blockSize = (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16;
@@ -232,7 +233,7 @@ namespace Texture
 #if !defined(EMSCRIPTEN) && !defined(ANDROID)
     bool WriteTGA(const char* imagePath, GLuint texture)
     {
-        glBindTexture(GL_TEXTURE_2D, texture);
+        GLState::Instance().BindTexture(GL_TEXTURE_2D, texture);
 
         GLint width, height;
         glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
@@ -242,7 +243,7 @@ namespace Texture
 
         glGetTexImage(GL_TEXTURE_2D, 0, GL_BGR, GL_UNSIGNED_BYTE, buffer.data());
 
-        glBindTexture(GL_TEXTURE_2D, 0);
+        GLState::Instance().BindTexture(GL_TEXTURE_2D, 0);
 
         int xa = width % 256;
         int xb = (width - xa) / 256;
@@ -264,7 +265,7 @@ namespace Texture
     {
         printf("Reading image %s\n", imagePath);
 
-        std::vector<uint8_t> data = Common::ReadFile(imagePath);
+        Common::MappedFile data = Common::MapFile(imagePath);
 
         if (data.empty())
         {
@@ -287,7 +288,7 @@ namespace Texture
 
         GLuint texture;
         glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
+        GLState::Instance().BindTexture(GL_TEXTURE_2D, texture);
 
         // set the texture wrapping/filtering options (on the currently bound texture object)
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GetCorrectWrapMode(GL_REPEAT, width));
@@ -322,16 +323,16 @@ namespace Texture
         uint32_t result;
 
         glGenTextures(1, &result);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, result);
+        GLState::Instance().BindTexture(GL_TEXTURE_CUBE_MAP, result);
 
         for (size_t i = 0; i < paths.size(); i++)
         {
-            std::vector<uint8_t> data = Common::ReadFile(paths[i].c_str());
+            Common::MappedFile data = Common::MapFile(paths[i].c_str());
 
             if (data.empty())
             {
                 printf("Error reading file %s\n", paths[i].c_str());
-                glDeleteTextures(1, &result);
+                GLState::Instance().DeleteTexture(result);
 
                 return std::nullopt;
             }
@@ -349,7 +350,7 @@ namespace Texture
             else
             {
                 printf("Cubemap texture failed to load at path: %s\n", paths[i].c_str());
-                glDeleteTextures(1, &result);
+                GLState::Instance().DeleteTexture(result);
 
                 return std::nullopt;
             }
@@ -421,11 +422,11 @@ namespace Texture
         if (IsVAOSupported())
         {
             glGenVertexArrays(1, &m_vaoQuad);
-            glBindVertexArray(m_vaoQuad);
+            GLState::Instance().BindVertexArray(m_vaoQuad);
         }
 
         glGenBuffers(1, &m_vboQuad);
-        glBindBuffer(GL_ARRAY_BUFFER, m_vboQuad);
+        GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_vboQuad);
         glBufferData(GL_ARRAY_BUFFER, sizeof(DRAW_VERTICES), DRAW_VERTICES, GL_STATIC_DRAW);
 
         if (IsVAOSupported())
@@ -438,13 +439,13 @@ namespace Texture
             glEnableVertexAttribArray(vertexUV);
             glVertexAttribPointer(vertexUV, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
 
-            glBindVertexArray(0);
+            GLState::Instance().BindVertexArray(0);
         }
     }
     DebugDraw::~DebugDraw()
     {
-        glDeleteBuffers(1, &m_vboQuad);
-        glDeleteVertexArrays(1, &m_vaoQuad);
+        GLState::Instance().DeleteBuffer(m_vboQuad);
+        GLState::Instance().DeleteVertexArray(m_vaoQuad);
     }
 
     void DebugDraw::Draw(GLuint texture, std::function<void(Shader & shader)> bindCallback)
@@ -461,8 +462,7 @@ namespace Texture
 
         if (IsVAOSupported())
         {
-            glBindVertexArray(m_vaoQuad);
-            CheckGlError("glBindVertexArray");
+            GLState::Instance().BindVertexArray(m_vaoQuad);
         }
         else
         {
@@ -477,8 +477,7 @@ namespace Texture
 
         if (IsVAOSupported())
         {
-            glBindVertexArray(0);
-            CheckGlError("glBindVertexArray");
+            GLState::Instance().BindVertexArray(0);
         }
         else
         {
@@ -1,35 +1,121 @@
 #include "VboIndexer.h"
 #include <optional>
+#include <unordered_map>
+#include <cmath>
 
 static const float DEFAULT_SIGMA = 0.01f;
+static const float GRID_CELL_SIZE = 2.0f * DEFAULT_SIGMA;
 bool IsNear(float a, float b, float sigma = DEFAULT_SIGMA)
 {
     return std::fabs(a - b) < sigma;
 }
 
-std::optional<uint16_t> GetSimilarVertexIndex(
+// Spatial hash of vertices already added to the VBO. Vertices are bucketed by position
+// into cells twice the size of DEFAULT_SIGMA, so any vertex near to a searched one
+// (see IsNear) is in the same or in one of the 26 neighbouring cells.
+class VertexGrid
+{
+public:
+    VertexGrid(size_t size)
+    {
+        m_cells.reserve(size);
+        m_next.reserve(size);
+    }
+
+    void Insert(const glm::vec3 & vertex, uint32_t index)
+    {
+        auto[it, inserted] = m_cells.try_emplace(GetKey(GetCell(vertex)), index);
+
+        if (m_next.size() <= index)
+            m_next.resize(index + 1, INVALID_INDEX);
+
+        // cell is a linked list of vertex indices, the newest one is the head
+        m_next[index] = inserted ? INVALID_INDEX : it->second;
+        it->second = index;
+    }
+
+    // Returns the lowest index for which isSimilar is true, this is the same vertex
+    // which would be found by linear search over all vertices.
+    template<class Predicate>
+    std::optional<uint32_t> Find(const glm::vec3 & vertex, Predicate isSimilar) const
+    {
+        std::optional<uint32_t> result;
+        Cell cell = GetCell(vertex);
+
+        for (int64_t x = -1; x <= 1; ++x)
+        {
+            for (int64_t y = -1; y <= 1; ++y)
+            {
+                for (int64_t z = -1; z <= 1; ++z)
+                {
+                    auto it = m_cells.find(GetKey({ cell.x + x, cell.y + y, cell.z + z }));
+                    if (it == std::end(m_cells))
+                        continue;
+
+                    for (uint32_t i = it->second; i != INVALID_INDEX; i = m_next[i])
+                    {
+                        if ((!result || i < *result) && isSimilar(i))
+                            result = i;
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+private:
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+    struct Cell
+    {
+        int64_t x, y, z;
+    };
+
+    static Cell GetCell(const glm::vec3 & vertex)
+    {
+        return { (int64_t)std::floor(vertex.x / GRID_CELL_SIZE),
+                 (int64_t)std::floor(vertex.y / GRID_CELL_SIZE),
+                 (int64_t)std::floor(vertex.z / GRID_CELL_SIZE) };
+    }
+
+    // Different cells may end up with the same key, that only adds candidates
+    // which are rejected by the similarity test.
+    static uint64_t GetKey(const Cell & cell)
+    {
+        return (uint64_t)cell.x * 73856093ull ^ (uint64_t)cell.y * 19349663ull ^ (uint64_t)cell.z * 83492791ull;
+    }
+
+    // key of cell -> index of the most recently inserted vertex in that cell
+    std::unordered_map<uint64_t, uint32_t> m_cells;
+    // index of vertex -> index of previous vertex in the same cell
+    std::vector<uint32_t> m_next;
+};
+
+std::optional<uint32_t> GetSimilarVertexIndex(
     const glm::vec3 & vertex,
     const glm::vec2 & uv,
     const glm::vec3 & normal,
+    const VertexGrid & grid,
     const std::vector<glm::vec3> & vertices,
     const std::vector<glm::vec2> & uvs,
     const std::vector<glm::vec3> & normals)
 {
-    // Lame linear search
-    for (size_t i = 0; i < vertices.size(); i++)
+    auto found = grid.Find(vertex, [&](uint32_t i)
     {
-        if (IsNear(vertex.x, vertices[i].x) &&
-            IsNear(vertex.y, vertices[i].y) &&
-            IsNear(vertex.z, vertices[i].z) &&
-            IsNear(uv.x, uvs[i].x) &&
-            IsNear(uv.y, uvs[i].y) &&
-            IsNear(normal.x, normals[i].x) &&
-            IsNear(normal.y, normals[i].y) &&
-            IsNear(normal.z, normals[i].z))
-        {
-            return static_cast<uint16_t>(i);
-        }
-    }
+        return IsNear(vertex.x, vertices[i].x) &&
+               IsNear(vertex.y, vertices[i].y) &&
+               IsNear(vertex.z, vertices[i].z) &&
+               IsNear(uv.x, uvs[i].x) &&
+               IsNear(uv.y, uvs[i].y) &&
+               IsNear(normal.x, normals[i].x) &&
+               IsNear(normal.y, normals[i].y) &&
+               IsNear(normal.z, normals[i].z);
+    });
+
+    if (found)
+        return *found;
+
     // No other vertex could be used instead.
     // Looks like we'll have to add it to the VBO.
     return std::nullopt;
@@ -43,11 +129,12 @@ IndexingResult VboIndex(const glm::vec3 * vertices,
                         size_t size)
 {
     IndexingResult result;
+    VertexGrid grid(size);
 
     // For each input vertex
     for (size_t i = 0; i < size; i++)
     {
-        if (auto found = GetSimilarVertexIndex(vertices[i], uvs[i], normals[i], result.vertices, result.uvs, result.normals))
+        if (auto found = GetSimilarVertexIndex(vertices[i], uvs[i], normals[i], grid, result.vertices, result.uvs, result.normals))
         {
             // A similar vertex is already in the VBO, use it instead !
             result.indices.push_back(*found);
@@ -64,7 +151,9 @@ IndexingResult VboIndex(const glm::vec3 * vertices,
             result.normals.push_back(normals[i]);
             result.tangents.push_back(tangents[i]);
             result.bitangents.push_back(bitangents[i]);
-            result.indices.push_back((uint16_t)result.vertices.size() - 1);
+            result.indices.push_back((uint32_t)result.vertices.size() - 1);
+
+            grid.Insert(vertices[i], (uint32_t)result.vertices.size() - 1);
         }
     }
 
@@ -80,18 +169,18 @@ IndexingResult VboIndex(const std::vector<glm::vec3> & vertices,
     return VboIndex(vertices.data(), uvs.data(), normals.data(), tangents.data(), bitangents.data(), vertices.size());
 }
 
-std::optional<uint16_t> GetSimilarVertexIndex(const glm::vec3 & vertex, const std::vector<glm::vec3> & vertices)
+std::optional<uint32_t> GetSimilarVertexIndex(const glm::vec3 & vertex, const VertexGrid & grid, const std::vector<glm::vec3> & vertices)
 {
-    // Lame linear search
-    for (size_t i = 0; i < vertices.size(); i++)
+    auto found = grid.Find(vertex, [&](uint32_t i)
     {
-        if (IsNear(vertex.x, vertices[i].x) &&
-            IsNear(vertex.y, vertices[i].y) &&
-            IsNear(vertex.z, vertices[i].z))
-        {
-            return static_cast<uint16_t>(i);
-        }
-    }
+        return IsNear(vertex.x, vertices[i].x) &&
+               IsNear(vertex.y, vertices[i].y) &&
+               IsNear(vertex.z, vertices[i].z);
+    });
+
+    if (found)
+        return *found;
+
     // No other vertex could be used instead.
     // Looks like we'll have to add it to the VBO.
     return std::nullopt;
@@ -100,11 +189,12 @@ std::optional<uint16_t> GetSimilarVertexIndex(const glm::vec3 & vertex, const st
 IndexingResult VboIndex(const glm::vec3 * vertices, size_t size)
 {
     IndexingResult result;
+    VertexGrid grid(size);
 
     // For each input vertex
     for (size_t i = 0; i < size; i++)
     {
-        if (auto found = GetSimilarVertexIndex(vertices[i], result.vertices))
+        if (auto found = GetSimilarVertexIndex(vertices[i], grid, result.vertices))
         {
             // A similar vertex is already in the VBO, use it instead !
             result.indices.push_back(*found);
@@ -113,7 +203,9 @@ IndexingResult VboIndex(const glm::vec3 * vertices, size_t size)
         {
             // If not, it needs to be added in the output data.
             result.vertices.push_back(vertices[i]);
-            result.indices.push_back((uint16_t)result.vertices.size() - 1);
+            result.indices.push_back((uint32_t)result.vertices.size() - 1);
+
+            grid.Insert(vertices[i], (uint32_t)result.vertices.size() - 1);
         }
     }
 
@@ -131,11 +223,12 @@ IndexingResult VboIndex(const glm::vec3 * vertices,
                         size_t size)
 {
     IndexingResult result;
+    VertexGrid grid(size);
 
     // For each input vertex
     for (size_t i = 0; i < size; i++)
     {
-        if (auto found = GetSimilarVertexIndex(vertices[i], uvs[i], normals[i], result.vertices, result.uvs, result.normals))
+        if (auto found = GetSimilarVertexIndex(vertices[i], uvs[i], normals[i], grid, result.vertices, result.uvs, result.normals))
         {
             // A similar vertex is already in the VBO, use it instead !
             result.indices.push_back(*found);
@@ -146,7 +239,9 @@ IndexingResult VboIndex(const glm::vec3 * vertices,
             result.vertices.push_back(vertices[i]);
             result.uvs.push_back(uvs[i]);
             result.normals.push_back(normals[i]);
-            result.indices.push_back((uint16_t)result.vertices.size() - 1);
+            result.indices.push_back((uint32_t)result.vertices.size() - 1);
+
+            grid.Insert(vertices[i], (uint32_t)result.vertices.size() - 1);
         }
     }
 
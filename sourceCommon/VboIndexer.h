@@ -4,7 +4,7 @@
 
 struct IndexingResult
 {
-    std::vector<uint16_t> indices;
+    std::vector<uint32_t> indices;
     std::vector<glm::vec3> vertices;
     std::vector<glm::vec2> uvs;
     std::vector<glm::vec3> normals;
@@ -0,0 +1,330 @@
+#include "VertexLayout.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+uint32_t GetFormatSize(ModelData::VertexFormat format)
+{
+    switch (format)
+    {
+    case ModelData::VertexFormat_Float:
+        return sizeof(float);
+    case ModelData::VertexFormat_Unorm16:
+    case ModelData::VertexFormat_Octahedral16:
+        return sizeof(uint16_t);
+    case ModelData::VertexFormat_Octahedral8:
+        return sizeof(int8_t);
+    }
+
+    return 0;
+}
+
+uint16_t EncodeUnorm16(float value)
+{
+    return (uint16_t)std::lround(glm::clamp(value, 0.0f, 1.0f) * 65535.0f);
+}
+
+float DecodeUnorm16(uint16_t value)
+{
+    return value / 65535.0f;
+}
+
+int16_t EncodeSnorm16(float value)
+{
+    return (int16_t)std::lround(glm::clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+float DecodeSnorm16(int16_t value)
+{
+    return std::max(value / 32767.0f, -1.0f);
+}
+
+int8_t EncodeSnorm8(float value)
+{
+    return (int8_t)std::lround(glm::clamp(value, -1.0f, 1.0f) * 127.0f);
+}
+
+float DecodeSnorm8(int8_t value)
+{
+    return std::max(value / 127.0f, -1.0f);
+}
+
+glm::vec2 EncodeOctahedral(const glm::vec3 & value)
+{
+    glm::vec3 v = value / (std::abs(value.x) + std::abs(value.y) + std::abs(value.z));
+    glm::vec2 result(v.x, v.y);
+
+    // lower half is folded over the diagonals
+    if (v.z < 0.0f)
+    {
+        result.x = (1.0f - std::abs(v.y)) * (v.x >= 0.0f ? 1.0f : -1.0f);
+        result.y = (1.0f - std::abs(v.x)) * (v.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    return result;
+}
+
+glm::vec3 DecodeOctahedral(const glm::vec2 & value)
+{
+    glm::vec3 result(value.x, value.y, 1.0f - std::abs(value.x) - std::abs(value.y));
+
+    if (result.z < 0.0f)
+    {
+        result.x = (1.0f - std::abs(value.y)) * (value.x >= 0.0f ? 1.0f : -1.0f);
+        result.y = (1.0f - std::abs(value.x)) * (value.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    return glm::normalize(result);
+}
+
+void AddAttribute(ModelData::MeshT & mesh, ModelData::VertexUsage usage, uint16_t channel, ModelData::VertexFormat format, uint16_t components)
+{
+    mesh.layout.emplace_back(usage, channel, format, components, mesh.vertexStride);
+
+    // attributes are aligned to 4 bytes
+    mesh.vertexStride += (components * GetFormatSize(format) + 3) & ~3u;
+}
+
+// separate array with data of attribute, arrays have to be already allocated
+float * GetAttributeData(ModelData::MeshT & mesh, const ModelData::VertexAttribute & attribute, size_t count)
+{
+    switch (attribute.usage())
+    {
+    case ModelData::VertexUsage_Position:
+        return (float*)mesh.positions.data();
+    case ModelData::VertexUsage_Normal:
+        return (float*)mesh.normals.data();
+    case ModelData::VertexUsage_TexCoord:
+        // UV channels are stored as continuous array
+        return (float*)&mesh.texCoords[attribute.channel() * count];
+    case ModelData::VertexUsage_Tangent:
+        return (float*)mesh.tangents.data();
+    }
+
+    return nullptr;
+}
+
+glm::vec3 GetBoundsLower(const ModelData::MeshT & mesh)
+{
+    return { mesh.bounds->lower().x(), mesh.bounds->lower().y(), mesh.bounds->lower().z() };
+}
+
+glm::vec3 GetBoundsExtents(const ModelData::MeshT & mesh)
+{
+    return glm::vec3(mesh.bounds->upper().x(), mesh.bounds->upper().y(), mesh.bounds->upper().z()) - GetBoundsLower(mesh);
+}
+
+bool IsInUnitRange(const ModelData::Vec2 * data, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (data[i].x() < 0.0f || data[i].x() > 1.0f || data[i].y() < 0.0f || data[i].y() > 1.0f)
+            return false;
+    }
+
+    return true;
+}
+
+// sign of bitangent relative to cross(normal, tangent)
+float GetBitangentSign(const ModelData::MeshT & mesh, size_t index)
+{
+    if (mesh.bitangents.empty() || mesh.normals.empty())
+        return 1.0f;
+
+    const glm::vec3 & normal = *(const glm::vec3*)&mesh.normals[index];
+    const glm::vec3 & tangent = *(const glm::vec3*)&mesh.tangents[index];
+    const glm::vec3 & bitangent = *(const glm::vec3*)&mesh.bitangents[index];
+
+    return glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+}
+
+void EncodeAttribute(ModelData::MeshT & mesh, const ModelData::VertexAttribute & attribute, size_t count)
+{
+    const float * data = GetAttributeData(mesh, attribute, count);
+    uint8_t * vertices = &mesh.vertices[attribute.offset()];
+    uint32_t stride = mesh.vertexStride;
+
+    switch (attribute.format())
+    {
+    case ModelData::VertexFormat_Float:
+        for (size_t i = 0; i < count; ++i)
+            memcpy(&vertices[i * stride], &data[i * attribute.components()], attribute.components() * sizeof(float));
+        break;
+    case ModelData::VertexFormat_Unorm16:
+    {
+        // positions relative to bounds, UVs are already in <0, 1>
+        glm::vec3 lower(0.0f), extents(1.0f);
+        if (attribute.usage() == ModelData::VertexUsage_Position)
+        {
+            lower = GetBoundsLower(mesh);
+            extents = GetBoundsExtents(mesh);
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint16_t encoded[3];
+            for (size_t c = 0; c < attribute.components(); ++c)
+            {
+                float value = data[i * attribute.components() + c] - lower[c];
+                encoded[c] = EncodeUnorm16(extents[c] > 0.0f ? value / extents[c] : 0.0f);
+            }
+            memcpy(&vertices[i * stride], encoded, attribute.components() * sizeof(uint16_t));
+        }
+        break;
+    }
+    case ModelData::VertexFormat_Octahedral16:
+        for (size_t i = 0; i < count; ++i)
+        {
+            glm::vec2 octahedral = EncodeOctahedral(*(const glm::vec3*)&data[i * 3]);
+            int16_t encoded[2] = { EncodeSnorm16(octahedral.x), EncodeSnorm16(octahedral.y) };
+            memcpy(&vertices[i * stride], encoded, sizeof(encoded));
+        }
+        break;
+    case ModelData::VertexFormat_Octahedral8:
+        for (size_t i = 0; i < count; ++i)
+        {
+            glm::vec2 octahedral = EncodeOctahedral(*(const glm::vec3*)&data[i * 3]);
+            int8_t encoded[3] = { EncodeSnorm8(octahedral.x), EncodeSnorm8(octahedral.y), EncodeSnorm8(GetBitangentSign(mesh, i)) };
+            memcpy(&vertices[i * stride], encoded, sizeof(encoded));
+        }
+        break;
+    }
+}
+
+void DecodeAttribute(ModelData::MeshT & mesh, const ModelData::VertexAttribute & attribute, size_t count)
+{
+    float * data = GetAttributeData(mesh, attribute, count);
+    const uint8_t * vertices = &mesh.vertices[attribute.offset()];
+    uint32_t stride = mesh.vertexStride;
+
+    switch (attribute.format())
+    {
+    case ModelData::VertexFormat_Float:
+        for (size_t i = 0; i < count; ++i)
+            memcpy(&data[i * attribute.components()], &vertices[i * stride], attribute.components() * sizeof(float));
+        break;
+    case ModelData::VertexFormat_Unorm16:
+    {
+        glm::vec3 lower(0.0f), extents(1.0f);
+        if (attribute.usage() == ModelData::VertexUsage_Position)
+        {
+            lower = GetBoundsLower(mesh);
+            extents = GetBoundsExtents(mesh);
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint16_t encoded[3];
+            memcpy(encoded, &vertices[i * stride], attribute.components() * sizeof(uint16_t));
+            for (size_t c = 0; c < attribute.components(); ++c)
+                data[i * attribute.components() + c] = lower[c] + DecodeUnorm16(encoded[c]) * extents[c];
+        }
+        break;
+    }
+    case ModelData::VertexFormat_Octahedral16:
+        for (size_t i = 0; i < count; ++i)
+        {
+            int16_t encoded[2];
+            memcpy(encoded, &vertices[i * stride], sizeof(encoded));
+            *(glm::vec3*)&data[i * 3] = DecodeOctahedral({ DecodeSnorm16(encoded[0]), DecodeSnorm16(encoded[1]) });
+        }
+        break;
+    case ModelData::VertexFormat_Octahedral8:
+        for (size_t i = 0; i < count; ++i)
+        {
+            int8_t encoded[3];
+            memcpy(encoded, &vertices[i * stride], sizeof(encoded));
+            *(glm::vec3*)&data[i * 3] = DecodeOctahedral({ DecodeSnorm8(encoded[0]), DecodeSnorm8(encoded[1]) });
+
+            // bitangent is restored from its sign, normals are decoded before tangents
+            if (attribute.usage() == ModelData::VertexUsage_Tangent && !mesh.normals.empty())
+            {
+                const glm::vec3 & normal = *(const glm::vec3*)&mesh.normals[i];
+                const glm::vec3 & tangent = *(const glm::vec3*)&data[i * 3];
+                glm::vec3 bitangent = glm::cross(normal, tangent) * (encoded[2] < 0 ? -1.0f : 1.0f);
+                mesh.bitangents[i] = { bitangent.x, bitangent.y, bitangent.z };
+            }
+        }
+        break;
+    }
+}
+
+void InterleaveVertices(ModelData::MeshT & mesh, bool compact)
+{
+    if (!mesh.vertices.empty() || mesh.positions.empty())
+        return;
+
+    size_t count = mesh.positions.size();
+
+    mesh.layout.clear();
+    mesh.vertexStride = 0;
+
+    AddAttribute(mesh, ModelData::VertexUsage_Position, 0, compact && mesh.bounds ? ModelData::VertexFormat_Unorm16 : ModelData::VertexFormat_Float, 3);
+
+    if (!mesh.normals.empty())
+        AddAttribute(mesh, ModelData::VertexUsage_Normal, 0, compact ? ModelData::VertexFormat_Octahedral16 : ModelData::VertexFormat_Float, compact ? 2 : 3);
+
+    for (size_t channel = 0; channel < mesh.texCoords.size() / count; ++channel)
+    {
+        // UVs outside of <0, 1> (wrapping textures) stay as floats
+        bool unit = IsInUnitRange(&mesh.texCoords[channel * count], count);
+        AddAttribute(mesh, ModelData::VertexUsage_TexCoord, (uint16_t)channel, compact && unit ? ModelData::VertexFormat_Unorm16 : ModelData::VertexFormat_Float, 2);
+    }
+
+    if (!mesh.tangents.empty())
+        AddAttribute(mesh, ModelData::VertexUsage_Tangent, 0, compact ? ModelData::VertexFormat_Octahedral8 : ModelData::VertexFormat_Float, 3);
+
+    mesh.vertices.resize(count * mesh.vertexStride);
+
+    for (const auto & attribute : mesh.layout)
+        EncodeAttribute(mesh, attribute, count);
+
+    // sign of bitangent is stored with tangent
+    if (compact && !mesh.tangents.empty())
+        mesh.bitangents.clear();
+
+    mesh.positions.clear();
+    mesh.normals.clear();
+    mesh.texCoords.clear();
+    mesh.tangents.clear();
+}
+
+void DeinterleaveVertices(ModelData::MeshT & mesh)
+{
+    if (mesh.vertices.empty() || mesh.vertexStride == 0)
+        return;
+
+    size_t count = mesh.vertices.size() / mesh.vertexStride;
+
+    for (const auto & attribute : mesh.layout)
+    {
+        switch (attribute.usage())
+        {
+        case ModelData::VertexUsage_Position:
+            mesh.positions.resize(count);
+            break;
+        case ModelData::VertexUsage_Normal:
+            mesh.normals.resize(count);
+            break;
+        case ModelData::VertexUsage_TexCoord:
+            mesh.texCoords.resize(std::max(mesh.texCoords.size(), (attribute.channel() + 1) * count));
+            break;
+        case ModelData::VertexUsage_Tangent:
+            mesh.tangents.resize(count);
+            if (attribute.format() == ModelData::VertexFormat_Octahedral8)
+                mesh.bitangents.resize(count);
+            break;
+        }
+    }
+
+    // normals first, bitangents are restored from them
+    std::vector<ModelData::VertexAttribute> layout = mesh.layout;
+    std::stable_sort(layout.begin(), layout.end(), [](const ModelData::VertexAttribute & l, const ModelData::VertexAttribute & r) { return l.usage() < r.usage(); });
+
+    for (const auto & attribute : layout)
+        DecodeAttribute(mesh, attribute, count);
+
+    mesh.vertices.clear();
+    mesh.layout.clear();
+    mesh.vertexStride = 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "model_generated.h"
+#include "glm/glm.hpp"
+
+// Packs positions, normals, texCoords and tangents of mesh into one interleaved
+// vertex stream described by layout, the separate arrays are cleared.
+// Bitangents and colors are not used for rendering and stay separate.
+// Compact layout quantizes positions to Unorm16 relative to mesh bounds (these must
+// be set), normals to Octahedral16, tangents to Octahedral8 with sign of bitangent
+// and UV channels within <0, 1> to Unorm16. Bitangents are cleared as they can be
+// computed from the sign.
+void InterleaveVertices(ModelData::MeshT & mesh, bool compact = false);
+
+// Inverse of InterleaveVertices
+void DeinterleaveVertices(ModelData::MeshT & mesh);
+
+// size of one component in bytes
+uint32_t GetFormatSize(ModelData::VertexFormat format);
+
+// conversions used by compact layout, exposed for computing encoding errors
+uint16_t EncodeUnorm16(float value);
+float DecodeUnorm16(uint16_t value);
+int16_t EncodeSnorm16(float value);
+float DecodeSnorm16(int16_t value);
+int8_t EncodeSnorm8(float value);
+float DecodeSnorm8(int8_t value);
+
+// unit vector mapped to octahedron unfolded to <-1, 1> square
+glm::vec2 EncodeOctahedral(const glm::vec3 & value);
+glm::vec3 DecodeOctahedral(const glm::vec2 & value);
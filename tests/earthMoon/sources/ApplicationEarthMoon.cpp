@@ -64,7 +64,7 @@ namespace
 
     void DrawScene()
     {
-        g_scene->Step();
+        g_scene->Step(Common::Frame::GetTimeDelta());
 
         g_lightData.lightDirectional.direction = -g_lightPositionWorldSpace;
 
@@ -142,5 +142,7 @@ void ApplicationEarthMoon::Deinit()
 
 void ApplicationEarthMoon::Gui()
 {
-
+    const Scene::Statistics & statistics = g_scene->GetStatistics();
+    ImGui::Text("Shapes: %u visible of %u", statistics.visible, statistics.total);
+    ImGui::Text("Bodies: %u culled of %u", statistics.bodies.culled, statistics.bodies.tested);
 }
@@ -0,0 +1,302 @@
+// Headless benchmark of model loading, CPU side of Model::Model without GL calls.
+// Each file is loaded the way the renderer did before, unpacked with UnPackModel, and the way
+// it does now, verified with VerifyModelBuffer and read in place through table accessors.
+// Buffers which would be passed to glBufferData are copied to a staging buffer instead.
+// Best load time of both paths and peak resident memory after each of them are printed.
+//
+// usage: modelLoadBenchmark [model path ...] (default data/models/craneo/craneo.model, run from repository root)
+
+#include "model_generated.h"
+#include "VertexLayout.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    const int32_t MEASURED_RUNS = 10;
+
+    // stands for memory of the driver, reused between loads
+    class Staging
+    {
+    public:
+        void Upload(const void * data, size_t size)
+        {
+            if (m_buffer.size() < size)
+                m_buffer.resize(size);
+            memcpy(m_buffer.data(), data, size);
+
+            m_uploaded += size;
+        }
+
+        size_t GetUploaded() const
+        {
+            return m_uploaded;
+        }
+
+    private:
+        std::vector<uint8_t> m_buffer;
+        size_t m_uploaded = 0;
+    };
+
+    struct Tree
+    {
+        std::vector<uint32_t> meshes;
+        std::vector<Tree> childs;
+    };
+
+    std::vector<uint8_t> ReadFile(const char * path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // peak resident set size in MB
+    double GetPeakMemory()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#elif defined(__APPLE__)
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss / 1024.0;
+#endif
+    }
+
+    // Model::Model before loading in place
+    namespace Unpacked
+    {
+        Tree ProcessTree(const ModelData::TreeT & node)
+        {
+            Tree result;
+            result.meshes = node.meshes;
+
+            for (auto & child : node.childs)
+                result.childs.push_back(ProcessTree(*child));
+
+            return result;
+        }
+
+        size_t Load(const std::vector<uint8_t> & data, Staging & staging)
+        {
+            auto model = ModelData::UnPackModel(data.data());
+
+            std::vector<std::string> textures;
+            for (auto & material : model->materials)
+            {
+                for (auto & texture : material->textureDiffuse)
+                    textures.push_back(texture->path);
+                for (auto & texture : material->textureNormal)
+                    textures.push_back(texture->path);
+            }
+
+            for (auto & mesh : model->meshes)
+            {
+                InterleaveVertices(*mesh);
+                staging.Upload(mesh->vertices.data(), mesh->vertices.size());
+
+                if (!mesh->indices32.empty())
+                    staging.Upload(mesh->indices32.data(), mesh->indices32.size() * sizeof(uint32_t));
+                else
+                    staging.Upload(mesh->indices.data(), mesh->indices.size() * sizeof(uint16_t));
+
+                for (auto & lod : mesh->lods)
+                {
+                    if (!lod->indices32.empty())
+                        staging.Upload(lod->indices32.data(), lod->indices32.size() * sizeof(uint32_t));
+                    else
+                        staging.Upload(lod->indices.data(), lod->indices.size() * sizeof(uint16_t));
+                }
+            }
+
+            Tree tree;
+            if (model->tree)
+                tree = ProcessTree(*model->tree);
+
+            return model->meshes.size();
+        }
+    }
+
+    // Model::Model now
+    namespace InPlace
+    {
+        template<class T>
+        void UploadIndices(const T & mesh, Staging & staging)
+        {
+            if (mesh.indices32())
+                staging.Upload(mesh.indices32()->data(), mesh.indices32()->size() * sizeof(uint32_t));
+            else if (mesh.indices())
+                staging.Upload(mesh.indices()->data(), mesh.indices()->size() * sizeof(uint16_t));
+        }
+
+        void AddTextures(const flatbuffers::Vector<flatbuffers::Offset<ModelData::Texture>> * data, std::vector<std::string> & textures)
+        {
+            if (!data)
+                return;
+
+            for (const ModelData::Texture * texture : *data)
+                textures.push_back(texture->path() ? texture->path()->str() : std::string());
+        }
+
+        Tree ProcessTree(const ModelData::Tree & node)
+        {
+            Tree result;
+            if (node.meshes())
+                result.meshes.assign(node.meshes()->begin(), node.meshes()->end());
+
+            if (node.childs())
+            {
+                for (const ModelData::Tree * child : *node.childs())
+                    result.childs.push_back(ProcessTree(*child));
+            }
+
+            return result;
+        }
+
+        size_t Load(const std::vector<uint8_t> & data, Staging & staging)
+        {
+            flatbuffers::Verifier verifier(data.data(), data.size());
+            if (!ModelData::VerifyModelBuffer(verifier))
+            {
+                printf("Error loading model, invalid file\n");
+                return 0;
+            }
+
+            const ModelData::Model * model = ModelData::GetModel(data.data());
+
+            std::vector<std::string> textures;
+            if (model->materials())
+            {
+                for (const ModelData::Material * material : *model->materials())
+                {
+                    AddTextures(material->textureDiffuse(), textures);
+                    AddTextures(material->textureNormal(), textures);
+                }
+            }
+
+            if (!model->meshes())
+                return 0;
+
+            for (const ModelData::Mesh * mesh : *model->meshes())
+            {
+                if (mesh->vertices() && mesh->layout())
+                {
+                    staging.Upload(mesh->vertices()->data(), mesh->vertices()->size());
+                }
+                else
+                {
+                    // older models have separate vertex arrays, these have to be interleaved first
+                    std::unique_ptr<ModelData::MeshT> unpacked(mesh->UnPack());
+                    InterleaveVertices(*unpacked);
+                    staging.Upload(unpacked->vertices.data(), unpacked->vertices.size());
+                }
+
+                UploadIndices(*mesh, staging);
+
+                if (mesh->lods())
+                {
+                    for (const ModelData::MeshLod * lod : *mesh->lods())
+                        UploadIndices(*lod, staging);
+                }
+            }
+
+            Tree tree;
+            if (model->tree())
+                tree = ProcessTree(*model->tree());
+
+            return model->meshes()->size();
+        }
+    }
+
+    // best of runs in milliseconds
+    template<class Function>
+    double Measure(Function function)
+    {
+        double best = 0.0;
+        for (int32_t i = 0; i < MEASURED_RUNS; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            function();
+            auto end = std::chrono::steady_clock::now();
+
+            double time = std::chrono::duration<double, std::milli>(end - start).count();
+            if (i == 0 || time < best)
+                best = time;
+        }
+
+        return best;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    std::vector<const char *> paths;
+    for (int32_t i = 1; i < argc; ++i)
+        paths.push_back(argv[i]);
+
+    if (paths.empty())
+        paths = { "data/models/craneo/craneo.model" };
+
+    // peak memory only grows, paths are measured from the lighter one and files are read first
+    std::vector<std::vector<uint8_t>> files;
+    for (const char * path : paths)
+    {
+        files.push_back(ReadFile(path));
+        if (files.back().empty())
+        {
+            printf("Error opening file %s\n", path);
+            return 1;
+        }
+    }
+
+    double baseMemory = GetPeakMemory();
+
+    std::vector<double> inPlaceTimes;
+    std::vector<size_t> meshes;
+    std::vector<size_t> uploaded;
+    for (const auto & data : files)
+    {
+        Staging staging;
+        meshes.push_back(InPlace::Load(data, staging));
+        uploaded.push_back(staging.GetUploaded());
+
+        inPlaceTimes.push_back(Measure([&data]() { Staging staging; InPlace::Load(data, staging); }));
+    }
+
+    double inPlaceMemory = GetPeakMemory();
+
+    std::vector<double> unpackedTimes;
+    for (const auto & data : files)
+        unpackedTimes.push_back(Measure([&data]() { Staging staging; Unpacked::Load(data, staging); }));
+
+    double unpackedMemory = GetPeakMemory();
+
+    printf("%-40s %8s %12s %12s %14s %8s\n", "model", "meshes", "upload [MB]", "unpack [ms]", "in place [ms]", "speedup");
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        printf("%-40s %8zu %12.3f %12.3f %14.3f %8.2f\n", paths[i], meshes[i], uploaded[i] / (1024.0 * 1024.0),
+            unpackedTimes[i], inPlaceTimes[i], unpackedTimes[i] / inPlaceTimes[i]);
+    }
+
+    printf("\npeak RSS [MB]: files read %.1f, in place %.1f, unpack %.1f\n", baseMemory, inPlaceMemory, unpackedMemory);
+
+    return 0;
+}
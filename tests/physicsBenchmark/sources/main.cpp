@@ -0,0 +1,170 @@
+// Headless benchmark of multithreaded physics world, towers of stacked boxes are stepped
+// with increasing number of threads and average step time is printed for each.
+//
+// usage: physicsBenchmark [boxes count ...] (default 5000 10000 20000 50000)
+
+#include <btBulletDynamicsCommon.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include "scene/TaskScheduler.h"
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    const int32_t TOWER_HEIGHT = 10;
+    const float BOX_HALF_EXTENT = 0.5f;
+    // towers don't touch, each is an island of its own
+    const float TOWER_SPACING = 1.5f;
+    const btScalar TIME_STEP = 1.0f / 60.0f;
+    const int32_t WARMUP_STEPS = 30;
+    const int32_t MEASURED_STEPS = 120;
+
+    // same setup as Bullet class of scene, without debug drawing
+    class World
+    {
+    public:
+        World(int32_t boxes)
+        {
+            m_collisionConfiguration.reset(new btDefaultCollisionConfiguration());
+            m_broadphase.reset(new btDbvtBroadphase());
+            m_dispatcher.reset(new btCollisionDispatcherMt(m_collisionConfiguration.get(), 40));
+            m_solverPool.reset(new btConstraintSolverPoolMt(TaskScheduler::Instance().getMaxNumThreads()));
+            m_solver.reset(new btSequentialImpulseConstraintSolverMt());
+
+            m_world.reset(new btDiscreteDynamicsWorldMt(m_dispatcher.get(), m_broadphase.get(), m_solverPool.get(), m_solver.get(), m_collisionConfiguration.get()));
+            m_world->setGravity({ 0.0f, -10.0f, 0.0f });
+
+            int32_t towers = (boxes + TOWER_HEIGHT - 1) / TOWER_HEIGHT;
+            int32_t side = (int32_t)std::ceil(std::sqrt((float)towers));
+            float extent = side * TOWER_SPACING * 0.5f + 1.0f;
+
+            m_groundShape.reset(new btBoxShape({ extent, 1.0f, extent }));
+            AddBody(m_groundShape.get(), { 0.0f, -1.0f, 0.0f }, 0.0f);
+
+            m_boxShape.reset(new btBoxShape({ BOX_HALF_EXTENT, BOX_HALF_EXTENT, BOX_HALF_EXTENT }));
+            for (int32_t i = 0; i < boxes; ++i)
+            {
+                int32_t tower = i / TOWER_HEIGHT;
+                int32_t level = i % TOWER_HEIGHT;
+
+                btVector3 position((tower % side - side * 0.5f) * TOWER_SPACING,
+                    BOX_HALF_EXTENT + level * 2.0f * BOX_HALF_EXTENT,
+                    (tower / side - side * 0.5f) * TOWER_SPACING);
+
+                // stacks would fall asleep and stop costing anything
+                AddBody(m_boxShape.get(), position, 1.0f)->setActivationState(DISABLE_DEACTIVATION);
+            }
+        }
+
+        ~World()
+        {
+            for (int32_t i = m_world->getNumCollisionObjects() - 1; i >= 0; i--)
+            {
+                btCollisionObject * object = m_world->getCollisionObjectArray()[i];
+                btRigidBody * body = btRigidBody::upcast(object);
+                if (body && body->getMotionState())
+                    delete body->getMotionState();
+
+                m_world->removeCollisionObject(object);
+                delete object;
+            }
+        }
+
+        void Step()
+        {
+            m_world->stepSimulation(TIME_STEP, 1, TIME_STEP);
+        }
+
+    private:
+        btRigidBody * AddBody(btCollisionShape * shape, const btVector3 & position, btScalar mass)
+        {
+            btVector3 inertia(0.0f, 0.0f, 0.0f);
+            if (mass != 0.0f)
+                shape->calculateLocalInertia(mass, inertia);
+
+            btTransform transform;
+            transform.setIdentity();
+            transform.setOrigin(position);
+
+            btRigidBody::btRigidBodyConstructionInfo info(mass, new btDefaultMotionState(transform), shape, inertia);
+            btRigidBody * body = new btRigidBody(info);
+            m_world->addRigidBody(body);
+
+            return body;
+        }
+
+        std::unique_ptr<btDefaultCollisionConfiguration> m_collisionConfiguration;
+        std::unique_ptr<btBroadphaseInterface> m_broadphase;
+        std::unique_ptr<btCollisionDispatcher> m_dispatcher;
+        std::unique_ptr<btConstraintSolverPoolMt> m_solverPool;
+        std::unique_ptr<btSequentialImpulseConstraintSolver> m_solver;
+        std::unique_ptr<btDiscreteDynamicsWorld> m_world;
+
+        std::unique_ptr<btCollisionShape> m_groundShape;
+        std::unique_ptr<btCollisionShape> m_boxShape;
+    };
+
+    // average milliseconds per step
+    double Measure(int32_t boxes, int32_t threads)
+    {
+        TaskScheduler::Instance().setNumThreads(threads);
+
+        World world(boxes);
+
+        for (int32_t i = 0; i < WARMUP_STEPS; ++i)
+            world.Step();
+
+        auto start = std::chrono::steady_clock::now();
+        for (int32_t i = 0; i < MEASURED_STEPS; ++i)
+            world.Step();
+        auto end = std::chrono::steady_clock::now();
+
+        return std::chrono::duration<double, std::milli>(end - start).count() / MEASURED_STEPS;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    std::vector<int32_t> counts;
+    for (int32_t i = 1; i < argc; ++i)
+        counts.push_back(std::atoi(argv[i]));
+
+    if (counts.empty())
+        counts = { 5000, 10000, 20000, 50000 };
+
+    // created by this thread, it steps the worlds
+    btSetTaskScheduler(&TaskScheduler::Instance());
+    int32_t maxThreads = TaskScheduler::Instance().getMaxNumThreads();
+
+    std::vector<int32_t> threads;
+    for (int32_t count = 1; count < maxThreads; count *= 2)
+        threads.push_back(count);
+    threads.push_back(maxThreads);
+
+    // speedup is bounded by cores, printed so that tables from different machines can be compared
+    printf("hardware threads %u, scheduler threads %d\n\n", std::thread::hardware_concurrency(), maxThreads);
+    printf("%8s %8s %12s %8s\n", "boxes", "threads", "step [ms]", "speedup");
+
+    for (int32_t boxes : counts)
+    {
+        double single = 0.0;
+        for (int32_t count : threads)
+        {
+            double time = Measure(boxes, count);
+            if (count == 1)
+                single = time;
+
+            printf("%8d %8d %12.3f %8.2f\n", boxes, count, time, single / time);
+            fflush(stdout);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,200 @@
+// Headless benchmark of render queue, CPU side of Scene::DrawShapes without GL calls.
+// Shapes with a few meshes and materials are scattered in front of the camera, each frame
+// their keys are built, sorted and walked the way the scene draws them. Time per frame and
+// how many mesh and material binds are left out of the shapes count are printed.
+//
+// usage: renderQueueBenchmark [shapes count ...] (default 10000 50000 100000)
+
+#include "scene/RenderQueue.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    const uint32_t MESHES = 4;
+    const uint32_t MATERIALS = 16;
+    const float SCENE_EXTENT = 100.0f;
+    const int32_t WARMUP_FRAMES = 10;
+    const int32_t MEASURED_FRAMES = 100;
+
+    // same layout as Material::Data, which comes with GL headers
+    struct MaterialData
+    {
+        glm::vec3 ambient;
+        glm::vec3 diffuse;
+        glm::vec3 specular;
+        float shininess = 0.0f;
+        float shininessStrength = 1.0f;
+    };
+
+    // shape arrays of the scene
+    struct Shapes
+    {
+        std::vector<uint32_t> mesh;
+        std::vector<glm::mat4> model;
+        std::vector<MaterialData> material;
+    };
+
+    struct Binds
+    {
+        uint32_t meshes = 0;
+        uint32_t materials = 0;
+    };
+
+    Shapes CreateShapes(uint32_t count)
+    {
+        std::mt19937 random(count);
+        std::uniform_real_distribution<float> position(-SCENE_EXTENT, SCENE_EXTENT);
+
+        std::vector<MaterialData> materials(MATERIALS);
+        for (uint32_t i = 0; i < MATERIALS; ++i)
+        {
+            float value = float(i) / MATERIALS;
+            materials[i].ambient = glm::vec3(0.1f);
+            materials[i].diffuse = glm::vec3(value, 1.0f - value, 0.5f);
+            materials[i].specular = glm::vec3(0.5f);
+            materials[i].shininess = 8.0f + i;
+        }
+
+        // shapes are added in random order like by the editor, neighbours differ in mesh and material
+        Shapes shapes;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            shapes.mesh.push_back(random() % MESHES);
+            shapes.model.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random) - 2.0f * SCENE_EXTENT)));
+            shapes.material.push_back(materials[random() % MATERIALS]);
+        }
+
+        return shapes;
+    }
+
+    class Frame
+    {
+    public:
+        Frame(const Shapes & shapes)
+            : m_shapes(shapes)
+        {
+            glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 4.0f * SCENE_EXTENT);
+            glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            m_viewProjection = projection * view;
+
+            // nothing is culled, every shape is drawn
+            for (uint32_t i = 0; i < shapes.mesh.size(); ++i)
+                m_drawables.push_back(i);
+        }
+
+        void Build()
+        {
+            m_queue.Clear();
+
+            for (uint32_t i = 0; i < m_drawables.size(); ++i)
+            {
+                uint32_t index = m_drawables[i];
+
+                uint32_t material = RenderQueue::Hash(&m_shapes.material[index], sizeof(MaterialData));
+                float depth = RenderQueue::GetDepth(m_viewProjection, glm::vec3(m_shapes.model[index][3]));
+
+                m_queue.Add(RenderQueue::MakeKey(0, 0, m_shapes.mesh[index], material, depth), i);
+            }
+        }
+
+        void Sort()
+        {
+            m_queue.Sort();
+        }
+
+        // binds Scene::DrawShapes would do
+        Binds Execute() const
+        {
+            Binds binds;
+            uint32_t mesh = UINT32_MAX;
+            const MaterialData * material = nullptr;
+
+            for (const RenderQueue::Record & record : m_queue.GetRecords())
+            {
+                uint32_t index = m_drawables[record.index];
+
+                if (m_shapes.mesh[index] != mesh)
+                {
+                    mesh = m_shapes.mesh[index];
+                    binds.meshes++;
+                }
+
+                if (!material || memcmp(material, &m_shapes.material[index], sizeof(MaterialData)) != 0)
+                {
+                    material = &m_shapes.material[index];
+                    binds.materials++;
+                }
+            }
+
+            return binds;
+        }
+
+    private:
+        const Shapes & m_shapes;
+        glm::mat4 m_viewProjection;
+        std::vector<uint32_t> m_drawables;
+        RenderQueue m_queue;
+    };
+
+    double GetMilliseconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    std::vector<uint32_t> counts;
+    for (int32_t i = 1; i < argc; ++i)
+        counts.push_back((uint32_t)std::atoi(argv[i]));
+
+    if (counts.empty())
+        counts = { 10000, 50000, 100000 };
+
+    printf("%8s %12s %12s %12s %12s %12s\n", "shapes", "frame [ms]", "build [ms]", "sort [ms]", "mesh binds", "mat. binds");
+
+    for (uint32_t count : counts)
+    {
+        Shapes shapes = CreateShapes(count);
+        Frame frame(shapes);
+
+        for (int32_t i = 0; i < WARMUP_FRAMES; ++i)
+        {
+            frame.Build();
+            frame.Sort();
+            frame.Execute();
+        }
+
+        double build = 0.0;
+        double sort = 0.0;
+        double total = 0.0;
+        Binds binds;
+
+        for (int32_t i = 0; i < MEASURED_FRAMES; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            frame.Build();
+            build += GetMilliseconds(start);
+
+            auto sortStart = std::chrono::steady_clock::now();
+            frame.Sort();
+            sort += GetMilliseconds(sortStart);
+
+            binds = frame.Execute();
+            total += GetMilliseconds(start);
+        }
+
+        printf("%8u %12.3f %12.3f %12.3f %12u %12u\n", count, total / MEASURED_FRAMES, build / MEASURED_FRAMES,
+            sort / MEASURED_FRAMES, binds.meshes, binds.materials);
+        fflush(stdout);
+    }
+
+    return 0;
+}
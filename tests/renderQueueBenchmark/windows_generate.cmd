@@ -0,0 +1,4 @@
+mkdir windows
+cd windows
+cmake -G"Visual Studio 15" ..
+cd ..
\ No newline at end of file
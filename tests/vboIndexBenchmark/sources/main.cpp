@@ -0,0 +1,210 @@
+// Headless benchmark of VboIndex, synthetic meshes are indexed and indexing time is printed
+// for each. Meshes are grids of quads with unshared vertices, like the converter gets them,
+// slightly jittered so that welded vertices aren't bit equal and may lie in different cells.
+// Output of small meshes is compared to the linear search VboIndex used before.
+//
+// usage: vboIndexBenchmark [vertices count ...] (default 1000 10000 100000 1000000)
+
+#include "VboIndexer.h"
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    // vertices of one quad, two triangles
+    const int32_t QUAD_VERTICES = 6;
+    // neighbouring grid vertices are far apart compared to welding distance of VboIndex
+    const float GRID_SPACING = 0.1f;
+    // well below welding distance of VboIndex
+    const float JITTER = 0.002f;
+    // linear search is quadratic, it is run only for meshes up to this size
+    const size_t LINEAR_CHECK_LIMIT = 200000;
+    const int32_t MEASURED_RUNS = 3;
+
+    struct Mesh
+    {
+        std::vector<glm::vec3> vertices;
+        std::vector<glm::vec2> uvs;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec3> tangents;
+        std::vector<glm::vec3> bitangents;
+
+        size_t GetSize() const
+        {
+            return vertices.size();
+        }
+    };
+
+    // wavy grid of at least vertices count, each quad has its own vertices
+    Mesh CreateMesh(size_t count)
+    {
+        size_t quads = (count + QUAD_VERTICES - 1) / QUAD_VERTICES;
+        int32_t side = (int32_t)std::ceil(std::sqrt((double)quads));
+
+        std::mt19937 random((uint32_t)count);
+        std::uniform_real_distribution<float> jitter(-JITTER, JITTER);
+
+        Mesh mesh;
+        mesh.vertices.reserve(quads * QUAD_VERTICES);
+
+        auto addVertex = [&](int32_t x, int32_t z)
+        {
+            float height = std::sin(x * 0.3f) * std::cos(z * 0.2f);
+            glm::vec3 normal = glm::normalize(glm::vec3(-0.3f * std::cos(x * 0.3f) * std::cos(z * 0.2f), 1.0f,
+                0.2f * std::sin(x * 0.3f) * std::sin(z * 0.2f)));
+
+            mesh.vertices.push_back(glm::vec3(x * GRID_SPACING + jitter(random), height + jitter(random), z * GRID_SPACING + jitter(random)));
+            mesh.uvs.push_back(glm::vec2(float(x) / side + jitter(random), float(z) / side + jitter(random)));
+            mesh.normals.push_back(normal);
+            mesh.tangents.push_back(glm::vec3(1.0f, 0.0f, 0.0f));
+            mesh.bitangents.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+        };
+
+        for (size_t quad = 0; quad < quads; ++quad)
+        {
+            int32_t x = int32_t(quad % side);
+            int32_t z = int32_t(quad / side);
+
+            addVertex(x, z);
+            addVertex(x + 1, z);
+            addVertex(x + 1, z + 1);
+
+            addVertex(x, z);
+            addVertex(x + 1, z + 1);
+            addVertex(x, z + 1);
+        }
+
+        return mesh;
+    }
+
+    // VboIndex before the hash grid, searched all vertices added so far
+    IndexingResult VboIndexLinear(const Mesh & mesh)
+    {
+        const float sigma = 0.01f;
+        auto isNear = [sigma](float a, float b)
+        {
+            return std::fabs(a - b) < sigma;
+        };
+
+        IndexingResult result;
+
+        for (size_t i = 0; i < mesh.GetSize(); i++)
+        {
+            const glm::vec3 & vertex = mesh.vertices[i];
+            const glm::vec2 & uv = mesh.uvs[i];
+            const glm::vec3 & normal = mesh.normals[i];
+
+            size_t found = 0;
+            for (; found < result.vertices.size(); found++)
+            {
+                if (isNear(vertex.x, result.vertices[found].x) &&
+                    isNear(vertex.y, result.vertices[found].y) &&
+                    isNear(vertex.z, result.vertices[found].z) &&
+                    isNear(uv.x, result.uvs[found].x) &&
+                    isNear(uv.y, result.uvs[found].y) &&
+                    isNear(normal.x, result.normals[found].x) &&
+                    isNear(normal.y, result.normals[found].y) &&
+                    isNear(normal.z, result.normals[found].z))
+                {
+                    break;
+                }
+            }
+
+            if (found < result.vertices.size())
+            {
+                result.indices.push_back((uint32_t)found);
+                result.tangents[found] += mesh.tangents[i];
+                result.bitangents[found] += mesh.bitangents[i];
+            }
+            else
+            {
+                result.vertices.push_back(vertex);
+                result.uvs.push_back(uv);
+                result.normals.push_back(normal);
+                result.tangents.push_back(mesh.tangents[i]);
+                result.bitangents.push_back(mesh.bitangents[i]);
+                result.indices.push_back((uint32_t)result.vertices.size() - 1);
+            }
+        }
+
+        return result;
+    }
+
+    bool IsSame(const IndexingResult & a, const IndexingResult & b)
+    {
+        return a.indices == b.indices &&
+               a.vertices == b.vertices &&
+               a.uvs == b.uvs &&
+               a.normals == b.normals &&
+               a.tangents == b.tangents &&
+               a.bitangents == b.bitangents;
+    }
+
+    IndexingResult Index(const Mesh & mesh)
+    {
+        return VboIndex(mesh.vertices, mesh.uvs, mesh.normals, mesh.tangents, mesh.bitangents);
+    }
+
+    // best of runs in milliseconds
+    template<class Function>
+    double Measure(Function function)
+    {
+        double best = 0.0;
+        for (int32_t i = 0; i < MEASURED_RUNS; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            function();
+            auto end = std::chrono::steady_clock::now();
+
+            double time = std::chrono::duration<double, std::milli>(end - start).count();
+            if (i == 0 || time < best)
+                best = time;
+        }
+
+        return best;
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    std::vector<size_t> counts;
+    for (int32_t i = 1; i < argc; ++i)
+        counts.push_back((size_t)std::atoll(argv[i]));
+
+    if (counts.empty())
+        counts = { 1000, 10000, 100000, 1000000 };
+
+    printf("%10s %10s %12s %12s %8s\n", "vertices", "indexed", "grid [ms]", "linear [ms]", "check");
+
+    bool failed = false;
+    for (size_t count : counts)
+    {
+        Mesh mesh = CreateMesh(count);
+        IndexingResult result = Index(mesh);
+
+        double time = Measure([&mesh]() { Index(mesh); });
+
+        if (mesh.GetSize() <= LINEAR_CHECK_LIMIT)
+        {
+            IndexingResult expected;
+            double linearTime = Measure([&mesh, &expected]() { expected = VboIndexLinear(mesh); });
+
+            bool same = IsSame(result, expected);
+            failed |= !same;
+
+            printf("%10zu %10zu %12.3f %12.3f %8s\n", mesh.GetSize(), result.vertices.size(), time, linearTime, same ? "ok" : "FAILED");
+        }
+        else
+        {
+            printf("%10zu %10zu %12.3f %12s %8s\n", mesh.GetSize(), result.vertices.size(), time, "-", "-");
+        }
+
+        fflush(stdout);
+    }
+
+    return failed ? 1 : 0;
+}